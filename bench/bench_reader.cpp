@@ -0,0 +1,478 @@
+// Benchmarks for the serial framing and protocol dispatch path.
+//
+// Feeds synthetic (and optionally recorded) line streams through
+// LineFramer, on its own, in front of ELS::HostComms::processLine
+// and in front of the ResponseParser fast path (falling back to
+// processLine for anything it doesn't handle), and reports lines/sec,
+// ns/line and heap allocations per line.
+//
+// Each stream is fed twice: straight into LineFramer::push(), and
+// through a socketpair drained with LineFramer::readFrom() the way
+// the reactor drains the serial port, which adds the write and readv
+// syscalls for every chunk.
+//
+// Synthetic streams are rendered with ELS::FocuserComms, so they use
+// exactly the wire format the firmware speaks. The framed stream
+// carries the same position flood as BinaryFrame frames.
+//
+// usage: rks_c8_bench [raw-capture-file ...]
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+#include "BinaryFrame.hpp"
+#include "FocuserComms.hpp"
+#include "FocuserCommsListener.hpp"
+#include "HostComms.hpp"
+#include "HostCommsListener.hpp"
+#include "LineFramer.hpp"
+#include "MonotonicClock.hpp"
+#include "ResponseParser.hpp"
+
+//
+// Allocation counting
+//
+
+static std::atomic<uint64_t> g_allocs(0);
+
+void *operator new(size_t size)
+{
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    void *p = malloc(size ? size : 1);
+    if (p == 0)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+
+//
+// Stream generation
+//
+
+// Captures the lines FocuserComms writes
+class CaptureWriter : public ELS::CommsWriter
+{
+public:
+    CaptureWriter(std::string *out, bool crlf)
+        : _out(out),
+          _crlf(crlf)
+    {
+    }
+
+    virtual bool writeLine(const char *line)
+    {
+        _out->append(line);
+        _out->append(_crlf ? "\r\n" : "\n");
+        return true;
+    }
+
+    virtual void close() {}
+
+    void setCrlf(bool crlf) { _crlf = crlf; }
+
+private:
+    std::string *_out;
+    bool _crlf;
+};
+
+// FocuserComms needs a listener; the generator never parses
+class NullFocuserListener : public ELS::FocuserCommsListener
+{
+public:
+    virtual void focusRel(ELS::FocusDirection, uint32_t) {}
+    virtual void focusAbs(uint32_t) {}
+    virtual void focusAbort() {}
+    virtual void enableMotor(bool) {}
+    virtual void zero() {}
+    virtual void setMicrostep(ELS::Microsteps) {}
+    virtual void setSpeed(ELS::FocusSpeed) {}
+    virtual void enableBacklash(bool) {}
+    virtual void setBacklashSteps(uint32_t) {}
+    virtual void getMotorEnabled() {}
+    virtual void getPos() {}
+    virtual void getMaxPos() {}
+    virtual void getMicrostep() {}
+    virtual void getSpeed() {}
+    virtual void getBacklashEnabled() {}
+    virtual void getBacklashSteps() {}
+};
+
+static std::string positionFlood(int lines)
+{
+    std::string out;
+    NullFocuserListener listener;
+    CaptureWriter writer(&out, true);
+    ELS::FocuserComms comms(&writer, &listener);
+
+    comms.movingAbs(0, lines * 10);
+    for (int i = 0; i < lines; i++)
+    {
+        comms.position(i * 10);
+    }
+    comms.stopped(lines * 10);
+
+    return out;
+}
+
+static std::string positionFrames(int lines)
+{
+    std::string out;
+    uint8_t frame[BinaryFrame::g_maxFrame];
+
+    for (int i = 0; i < lines; i++)
+    {
+        size_t len = BinaryFrame::encodeValue(BinaryFrame::FT_POSITION, i * 10, frame, sizeof(frame));
+        out.append((const char *)frame, len);
+    }
+    size_t len = BinaryFrame::encodeValue(BinaryFrame::FT_STOPPED, lines * 10, frame, sizeof(frame));
+    out.append((const char *)frame, len);
+
+    return out;
+}
+
+static std::string mixedEndings(int lines)
+{
+    std::string out;
+    NullFocuserListener listener;
+    CaptureWriter writer(&out, true);
+    ELS::FocuserComms comms(&writer, &listener);
+
+    for (int i = 0; i < lines; i++)
+    {
+        writer.setCrlf((i & 1) == 0);
+        switch (i % 4)
+        {
+        case 0:
+            comms.position(i);
+            break;
+        case 1:
+            comms.speed(ELS::FS_X3);
+            break;
+        case 2:
+            comms.microsteps(ELS::MS_X16);
+            break;
+        default:
+            comms.backlashSteps(i);
+            break;
+        }
+    }
+
+    return out;
+}
+
+static std::string overlongLines(int lines, size_t maxLineLen)
+{
+    std::string out;
+    NullFocuserListener listener;
+    CaptureWriter writer(&out, true);
+    ELS::FocuserComms comms(&writer, &listener);
+
+    // One garbage line past the framer limit for every nine good ones
+    std::string garbage(maxLineLen + 64, 'x');
+    for (int i = 0; i < lines; i++)
+    {
+        if ((i % 10) == 9)
+        {
+            out.append(garbage);
+            out.append("\r\n");
+        }
+        else
+        {
+            comms.position(i);
+        }
+    }
+
+    return out;
+}
+
+static bool readFile(const char *path, std::string *out)
+{
+    FILE *fp = fopen(path, "rb");
+    if (fp == 0)
+    {
+        return false;
+    }
+
+    char buf[65536];
+    size_t n = 0;
+    while ((n = fread(buf, 1, sizeof(buf), fp)) > 0)
+    {
+        out->append(buf, n);
+    }
+    fclose(fp);
+
+    return true;
+}
+
+//
+// Sinks
+//
+
+class NullHostListener : public ELS::HostCommsListener
+{
+public:
+    virtual void movingRel(ELS::FocusDirection, uint32_t) {}
+    virtual void movingAbs(uint32_t, uint32_t) {}
+    virtual void stopped(uint32_t) {}
+    virtual void motorEnabled(bool) {}
+    virtual void zeroed() {}
+    virtual void position(uint32_t) {}
+    virtual void microsteps(ELS::Microsteps) {}
+    virtual void maxPos(uint32_t) {}
+    virtual void speed(ELS::FocusSpeed) {}
+    virtual void backlashEnabled(bool) {}
+    virtual void backlashSteps(uint32_t) {}
+};
+
+class NullWriter : public ELS::CommsWriter
+{
+public:
+    virtual bool writeLine(const char *) { return true; }
+    virtual void close() {}
+};
+
+class Sink : public LineFramer::Listener
+{
+public:
+    Sink(ELS::HostComms *comms,
+         const ResponseParser *parser,
+         ELS::HostCommsListener *listener)
+        : lines(0),
+          overflows(0),
+          _comms(comms),
+          _parser(parser),
+          _listener(listener)
+    {
+    }
+
+    virtual void lineReceived(char *line, size_t len) override
+    {
+        lines++;
+        if ((_parser != 0) && _parser->dispatch(line, len, _listener))
+        {
+            return;
+        }
+
+        if (_comms != 0)
+        {
+            _comms->processLine(line);
+        }
+    }
+
+    virtual void lineOverflow(size_t) override
+    {
+        overflows++;
+    }
+
+    virtual void frameReceived(uint8_t type, const uint8_t *payload, size_t len) override
+    {
+        lines++;
+        if (_comms != 0)
+        {
+            BinaryFrame::dispatch(type, payload, len, _listener);
+        }
+    }
+
+    virtual void frameCorrupt() override
+    {
+        overflows++;
+    }
+
+    uint64_t lines;
+    uint64_t overflows;
+
+private:
+    ELS::HostComms *_comms;
+    const ResponseParser *_parser;
+    ELS::HostCommsListener *_listener;
+};
+
+//
+// Runner
+//
+
+static const uint64_t g_minRunNs = 500000000ULL;
+
+enum Path
+{
+    P_FRAME,
+    P_DISPATCH,
+    P_FASTPATH,
+    P_COUNT
+};
+
+static const char *g_pathNames[P_COUNT] = {"frame", "dispatch", "fastpath"};
+
+enum Feed
+{
+    F_PUSH,
+    F_READ,
+    F_COUNT
+};
+
+static const char *g_feedNames[F_COUNT] = {"push", "read"};
+
+// Passes the whole stream through framer once, chunk bytes at a time
+static bool feed(LineFramer *framer, const std::string &stream, size_t chunk, int *sv)
+{
+    for (size_t off = 0; off < stream.size(); off += chunk)
+    {
+        size_t len = stream.size() - off;
+        if (len > chunk)
+        {
+            len = chunk;
+        }
+
+        if (sv == 0)
+        {
+            framer->push(stream.data() + off, len);
+            continue;
+        }
+
+        if (write(sv[1], stream.data() + off, len) != (ssize_t)len)
+        {
+            return false;
+        }
+        size_t done = 0;
+        while (done < len)
+        {
+            ssize_t n = framer->readFrom(sv[0]);
+            if (n <= 0)
+            {
+                return false;
+            }
+            done += n;
+        }
+    }
+
+    return true;
+}
+
+static void run(const char *name,
+                const std::string &stream,
+                size_t chunk,
+                Path path,
+                Feed how,
+                bool framed)
+{
+    NullHostListener listener;
+    NullWriter writer;
+    ELS::HostComms comms(&writer, &listener);
+    ResponseParser parser;
+    parser.learn();
+    Sink sink((path != P_FRAME) ? &comms : 0,
+              (path == P_FASTPATH) ? &parser : 0,
+              &listener);
+    LineFramer framer(&sink);
+    framer.setFramed(framed);
+
+    int sv[2] = {-1, -1};
+    if ((how == F_READ) && (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0))
+    {
+        fprintf(stderr, "socketpair failed\n");
+        return;
+    }
+    int *port = (how == F_READ) ? sv : 0;
+
+    // Warm up
+    bool ok = feed(&framer, stream, chunk, port);
+    sink.lines = 0;
+    sink.overflows = 0;
+
+    uint64_t allocsBefore = g_allocs.load();
+    uint64_t startNs = monotonicNs();
+    uint64_t elapsedNs = 0;
+    do
+    {
+        ok = ok && feed(&framer, stream, chunk, port);
+        elapsedNs = monotonicNs() - startNs;
+    } while (ok && (elapsedNs < g_minRunNs));
+    uint64_t allocs = g_allocs.load() - allocsBefore;
+
+    if (how == F_READ)
+    {
+        close(sv[0]);
+        close(sv[1]);
+    }
+
+    if (!ok)
+    {
+        fprintf(stderr, "%s: socketpair I/O failed\n", name);
+        return;
+    }
+
+    double lines = (sink.lines > 0) ? (double)sink.lines : 1.0;
+    printf("%-28s %-9s %-5s %6zu %12.0f %9.1f %10.3f %10llu\n",
+           name,
+           g_pathNames[path],
+           g_feedNames[how],
+           chunk,
+           lines / (elapsedNs / 1e9),
+           elapsedNs / lines,
+           allocs / lines,
+           (unsigned long long)sink.overflows);
+}
+
+static void runAll(const char *name, const std::string &stream, bool framed = false)
+{
+    static const size_t chunks[] = {4096, 64, 1};
+
+    for (int f = 0; f < F_COUNT; f++)
+    {
+        for (size_t i = 0; i < sizeof(chunks) / sizeof(chunks[0]); i++)
+        {
+            // Two syscalls per byte measures nothing but the syscalls
+            if ((f == F_READ) && (chunks[i] == 1))
+            {
+                continue;
+            }
+
+            for (int p = 0; p < P_COUNT; p++)
+            {
+                run(name, stream, chunks[i], (Path)p, (Feed)f, framed);
+            }
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    printf("%-28s %-9s %-5s %6s %12s %9s %10s %10s\n",
+           "stream", "path", "feed", "chunk", "lines/s", "ns/line", "allocs/line", "overflows");
+
+    runAll("position flood", positionFlood(100000));
+    runAll("position flood (framed)", positionFrames(100000), true);
+    runAll("mixed CR/LF and LF", mixedEndings(100000));
+    runAll("overlong lines", overlongLines(100000, LineFramer::g_defaultMaxLineLen));
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string recorded;
+        if (!readFile(argv[i], &recorded))
+        {
+            fprintf(stderr, "unable to read %s\n", argv[i]);
+            return 1;
+        }
+        runAll(argv[i], recorded);
+    }
+
+    return 0;
+}
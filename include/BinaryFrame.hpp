@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ELS
+{
+    class HostCommsListener;
+}
+
+// Compact framing for controller telemetry.
+//
+// Once negotiated, the controller sends everything as frames instead
+// of text lines:
+//
+//   0xA5 | len | type | payload (len - 1 bytes) | CRC-16 (big endian)
+//
+// where len counts the type byte and payload, and the CRC
+// (CCITT-FALSE) covers len through the end of the payload. The
+// single-number reports carry their value as an unsigned LEB128
+// varint, so a position report is 6 to 10 bytes instead of a 15 to 20
+// byte line. Every other report is wrapped unchanged in an FT_LINE
+// frame and goes through HostComms as before.
+//
+// Negotiation is a pair of text lines. The host sends
+// g_requestBinary (or g_requestAscii) and a controller that supports
+// framing answers with the matching ack line, after which its output
+// is framed (or plain text). The ack is always plain text, even from
+// a controller that is already framed; negotiation lines start with
+// g_textMark, which LineFramer looks for between frames. Firmware
+// that doesn't know the request ignores it and the link stays in
+// text mode. Commands from the host are always text lines.
+class BinaryFrame
+{
+public:
+    enum Type
+    {
+        FT_LINE = 0,
+        FT_POSITION,
+        FT_STOPPED,
+        FT_MAX_POS,
+        FT_BACKLASH_STEPS
+    };
+
+public:
+    // Writes a complete frame into out and returns its size, or 0 if
+    // out is too small or the payload too long
+    static size_t encode(Type type,
+                         const uint8_t *payload,
+                         size_t len,
+                         uint8_t *out,
+                         size_t outSize);
+    static size_t encodeValue(Type type, uint32_t value, uint8_t *out, size_t outSize);
+
+    // Delivers a received frame body to listener; returns false for
+    // FT_LINE (which the caller handles) and malformed frames
+    static bool dispatch(uint8_t type,
+                         const uint8_t *payload,
+                         size_t len,
+                         ELS::HostCommsListener *listener);
+
+    static size_t putVarint(uint32_t value, uint8_t *out);
+    static bool getVarint(const uint8_t *p, size_t len, uint32_t *value);
+
+    static uint16_t crc16(const uint8_t *p, size_t len, uint16_t crc = 0xffff);
+
+public:
+    static const uint8_t g_sync = 0xa5;
+
+    // Type byte plus payload
+    static const size_t g_maxBody = 255;
+
+    // Sync, length and CRC
+    static const size_t g_overhead = 4;
+    static const size_t g_maxFrame = g_maxBody + g_overhead;
+
+    static const size_t g_maxVarint = 5;
+
+    // First character of every negotiation line
+    static const char g_textMark = '#';
+
+    static const char *const g_requestBinary;
+    static const char *const g_requestAscii;
+    static const char *const g_ackBinary;
+    static const char *const g_ackAscii;
+};
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <pthread.h>
+
+#include "BinaryFrame.hpp"
+#include "CommsWriter.hpp"
+#include "FocuserComms.hpp"
+#include "FocuserCommsListener.hpp"
+#include "LineFramer.hpp"
+
+// Simulated C8 focus controller.
+//
+// Runs the firmware side of the ELS line protocol (ELS::FocuserComms)
+// on its own thread behind one end of a socketpair, so the driver's
+// real reader, writer and HostComms code can be exercised end to end
+// without hardware. Motion is modelled with a step pulse rate for
+// each microstep setting, tripled at FS_X3, firmware backlash on
+// direction reversal and a clamp to the maximum position. Coarser
+// microsteps pulse more slowly but still cover more ground per
+// second, and the step counter is not rescaled when the microstep
+// setting changes.
+//
+// The simulator also speaks the optional BinaryFrame telemetry
+// framing once the host asks for it.
+class C8Simulator : public ELS::FocuserCommsListener,
+                    private LineFramer::Listener
+{
+public:
+    C8Simulator();
+    virtual ~C8Simulator();
+
+    // Starts the simulator thread; returns the host end of the
+    // link (owned by the caller) or -1 on failure
+    int start();
+    void stop();
+
+    // Step pulses per second at FS_NORMAL for one microstep
+    // setting; FS_X3 runs three times faster
+    void setStepRate(ELS::Microsteps ms, uint32_t stepsPerSec);
+
+    // FocuserCommsListener
+    virtual void focusRel(ELS::FocusDirection dir, uint32_t steps) override;
+    virtual void focusAbs(uint32_t position) override;
+    virtual void focusAbort() override;
+    virtual void enableMotor(bool enable) override;
+    virtual void zero() override;
+    virtual void setMicrostep(ELS::Microsteps ms) override;
+    virtual void setSpeed(ELS::FocusSpeed speed) override;
+    virtual void enableBacklash(bool enable) override;
+    virtual void setBacklashSteps(uint32_t steps) override;
+    virtual void getMotorEnabled() override;
+    virtual void getPos() override;
+    virtual void getMaxPos() override;
+    virtual void getMicrostep() override;
+    virtual void getSpeed() override;
+    virtual void getBacklashEnabled() override;
+    virtual void getBacklashSteps() override;
+
+public:
+    static const uint32_t g_defaultMaxPos = 2048000;
+    static const uint32_t g_defaultBacklashSteps = 650;
+
+private:
+    class SimWriter : public ELS::CommsWriter
+    {
+    public:
+        SimWriter(C8Simulator *parent);
+
+        virtual bool writeLine(const char *line);
+        virtual void close();
+
+        bool writeValue(BinaryFrame::Type type, uint32_t value);
+
+    private:
+        C8Simulator *_parent;
+        uint8_t _buffer[1024];
+    };
+    friend class SimWriter;
+
+private:
+    // LineFramer::Listener
+    virtual void lineReceived(char *line, size_t len) override;
+    virtual void lineOverflow(size_t droppedBytes) override;
+
+    void simThread();
+    void beginMove(uint32_t target);
+    void advance(uint64_t nowNs);
+    uint32_t currentRate() const;
+
+    // Sends a single-number report, framed when negotiated
+    void report(BinaryFrame::Type type, uint32_t value);
+
+    static void *simThreadRedirect(void *obj);
+
+private:
+    static const int g_tickMs = 10;
+    static const int g_positionReportMs = 50;
+
+private:
+    int _fd;
+    int _hostFd;
+    int _pipefd[2];
+    pthread_t _threadHandle;
+    std::atomic<bool> _running;
+
+    SimWriter _writer;
+    ELS::FocuserComms _comms;
+    LineFramer _framer;
+    bool _framed;
+
+    // Indexed by Microsteps - 1
+    std::atomic<uint32_t> _stepRate[4];
+
+    // Controller state (simulator thread only)
+    uint32_t _position;
+    uint32_t _maxPos;
+    ELS::Microsteps _microsteps;
+    ELS::FocusSpeed _speed;
+    bool _motorEnabled;
+    bool _backlashEnabled;
+    uint32_t _backlashSteps;
+
+    // Motion
+    bool _moving;
+    uint32_t _target;
+    ELS::FocusDirection _lastDir;
+    double _backlashRemaining;
+    double _stepAccum;
+    uint64_t _lastTickNs;
+    uint64_t _lastReportNs;
+};
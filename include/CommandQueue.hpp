@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+class TrafficCapture;
+
+// Outbound command queue for the serial link.
+//
+// Producers (any thread) push formatted command lines; the I/O
+// thread flushes everything queued so far with a single writev(),
+// so commands issued in the same tick share one syscall. Partial
+// writes and EAGAIN on non-blocking fds are carried over to the
+// next flush.
+//
+// A line pushed with a non-zero key replaces an unsent line with
+// the same key instead of queuing behind it (e.g. a new focusAbs
+// target supersedes one that never made it onto the wire). The new
+// line always ends up after everything pushed before it: it takes
+// the old line's place only when that line is the last one queued,
+// otherwise the old line is dropped. When the queue is full, push()
+// waits for space up to a timeout and then rejects the line.
+class CommandQueue
+{
+public:
+    struct Stats
+    {
+        std::atomic<uint64_t> linesQueued;
+        std::atomic<uint64_t> linesWritten;
+        std::atomic<uint64_t> bytesWritten;
+        std::atomic<uint64_t> writeCalls;
+        std::atomic<uint64_t> partialWrites;
+        std::atomic<uint64_t> wouldBlock;
+        std::atomic<uint64_t> superseded;
+        std::atomic<uint64_t> rejected;
+    };
+
+public:
+    CommandQueue();
+    ~CommandQueue();
+
+    CommandQueue(const CommandQueue &) = delete;
+    CommandQueue &operator=(const CommandQueue &) = delete;
+
+    bool open();
+    void close();
+
+    // Appends CR/LF to line and queues it. Any thread. superseded
+    // is set if the line replaced an unsent one with the same key.
+    bool push(const char *line,
+              uint8_t key = 0,
+              int timeoutMs = g_defaultPushTimeoutMs,
+              bool *superseded = 0);
+
+    // While held, pushes do not wake the I/O thread so that
+    // everything queued in between goes out in one write
+    void hold();
+    void release();
+
+    // I/O thread: writes as much as the fd will take, recording the
+    // bytes written to capture if it is running. Returns false on a
+    // hard write error; check hasPending() to see whether the caller
+    // should wait for the fd to become writable.
+    bool flush(int fd, TrafficCapture *capture = 0);
+
+    // I/O thread: consumes wakeups from notifyFd()
+    void clearNotify();
+
+    bool hasPending() const;
+
+    // Waits until every queued line has been written
+    bool waitEmpty(int timeoutMs);
+
+    // Becomes readable when there is something to flush
+    int notifyFd() const { return _pipefd[0]; }
+
+    const Stats &stats() const { return _stats; }
+
+public:
+    static const int g_defaultPushTimeoutMs = 250;
+    static const size_t g_maxLineLen = 126;
+
+private:
+    void notify();
+
+private:
+    static const size_t g_maxEntries = 64;
+
+    struct Entry
+    {
+        char data[g_maxLineLen + 2];
+        uint16_t len;
+        uint8_t key;
+    };
+
+private:
+    mutable std::mutex _mutex;
+    std::condition_variable _spaceCond;
+    Entry _entries[g_maxEntries];
+
+    // Monotonic entry indices; entries in [_head, _head + _inFlight)
+    // are being written by the I/O thread and must not be replaced
+    uint64_t _head;
+    uint64_t _tail;
+    size_t _inFlight;
+
+    // Bytes of the head entry already written
+    size_t _offset;
+
+    int _holdCount;
+    bool _notifyPending;
+    int _pipefd[2];
+
+    Stats _stats;
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Best focus positions remembered per filter slot and temperature.
+//
+// Temperatures are grouped into bins of a configurable width; each
+// (filter, bin) keeps a running mean of the positions recorded for
+// it, weighted towards recent results. A NaN temperature means no
+// temperature source, and is kept in its own bin. predict() returns
+// the entry for the exact bin, or interpolates linearly between the
+// nearest bins either side for the same filter. With bins on one side
+// only, the nearest is returned if it is within g_maxNearestBins;
+// there is no extrapolation.
+//
+// The table is saved as one text line per entry with the bin centre
+// temperature, so it survives a change of bin width.
+class FocusCache
+{
+public:
+    FocusCache();
+
+    void setBinWidth(double degrees);
+    double binWidth() const { return _binWidth; }
+
+    bool load(const char *path);
+    bool save(const char *path) const;
+
+    bool record(int filter, double tempC, uint32_t position);
+    bool predict(int filter, double tempC, uint32_t *position) const;
+
+    void clear() { _count = 0; }
+    size_t size() const { return _count; }
+
+    // Entry i as its bin centre temperature (NaN for no temperature)
+    void entry(size_t i, int *filter, double *tempC, uint32_t *position, uint16_t *samples) const;
+
+public:
+    static const size_t g_maxEntries = 256;
+
+    // Results beyond this many stop diluting newer ones
+    static const uint16_t g_maxWeight = 4;
+
+    // How far predict() looks for a bin when there are none on the
+    // other side of the temperature
+    static const int16_t g_maxNearestBins = 1;
+
+private:
+    struct Entry
+    {
+        int16_t filter;
+        int16_t bin;
+        uint32_t position;
+        uint16_t samples;
+    };
+
+private:
+    int16_t binOf(double tempC) const;
+    double binCentre(int16_t bin) const;
+
+    Entry *find(int filter, int16_t bin);
+    bool merge(int filter, int16_t bin, uint32_t position, uint16_t samples);
+
+private:
+    static const int16_t g_noTempBin = INT16_MIN;
+
+private:
+    Entry _entries[g_maxEntries];
+    size_t _count;
+    double _binWidth;
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Log2-bucketed latency histogram in microseconds.
+//
+// Bucket i counts samples in [2^i, 2^(i+1)) us, with bucket 0 also
+// taking anything under 1 us. Updates use relaxed atomics so one
+// thread can record while another reads.
+class LatencyHistogram
+{
+public:
+    static const int g_bucketCount = 25;
+
+public:
+    LatencyHistogram();
+
+    void record(uint64_t us);
+    void reset();
+
+    uint64_t count() const { return _count.load(std::memory_order_relaxed); }
+    uint64_t sumUs() const { return _sumUs.load(std::memory_order_relaxed); }
+    uint64_t maxUs() const { return _maxUs.load(std::memory_order_relaxed); }
+    uint64_t bucket(int idx) const { return _buckets[idx].load(std::memory_order_relaxed); }
+
+    double meanUs() const;
+
+    // Upper bound of the bucket containing the given percentile
+    // (0..100); 0 if there are no samples
+    uint64_t percentileUs(double pct) const;
+
+private:
+    std::atomic<uint64_t> _count;
+    std::atomic<uint64_t> _sumUs;
+    std::atomic<uint64_t> _maxUs;
+    std::atomic<uint64_t> _buckets[g_bucketCount];
+};
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <sys/types.h>
+
+// Splits a byte stream into LF or CR/LF terminated lines.
+//
+// Bytes are read straight into a power-of-two ring buffer and
+// delimiters are located with memchr, so a line is normally handed
+// to the listener in place without being copied. Only a line that
+// wraps around the end of the ring is linearized into a scratch
+// buffer. A partial line that grows past maxLineLen is discarded
+// up to the next delimiter and reported through lineOverflow().
+//
+// After setFramed(true) the same ring is decoded as BinaryFrame
+// frames instead. FT_LINE frames still arrive through lineReceived()
+// and everything else through frameReceived(); a frame that fails its
+// length or CRC check is reported through frameCorrupt() and the
+// framer resyncs on the next sync byte. A plain text line starting
+// with BinaryFrame::g_textMark between frames (a negotiation ack) is
+// still delivered through lineReceived(). The mode may be switched
+// from inside a listener callback and applies from the next byte on.
+//
+// LineFramer has no dependencies on INDI or the comms layer so it
+// can be exercised on its own.
+class LineFramer
+{
+public:
+    class Listener
+    {
+    public:
+        virtual ~Listener() = default;
+
+        // line is NUL terminated (delimiter stripped) and only
+        // valid for the duration of the call
+        virtual void lineReceived(char *line, size_t len) = 0;
+
+        // called once for each line that was discarded because it
+        // exceeded maxLineLen; droppedBytes is the number of bytes
+        // thrown away when the overflow was detected
+        virtual void lineOverflow(size_t droppedBytes) = 0;
+
+        // Framed mode only; payload is only valid for the duration
+        // of the call
+        virtual void frameReceived(uint8_t, const uint8_t *, size_t) {}
+        virtual void frameCorrupt() {}
+    };
+
+public:
+    LineFramer(Listener *listener,
+               size_t capacity = g_defaultCapacity,
+               size_t maxLineLen = g_defaultMaxLineLen);
+    ~LineFramer();
+
+    LineFramer(const LineFramer &) = delete;
+    LineFramer &operator=(const LineFramer &) = delete;
+
+    // Reads whatever is available on fd into the ring and delivers
+    // all complete lines. Returns the result of the underlying
+    // readv() call, so 0 means EOF and -1 means check errno.
+    ssize_t readFrom(int fd);
+
+    // Copies len bytes into the ring, delivering lines as they
+    // complete. Always consumes all of data.
+    void push(const char *data, size_t len);
+
+    // Throws away any buffered partial line
+    void reset();
+
+    void setFramed(bool framed);
+    bool framed() const { return _framed; }
+
+    size_t capacity() const { return _capacity; }
+    size_t maxLineLen() const { return _maxLineLen; }
+    size_t pending() const { return (size_t)(_tail - _head); }
+
+    uint64_t lineCount() const { return _lineCount; }
+    uint64_t overflowCount() const { return _overflowCount; }
+    uint64_t frameCount() const { return _frameCount; }
+    uint64_t corruptCount() const { return _corruptCount; }
+
+public:
+    static const size_t g_defaultCapacity = 4096;
+    static const size_t g_defaultMaxLineLen = 1023;
+
+private:
+    void frame();
+    void deliver(uint64_t lineEnd);
+
+    // Delivers the frame at the head; false if it isn't complete yet
+    bool deframe();
+
+    // Delivers a negotiation line at the head in framed mode; false
+    // if it isn't complete yet
+    bool textLine();
+
+private:
+    Listener *_listener;
+    size_t _capacity;
+    size_t _mask;
+    size_t _maxLineLen;
+
+    // _capacity + 1 bytes; the extra byte lets a line that ends
+    // exactly at the end of the ring be NUL terminated in place
+    char *_ring;
+
+    // Big enough for a maximum length line or frame
+    char *_scratch;
+
+    // Monotonic stream offsets; masked to index the ring
+    uint64_t _head;
+    uint64_t _scan;
+    uint64_t _tail;
+
+    bool _discarding;
+    bool _framed;
+
+    uint64_t _lineCount;
+    uint64_t _overflowCount;
+    uint64_t _frameCount;
+    uint64_t _corruptCount;
+};
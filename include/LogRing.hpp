@@ -0,0 +1,162 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "SpscQueue.hpp"
+
+// Deferred, allocation-free logging for the reader thread.
+//
+// post() records the format string pointer and the raw arguments in
+// a preallocated SPSC ring and never formats or touches the INDI
+// logger; the main loop drains the ring, formats each record and
+// hands it to a Sink. Format strings must be string literals; at
+// most one string argument is copied (truncated to g_maxText bytes)
+// since the caller's buffer is not stable.
+//
+// Each category has its own verbosity so high-rate traces can be
+// switched off at runtime; disabled records cost one relaxed load.
+class LogRing
+{
+public:
+    enum Level
+    {
+        LL_OFF = 0,
+        LL_ERROR,
+        LL_WARN,
+        LL_INFO,
+        LL_DEBUG
+    };
+
+    enum Category
+    {
+        LC_COMMS,
+        LC_MOTION,
+        LC_POSITION,
+        LC_COUNT
+    };
+
+    class Sink
+    {
+    public:
+        virtual ~Sink() = default;
+
+        virtual void logRecord(Level level, Category category, const char *msg) = 0;
+    };
+
+public:
+    LogRing();
+    ~LogRing();
+
+    LogRing(const LogRing &) = delete;
+    LogRing &operator=(const LogRing &) = delete;
+
+    bool open();
+    void close();
+
+    // Becomes readable when records are waiting
+    int notifyFd() const { return _pipefd[0]; }
+
+    void setLevel(Category category, Level level);
+    Level level(Category category) const;
+    bool enabled(Category category, Level level) const
+    {
+        return level <= _levels[category].load(std::memory_order_relaxed);
+    }
+
+    // Producer side (one thread)
+    template <typename... Args>
+    void post(Level level, Category category, const char *fmt, Args... args)
+    {
+        static_assert(sizeof...(Args) <= g_maxArgs, "too many log arguments");
+
+        if (!enabled(category, level))
+        {
+            return;
+        }
+
+        Record rec;
+        rec.fmt = fmt;
+        rec.level = (uint8_t)level;
+        rec.category = (uint8_t)category;
+        rec.argc = 0;
+        rec.text[0] = 0;
+        setArgs(rec, args...);
+
+        push(rec);
+    }
+
+    // Consumer side; formats and emits every waiting record
+    void drain(Sink *sink);
+
+    uint64_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+public:
+    static const size_t g_maxArgs = 4;
+    static const size_t g_maxText = 64;
+
+private:
+    struct Arg
+    {
+        enum Type
+        {
+            AT_INT,
+            AT_UINT,
+            AT_DOUBLE,
+            AT_TEXT
+        };
+
+        Type type;
+        union
+        {
+            long long i;
+            unsigned long long u;
+            double d;
+        };
+    };
+
+    struct Record
+    {
+        const char *fmt;
+        uint8_t level;
+        uint8_t category;
+        uint8_t argc;
+        Arg args[g_maxArgs];
+        char text[g_maxText];
+    };
+
+private:
+    static void setArgs(Record &) {}
+
+    template <typename T, typename... Rest>
+    static void setArgs(Record &rec, T first, Rest... rest)
+    {
+        setArg(rec.args[rec.argc], rec, first);
+        rec.argc++;
+        setArgs(rec, rest...);
+    }
+
+    static void setArg(Arg &arg, Record &, int v) { arg.type = Arg::AT_INT; arg.i = v; }
+    static void setArg(Arg &arg, Record &, long v) { arg.type = Arg::AT_INT; arg.i = v; }
+    static void setArg(Arg &arg, Record &, long long v) { arg.type = Arg::AT_INT; arg.i = v; }
+    static void setArg(Arg &arg, Record &, unsigned v) { arg.type = Arg::AT_UINT; arg.u = v; }
+    static void setArg(Arg &arg, Record &, unsigned long v) { arg.type = Arg::AT_UINT; arg.u = v; }
+    static void setArg(Arg &arg, Record &, unsigned long long v) { arg.type = Arg::AT_UINT; arg.u = v; }
+    static void setArg(Arg &arg, Record &, double v) { arg.type = Arg::AT_DOUBLE; arg.d = v; }
+    static void setArg(Arg &arg, Record &rec, const char *v);
+
+    void push(const Record &rec);
+
+    static void format(const Record &rec, char *buf, size_t len);
+
+private:
+    static const size_t g_queueSize = 256;
+
+private:
+    SpscQueue<Record, g_queueSize> _queue;
+    std::atomic<int> _levels[LC_COUNT];
+    std::atomic<bool> _wakeupPending;
+    std::atomic<uint64_t> _dropped;
+    int _pipefd[2];
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "LatencyHistogram.hpp"
+
+// Monotonic event counter; relaxed so it is cheap on the hot path
+class MetricCounter
+{
+public:
+    MetricCounter()
+        : _value(0)
+    {
+    }
+
+    void add(uint64_t n = 1) { _value.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t get() const { return _value.load(std::memory_order_relaxed); }
+    void reset() { _value.store(0, std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> _value;
+};
+
+// Driver hot-path instrumentation. Written from the reader thread
+// and the main loop, read by the main loop when the Diagnostics
+// properties are refreshed.
+struct Metrics
+{
+    // Serial link (reader thread)
+    MetricCounter bytesRead;
+    MetricCounter linesParsed;
+    MetricCounter linesDropped;
+    MetricCounter eventsDropped;
+
+    // Event delivery (main loop)
+    MetricCounter eventsDispatched;
+    MetricCounter publishes;
+    LatencyHistogram dispatchTime;
+
+    // Command round trips across all command types
+    LatencyHistogram roundTrip;
+
+    void reset()
+    {
+        bytesRead.reset();
+        linesParsed.reset();
+        linesDropped.reset();
+        eventsDropped.reset();
+        eventsDispatched.reset();
+        publishes.reset();
+        dispatchTime.reset();
+        roundTrip.reset();
+    }
+};
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <time.h>
+
+// Nanoseconds from CLOCK_MONOTONIC; served from the vDSO on Linux so
+// it is cheap enough for the reader thread's hot path
+inline uint64_t monotonicNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Nanoseconds since the epoch from CLOCK_REALTIME; also a vDSO call,
+// for timestamps that have to line up with other records
+inline uint64_t realtimeNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
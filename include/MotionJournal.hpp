@@ -0,0 +1,115 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Fixed-size journal of motion and state events, kept in a
+// memory-mapped ring file for analysis after the session.
+//
+// The reader thread appends a record with plain stores into the
+// mapping, followed by a release store of the header's record count;
+// no system calls are made. The main loop also appends the odd
+// record, so appends are serialised by a spinlock held only for
+// those stores. Once the ring is full the oldest records are
+// overwritten. Each record carries the low bits of its own index,
+// written last, so a reader can tell a record that was being
+// overwritten while it looked from a good one.
+// The kernel writes dirty pages back on its own schedule and the
+// mapping is synced when the journal is closed.
+//
+// Times are CLOCK_REALTIME so they can be matched against image
+// timestamps. Positions are in controller steps as reported. The
+// driver's position is offset + steps * (64 / microsteps), using the
+// latest JE_OFFSET and JE_MICROSTEPS records; the driver journals
+// the offset whenever it changes.
+//
+// The file is fully allocated when opened, so a full filesystem
+// fails open() rather than faulting a later store into the mapping.
+class MotionJournal
+{
+public:
+    enum EventType
+    {
+        JE_OPEN = 1,
+        JE_MOVING_REL,
+        JE_MOVING_ABS,
+        JE_STOPPED,
+        JE_POSITION,
+        JE_ZEROED,
+        JE_MICROSTEPS,
+        JE_BACKLASH_ENABLED,
+        JE_BACKLASH_STEPS,
+        JE_OFFSET
+    };
+
+    struct Record
+    {
+        uint64_t timeNs;
+        uint32_t seq;
+        uint16_t type;
+        uint16_t reserved;
+
+        // JE_MOVING_REL: direction (0 inward, 1 outward), steps
+        // JE_MOVING_ABS: from, to
+        // JE_MICROSTEPS: microsteps per full step
+        // JE_BACKLASH_ENABLED: 0 or 1
+        // JE_OFFSET: signed 64-bit offset, low half in a
+        // everything else: position or steps in a
+        uint32_t a;
+        uint32_t b;
+    };
+
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t recordSize;
+        uint64_t capacity;
+
+        // Records ever appended; the next one goes in slot
+        // count % capacity
+        uint64_t count;
+
+        uint8_t reserved[32];
+    };
+
+public:
+    MotionJournal();
+    ~MotionJournal();
+
+    MotionJournal(const MotionJournal &) = delete;
+    MotionJournal &operator=(const MotionJournal &) = delete;
+
+    // Opens path for appending, keeping its contents if the layout
+    // matches and starting a fresh ring otherwise
+    bool open(const char *path, size_t capacity = g_defaultCapacity);
+
+    bool openReadOnly(const char *path);
+    void close();
+
+    bool isOpen() const { return _header != nullptr; }
+
+    // Any thread; a no-op while closed
+    void append(EventType type, uint32_t a = 0, uint32_t b = 0);
+
+    // Indexes of the oldest and one past the newest record held
+    uint64_t first() const;
+    uint64_t end() const;
+
+    // False if the record has been overwritten (or is being)
+    bool read(uint64_t index, Record *rec) const;
+
+    static const char *eventName(uint16_t type);
+
+public:
+    static const size_t g_defaultCapacity = 65536;
+    static const uint32_t g_version = 1;
+
+private:
+    Header *_header;
+    Record *_records;
+    size_t _mapSize;
+    bool _writable;
+    std::atomic<bool> _appending;
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+
+// Kinematic model of a single focuser move.
+//
+// A move from one position to another follows a trapezoidal velocity
+// profile (constant acceleration up to the step rate, cruise, then
+// constant deceleration), optionally preceded by dead travel while
+// backlash is taken up. The model extrapolates the position at any
+// time and the time left until arrival. Whenever a real position
+// report arrives the profile is shifted in time so that it passes
+// through the reported position, so prediction errors do not
+// accumulate over a long move.
+class MotionModel
+{
+public:
+    MotionModel();
+
+    // Step rate in steps/s and acceleration in steps/s^2; an
+    // acceleration of 0 means the step rate is reached instantly
+    void setProfile(double stepRate, double accel);
+
+    double stepRate() const { return _rate; }
+    double accel() const { return _accel; }
+
+    void start(uint32_t from,
+               uint32_t to,
+               uint64_t nowNs,
+               uint32_t deadSteps = 0);
+    void correct(uint32_t position, uint64_t nowNs);
+    void stop(uint32_t position);
+
+    bool moving() const { return _moving; }
+    uint32_t target() const { return _to; }
+
+    uint32_t predict(uint64_t nowNs) const;
+
+    // Seconds until the move completes (0 when stopped)
+    double remaining(uint64_t nowNs) const;
+
+    // Total duration of a move of the given length under the
+    // current profile
+    double duration(uint32_t steps, uint32_t deadSteps = 0) const;
+
+private:
+    // Distance covered t seconds into the profile, and its inverse
+    double distanceAt(double t) const;
+    double timeAt(double distance) const;
+
+    void plan();
+
+private:
+    double _rate;
+    double _accel;
+
+    bool _moving;
+    uint32_t _from;
+    uint32_t _to;
+    uint64_t _startNs;
+
+    // Profile for the current move; distances include dead travel
+    double _dead;
+    double _distance;
+    double _accelTime;
+    double _accelDist;
+    double _cruiseTime;
+    double _peakRate;
+    double _totalTime;
+};
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// A queued sequence of absolute moves executed one after another.
+//
+// Each step is either a waypoint (an intermediate move, e.g. an
+// overshoot to take up backlash) or a point the caller wants to know
+// about when it is reached. approach() appends a target so that the
+// final move onto it always travels in the plan's approach direction,
+// inserting an overshoot waypoint whenever the move would otherwise
+// arrive from the other side. Consecutive targets that already lie
+// in the approach direction are reached directly.
+//
+// Each step also carries a profile, a caller-defined choice of speed
+// and microstep settings to use for that move (0 = leave unchanged).
+class MotionPlan
+{
+public:
+    enum StepKind
+    {
+        SK_WAYPOINT,
+        SK_POINT
+    };
+
+    struct Step
+    {
+        uint32_t position;
+        StepKind kind;
+        uint8_t profile;
+    };
+
+public:
+    MotionPlan();
+
+    // Starts a new plan from the current position. lastDir is the
+    // direction of the previous move (1 outward, -1 inward, 0 unknown)
+    // and approachDir the direction every point must be reached in.
+    void begin(uint32_t from,
+               int lastDir,
+               int approachDir,
+               uint32_t overshoot,
+               uint32_t maxPos);
+    void clear();
+
+    // Returns false, adding nothing, when the plan is full
+    bool approach(uint32_t target, StepKind kind = SK_POINT, uint8_t profile = 0);
+    bool add(uint32_t target, StepKind kind, uint8_t profile = 0);
+
+    bool active() const { return _next < _count; }
+    const Step &current() const { return _steps[_next]; }
+    void advance();
+
+    size_t stepCount() const { return _count; }
+    size_t pointCount() const { return _points; }
+
+    // Points reached so far
+    size_t pointsDone() const { return _pointsDone; }
+
+public:
+    static const size_t g_maxSteps = 128;
+
+private:
+    Step _steps[g_maxSteps];
+    size_t _count;
+    size_t _next;
+    size_t _points;
+    size_t _pointsDone;
+
+    // Where the plan leaves the focuser so far
+    uint32_t _planPos;
+    int _planDir;
+
+    int _approachDir;
+    uint32_t _overshoot;
+    uint32_t _maxPos;
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+
+// Timing of one move, for calibration.
+//
+// The move is timed from its acknowledgement to the stop report.
+// Position reports received in between give the cruise rate
+// directly: the slope between the first and last report excludes
+// command latency, acceleration and any dead travel at the start,
+// none of which move the step counter at the cruise rate. Moves too
+// short to produce two distinct reports fall back to distance over
+// total duration.
+class MoveTiming
+{
+public:
+    MoveTiming();
+
+    void start(uint32_t position, uint64_t nowNs);
+    void sample(uint32_t position, uint64_t nowNs);
+    void stop(uint32_t position, uint64_t nowNs);
+
+    bool running() const { return _running; }
+    bool complete() const { return _complete; }
+
+    // Seconds from start to stop
+    double duration() const;
+    uint32_t distance() const;
+
+    // Steps per second
+    double rate() const;
+
+private:
+    bool _running;
+    bool _complete;
+
+    uint32_t _startPos;
+    uint64_t _startNs;
+    uint32_t _stopPos;
+    uint64_t _stopNs;
+
+    int _samples;
+    uint32_t _firstPos;
+    uint64_t _firstNs;
+    uint32_t _lastPos;
+    uint64_t _lastNs;
+};
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "LatencyHistogram.hpp"
+
+// Tracks commands sent to the controller until the reply that
+// acknowledges them arrives.
+//
+// Each issued command becomes an in-flight request with a deadline.
+// A reply completes the oldest in-flight request that expects it and
+// its round trip time is recorded in a per-command histogram.
+// Position and stopped reports are also sent unprompted while the
+// motor runs, so they can't be paired with a request: they complete
+// a waiting getPos or focusAbort without recording a sample.
+// Requests still in flight past their deadline are handed back by
+// expire() so the caller can flag the affected property.
+//
+// Not thread safe; the driver only uses it from the INDI main loop.
+class RequestTracker
+{
+public:
+    enum Command
+    {
+        CMD_FOCUS_REL,
+        CMD_FOCUS_ABS,
+        CMD_FOCUS_ABORT,
+        CMD_ENABLE_MOTOR,
+        CMD_ZERO,
+        CMD_SET_MICROSTEP,
+        CMD_SET_SPEED,
+        CMD_ENABLE_BACKLASH,
+        CMD_SET_BACKLASH_STEPS,
+        CMD_GET_MOTOR_ENABLED,
+        CMD_GET_POS,
+        CMD_GET_MAX_POS,
+        CMD_GET_MICROSTEP,
+        CMD_GET_SPEED,
+        CMD_GET_BACKLASH_ENABLED,
+        CMD_GET_BACKLASH_STEPS,
+        CMD_COUNT
+    };
+
+    // One per HostCommsListener callback
+    enum Reply
+    {
+        RP_MOVING_REL,
+        RP_MOVING_ABS,
+        RP_STOPPED,
+        RP_MOTOR_ENABLED,
+        RP_ZEROED,
+        RP_POSITION,
+        RP_MICROSTEPS,
+        RP_MAX_POS,
+        RP_SPEED,
+        RP_BACKLASH_ENABLED,
+        RP_BACKLASH_STEPS
+    };
+
+public:
+    RequestTracker();
+
+    // Returns false if too many requests are already in flight;
+    // the command is still sent, it just is not tracked
+    bool issued(Command cmd, uint64_t nowNs, uint32_t timeoutMs = g_defaultTimeoutMs);
+
+    // Completes the oldest request waiting for reply. Returns false
+    // if nothing was waiting (i.e. the reply was unsolicited); only
+    // sets latencyUs if a round trip sample was taken.
+    bool completed(Reply reply,
+                   uint64_t nowNs,
+                   Command *cmd = 0,
+                   uint64_t *latencyUs = 0);
+
+    // Removes up to max requests whose deadline has passed
+    int expire(uint64_t nowNs, Command *expired, int max);
+
+    // Forgets everything in flight
+    void clear();
+
+    int pending() const { return _count; }
+    bool pending(Command cmd) const;
+
+    const LatencyHistogram &histogram(Command cmd) const { return _histograms[cmd]; }
+
+    static Reply replyFor(Command cmd);
+
+    // True for replies the controller also sends unprompted
+    static bool isTelemetry(Reply reply);
+    static const char *commandName(Command cmd);
+
+public:
+    static const uint32_t g_defaultTimeoutMs = 2000;
+
+private:
+    static const int g_maxInFlight = 32;
+
+    struct Request
+    {
+        Command cmd;
+        uint64_t issuedNs;
+        uint64_t deadlineNs;
+    };
+
+    void remove(int idx);
+
+private:
+    // Oldest first
+    Request _inFlight[g_maxInFlight];
+    int _count;
+
+    LatencyHistogram _histograms[CMD_COUNT];
+};
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "HostCommsListener.hpp"
+
+// Fast path for the controller's numeric reports.
+//
+// Position reports dominate the traffic from the controller, and
+// each one costs a trip through HostComms::processLine(). This
+// parser handles the single-number reports (position, stopped, max
+// position, backlash steps) directly on the framer's view of the
+// line: a 256-entry table on the first byte picks the candidate
+// patterns, then a fixed prefix and suffix compare and a bounded
+// decimal parse. There is no copying, no allocation and no
+// dependence on the line being NUL terminated.
+//
+// The wire format belongs to the ELS comms library, so rather than
+// hard-code it, learn() renders each report through the firmware side
+// (ELS::FocuserComms) and derives its prefix and suffix. A pattern
+// is kept only if it reproduces the rendered values exactly and no
+// other report matches it. Anything unmatched, or every line if
+// nothing could be learned, goes to processLine() as before.
+class ResponseParser
+{
+public:
+    enum Kind
+    {
+        RK_POSITION,
+        RK_STOPPED,
+        RK_MAX_POS,
+        RK_BACKLASH_STEPS,
+        RK_COUNT
+    };
+
+public:
+    ResponseParser();
+
+    // Returns the number of reports learned
+    size_t learn();
+
+    bool learned(Kind kind) const { return _patterns[kind].valid; }
+
+    // Delivers line to listener and returns true if it is one of the
+    // learned reports; otherwise the caller falls back to HostComms
+    bool dispatch(const char *line,
+                  size_t len,
+                  ELS::HostCommsListener *listener) const;
+
+    // Parses line without delivering it; kind and value are only set
+    // on a match
+    bool match(const char *line, size_t len, Kind *kind, uint32_t *value) const;
+
+public:
+    static const size_t g_maxAffix = 16;
+
+private:
+    struct Pattern
+    {
+        bool valid;
+        uint8_t prefixLen;
+        uint8_t suffixLen;
+        char prefix[g_maxAffix];
+        char suffix[g_maxAffix];
+    };
+
+private:
+    bool learnOne(Kind kind);
+    void rebuildIndex();
+
+    static bool parseUint(const char *p, size_t len, uint32_t *value);
+
+private:
+    Pattern _patterns[RK_COUNT];
+
+    // Bit k set when pattern k can start with this byte
+    uint8_t _byFirst[256];
+};
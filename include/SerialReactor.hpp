@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <pthread.h>
+
+// One epoll thread serving the serial links of every device in the
+// process.
+//
+// Each device registers a Handler with the fds it wants watched and
+// is called back on the reactor thread when one is ready. Callbacks
+// run one at a time with the registration table locked, and remove()
+// takes the same lock, so once remove() returns the handler will not
+// be called again. Events carry the registration id, so anything
+// already collected for a handler that has since been removed is
+// dropped rather than delivered to whatever reuses the fd.
+//
+// Callbacks must not block: every device's I/O waits behind them.
+class SerialReactor
+{
+public:
+    class Handler
+    {
+    public:
+        virtual ~Handler() = default;
+
+        // One of the handler's fds is ready. Returning false stops
+        // watching all of them (the handler must still be removed)
+        virtual bool ready(int fd, uint32_t events) = 0;
+
+        // The reactor thread stopped on an error and none of the
+        // handler's fds are watched any more. The next add() starts
+        // a new thread
+        virtual void failed(int error) = 0;
+    };
+
+public:
+    SerialReactor();
+    ~SerialReactor();
+
+    SerialReactor(const SerialReactor &) = delete;
+    SerialReactor &operator=(const SerialReactor &) = delete;
+
+    // Watches fds for input, starting the thread on first use;
+    // returns a registration id, or 0 on failure
+    uint32_t add(Handler *handler, const int *fds, size_t count);
+
+    // Changes the events watched on one fd; from the handler's own
+    // callback or any thread
+    bool modify(uint32_t id, int fd, uint32_t events);
+
+    void remove(uint32_t id);
+
+    size_t handlers() const;
+
+public:
+    static const size_t g_maxHandlers = 16;
+    static const size_t g_maxFds = 2;
+
+private:
+    struct Registration
+    {
+        uint32_t id;
+        Handler *handler;
+        int fds[g_maxFds];
+        size_t fdCount;
+    };
+
+private:
+    bool start();
+    void stop();
+    void run();
+    void unwatch(Registration &reg);
+    Registration *find(uint32_t id);
+
+    static uint64_t key(uint32_t id, int fd) { return ((uint64_t)id << 32) | (uint32_t)fd; }
+
+private:
+    static void *runRedirect(void *obj);
+
+private:
+    mutable std::mutex _mutex;
+    Registration _regs[g_maxHandlers];
+    uint32_t _nextId;
+    int _epfd;
+    int _pipefd[2];
+    bool _running;
+    bool _failed;
+    pthread_t _threadHandle;
+};
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+// Bounded lock-free single-producer/single-consumer queue.
+//
+// push() may only be called from one thread and pop() from one
+// (other) thread. Capacity must be a power of two.
+template <typename T, size_t Capacity>
+class SpscQueue
+{
+    static_assert((Capacity & (Capacity - 1)) == 0,
+                  "SpscQueue capacity must be a power of two");
+
+public:
+    SpscQueue()
+        : _head(0),
+          _tail(0)
+    {
+    }
+
+    SpscQueue(const SpscQueue &) = delete;
+    SpscQueue &operator=(const SpscQueue &) = delete;
+
+    // Producer side; returns false if the queue is full, or would
+    // be left with fewer than reserve free slots
+    bool push(const T &item, size_t reserve = 0)
+    {
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail - _head.load(std::memory_order_acquire) + reserve >= Capacity)
+        {
+            return false;
+        }
+
+        _items[tail & (Capacity - 1)] = item;
+        _tail.store(tail + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    // Consumer side; returns false if the queue is empty
+    bool pop(T &item)
+    {
+        size_t head = _head.load(std::memory_order_relaxed);
+        if (head == _tail.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+
+        item = _items[head & (Capacity - 1)];
+        _head.store(head + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    bool empty() const
+    {
+        return _head.load(std::memory_order_acquire) ==
+               _tail.load(std::memory_order_acquire);
+    }
+
+    static size_t capacity() { return Capacity; }
+
+private:
+    static const size_t g_cacheLine = 64;
+
+private:
+    // Keep the indices on separate cache lines so the producer and
+    // consumer do not false-share. Padding is used rather than
+    // alignas so the queue can live inside heap objects under C++11.
+    std::atomic<size_t> _head;
+    char _headPad[g_cacheLine - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> _tail;
+    char _tailPad[g_cacheLine - sizeof(std::atomic<size_t>)];
+    T _items[Capacity];
+};
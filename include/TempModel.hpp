@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+
+// Focus drift with temperature, fitted from best focus results.
+//
+// Each filter focuses at a different position, so samples are centred
+// on their own filter's mean and only the variation within a filter
+// contributes to the slope. The linear model has one coefficient in
+// steps per degree over the whole range; the piecewise model fits a
+// coefficient per temperature segment and falls back to the overall
+// one where a segment has too little spread. offset() integrates the
+// coefficients between two temperatures.
+class TempModel
+{
+public:
+    enum Mode
+    {
+        TM_LINEAR,
+        TM_PIECEWISE
+    };
+
+    struct Sample
+    {
+        int filter;
+        double tempC;
+        double position;
+        double weight;
+    };
+
+public:
+    TempModel();
+
+    bool fit(const Sample *samples, size_t count, Mode mode, double segmentWidth);
+
+    // Uses a fixed coefficient instead of a fit
+    void setCoefficient(double stepsPerDegree);
+
+    bool valid() const { return _valid; }
+    double coefficient() const { return _slope; }
+    size_t segments() const;
+
+    // Expected change in focus position going from one temperature
+    // to another
+    double offset(double fromC, double toC) const;
+
+public:
+    static const size_t g_maxSegments = 32;
+    static const size_t g_maxFilters = 32;
+
+private:
+    bool fitSlope(const Sample *samples,
+                  size_t count,
+                  double loC,
+                  double hiC,
+                  double *slope) const;
+    double slopeOf(long segment) const;
+
+private:
+    bool _valid;
+    double _slope;
+
+    // Segment i covers [(_segBase + i) * _segWidth, +_segWidth)
+    double _segWidth;
+    long _segBase;
+    size_t _segCount;
+    double _segSlope[g_maxSegments];
+    bool _segValid[g_maxSegments];
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Timestamped record of the raw bytes on the serial link, for
+// replaying field problems through the real driver later.
+//
+// The file is a short header followed by one record per chunk:
+//
+//   uint64 time (ns since the capture started) | uint8 direction |
+//   3 reserved bytes | uint32 length | length bytes
+//
+// all little endian. RX chunks are exactly what each read returned
+// and TX chunks exactly what each write took, so a line superseded
+// in the command queue never appears, and one split by a partial
+// write spans two chunks. Records come from the reader thread and
+// may come from elsewhere, so record() serializes on a mutex;
+// capture is a debugging aid and is off by default.
+class TrafficCapture
+{
+public:
+    enum Direction
+    {
+        TD_RX = 0,
+        TD_TX = 1
+    };
+
+    struct Chunk
+    {
+        uint64_t timeNs;
+        Direction direction;
+        std::string data;
+    };
+
+public:
+    TrafficCapture();
+    ~TrafficCapture();
+
+    TrafficCapture(const TrafficCapture &) = delete;
+    TrafficCapture &operator=(const TrafficCapture &) = delete;
+
+    // Starts a new capture, replacing anything already in path
+    bool open(const char *path);
+    void close();
+
+    // Any thread; lets the reader skip the copy when not capturing
+    bool isOpen() const { return _open.load(std::memory_order_relaxed); }
+
+    void record(Direction direction, const void *data, size_t len);
+
+    // Records a chunk at a given time since the start, for building
+    // captures from a script rather than a live link
+    void record(uint64_t timeNs, Direction direction, const void *data, size_t len);
+
+    static bool load(const char *path, std::vector<Chunk> *chunks);
+
+private:
+    void write(uint64_t timeNs, Direction direction, const void *data, size_t len);
+
+private:
+    std::mutex _mutex;
+    FILE *_fp;
+    uint64_t _startNs;
+    std::atomic<bool> _open;
+};
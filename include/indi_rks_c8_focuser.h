@@ -1,16 +1,37 @@
 #pragma once
 
-#include <pthread.h>
+#include <memory>
 
 #include "libindi/indifocuser.h"
+#include "BinaryFrame.hpp"
+#include "C8Simulator.hpp"
+#include "CommandQueue.hpp"
 #include "CommsWriter.hpp"
 #include "HostComms.hpp"
 #include "HostCommsListener.hpp"
+#include "LineFramer.hpp"
+#include "LogRing.hpp"
+#include "FocusCache.hpp"
+#include "Metrics.hpp"
+#include "MotionJournal.hpp"
+#include "MotionModel.hpp"
+#include "MotionPlan.hpp"
+#include "MoveTiming.hpp"
+#include "RequestTracker.hpp"
+#include "ResponseParser.hpp"
+#include "SerialReactor.hpp"
+#include "SpscQueue.hpp"
+#include "TempModel.hpp"
+#include "TrafficCapture.hpp"
 
-class RKSC8Focuser : public INDI::Focuser, public ELS::HostCommsListener
+class RKSC8Focuser : public INDI::Focuser,
+                     public ELS::HostCommsListener,
+                     public LogRing::Sink
 {
 public:
-    RKSC8Focuser();
+    // Unit 0 is the only device in the process and takes the default
+    // name; units 1..N are numbered
+    RKSC8Focuser(SerialReactor *reactor, int unit = 0);
     virtual ~RKSC8Focuser() = default;
 
     virtual const char *getDefaultName() override;
@@ -50,6 +71,11 @@ public:
     virtual void backlashEnabled(bool isEnabled) override;
     virtual void backlashSteps(uint32_t steps) override;
 
+    // LogRing::Sink
+    virtual void logRecord(LogRing::Level level,
+                           LogRing::Category category,
+                           const char *msg) override;
+
 protected:
     virtual bool saveConfigItems(FILE *fp) override;
 
@@ -73,39 +99,325 @@ protected:
 private:
     void log(const char *fmt, ...);
 
+    bool logEnabled(LogRing::Category category, LogRing::Level level) const
+    {
+        return _logRing.enabled(category, level);
+    }
+
+    static void logRingRedirect(int fd, void *obj);
+
+    // Sends a property to clients and counts it toward the publish
+    // rate
+    void publish(INumberVectorProperty *nvp);
+    void publish(ISwitchVectorProperty *svp);
+    void publish(ITextVectorProperty *tvp);
+
     void updateAbsPosition(uint32_t position);
 
+    // Positions are kept and reported in X64 microsteps whatever the
+    // controller is set to, with or without Auto Speed; these
+    // convert to and from controller steps
+    uint32_t unitFactor() const;
+    uint32_t fromDevice(uint32_t steps) const;
+    uint32_t toDevice(uint32_t position) const;
+    void setPosOffset(int64_t offset);
+    uint32_t reachable(uint32_t position) const { return fromDevice(toDevice(position)); }
+    void publishMaxPos();
+    void settingsApplied();
+
+    // Motion prediction
+    double stepRate() const;
+    uint32_t relativeTarget(uint32_t from, ELS::FocusDirection dir, uint32_t steps) const;
+    uint32_t backlashSteps(uint32_t from, uint32_t to) const;
+    void beginPrediction(uint32_t from, uint32_t to);
+    void endPrediction(uint32_t position);
+    void publishMotion();
+    void predictPosition();
+
+    static void predictTimerRedirect(void *obj);
+
+    // Move completion
+    enum MoveState
+    {
+        MV_IDLE,
+        MV_REQUESTED,
+        MV_MOVING,
+        MV_SETTLING
+    };
+
+    IPState sendAbsMove(uint32_t target);
+    IPState requestMove(uint32_t target);
+    void moveStopped();
+    void moveCompleted();
+    void moveFailed();
+    void cancelSettle();
+    double settleRemaining() const;
+    IPState moveIPState() const
+    {
+        return ((_moveState == MV_IDLE) && !planRunning()) ? IPS_OK : IPS_BUSY;
+    }
+
+    static void settleTimerRedirect(void *obj);
+
+    // Queued motion plans (backlash-compensated moves, focus sweeps)
+    enum PlanType
+    {
+        PT_MOVE,
+        PT_SWEEP
+    };
+
+    enum MotionProfile
+    {
+        MP_CURRENT = 0,
+        MP_SLEW,
+        MP_APPROACH
+    };
+
+    bool planRunning() const { return _plan.active() && !_planWaiting; }
+    bool planPending() const { return _plan.active() || _planHeld; }
+    bool driverBacklash() const { return BacklashModeS[1].s == ISS_ON; }
+    bool autoMotion() const { return AutoMotionS[0].s == ISS_ON; }
+    bool applyProfile(uint8_t profile);
+    uint32_t approachOvershoot(int approachDir) const;
+    IPState planMove(uint32_t target);
+    bool startSweep(const uint32_t *targets, size_t count);
+    void runPlan();
+    void planStepDone();
+    void finishPlan();
+    void abortPlan(const char *reason);
+
+    static void dwellTimerRedirect(void *obj);
+
+    // Focus cache
+    void snoopDevices();
+    void focusCacheChanged();
+    bool focusCachePredict(uint32_t *position) const;
+    void focusCacheRecord(uint32_t position);
+
+    // Temperature compensation
+    bool tempCompEnabled() const { return TempCompS[0].s == ISS_ON; }
+    void tempCompFit();
+    void tempCompAnchor();
+    void tempCompCheck();
+    void publishTempComp();
+
+    // Step rate and reversal calibration
+    enum CalState
+    {
+        CAL_IDLE,
+        CAL_CONFIGURE,
+        CAL_FORWARD,
+        CAL_BACK,
+        CAL_RESTORE,
+        CAL_PRIME,
+        CAL_SAME,
+        CAL_REVERSE,
+        CAL_RETURN
+    };
+
+    static int stepRateIndex(ELS::FocusSpeed speed, ELS::Microsteps ms);
+    bool calibrating() const { return _calState != CAL_IDLE; }
+    bool startCalibration();
+    void calibrationApply(CalState state, ELS::FocusSpeed speed, ELS::Microsteps ms);
+    void calibrationSettingsChanged();
+    void calibrationMove(ELS::FocusDirection dir);
+    void calibrationStep();
+    void finishCalibration(bool success, const char *reason);
+
+    // Request/response correlation
+    void track(RequestTracker::Command cmd);
+    void replied(RequestTracker::Reply reply);
+    void checkRequests();
+    void logLatencies();
+
+    static void requestTimerRedirect(void *obj);
+
+    // Diagnostics
+    void startDiagnostics();
+    void stopDiagnostics();
+    void updateDiagnostics();
+    void dumpDiagnostics();
+
+    static void diagnosticsTimerRedirect(void *obj);
+
+    // Publishes the latest position now, cancelling any pending
+    // rate-limited publish
+    void flushPosition();
+
+    static void positionTimerRedirect(void *obj);
+
+    // Link supervision: the comms stack is torn down and rebuilt on
+    // every reconnect, then the settings in force when the link was
+    // lost are sent again
+    enum LinkState
+    {
+        LINK_DOWN,
+        LINK_UP,
+        LINK_RECONNECTING
+    };
+
+    struct LinkSettings
+    {
+        ELS::FocusSpeed speed;
+        ELS::Microsteps microsteps;
+        bool motorEnabled;
+        bool backlashEnabled;
+        uint32_t backlashSteps;
+        uint32_t devicePosition;
+    };
+
+    // Reconnect reports that must match the saved ones for the
+    // position offset to carry over
+    enum OffsetCheck
+    {
+        OC_POSITION = 1,
+        OC_MICROSTEPS = 2
+    };
+
+    bool startComms();
+    void stopComms();
+
+    // Handshake() sends the state queries and, for the user's own
+    // Connect, waits for the replies. A reconnect runs on the event
+    // loop and can't wait, so checkHandshake() finishes it from the
+    // event drain once the last reply is in, or the timeout timer
+    // does
+    bool startHandshake();
+    bool finishHandshake();
+    void checkHandshake();
+
+    static void handshakeTimerRedirect(void *obj);
+
+    void linkLost(const char *reason);
+    void reconnect();
+    void reconnectDone(bool ok);
+    void replaySettings();
+    void eventsLost(bool motionLost);
+    void checkOffset(int check, bool matches, const char *what);
+    void startHeartbeat();
+    void stopHeartbeat();
+    void heartbeat();
+    void publishLink();
+    void requestFraming();
+    void framingChanged(bool framed);
+
+    static void heartbeatTimerRedirect(void *obj);
+    static void reconnectTimerRedirect(void *obj);
+
 private:
+    // Queues outbound lines; the reader thread does the actual
+    // writes when the queue signals it
     class HCWriter : public ELS::CommsWriter
     {
+    public:
+        // Commands that may replace an unsent predecessor
+        enum CommandKey
+        {
+            CK_NONE = 0,
+            CK_FOCUS_ABS,
+            CK_SPEED,
+            CK_MICROSTEP,
+            CK_BACKLASH_STEPS
+        };
+
     public:
         HCWriter(RKSC8Focuser *parent);
 
+        bool open();
+
         virtual bool writeLine(const char *line);
         virtual void close();
 
+        // Queues line; a keyed line replaces any unsent line with
+        // the same key
+        bool writeLine(const char *line, CommandKey key, bool *superseded = 0);
+
+        // Keyed commands, formatted by HostComms. These track their
+        // own replies: a command that replaced an unsent one shares
+        // the request already in flight for it.
+        bool focusAbs(uint32_t position);
+        bool setSpeed(ELS::FocusSpeed speed);
+        bool setMicrostep(ELS::Microsteps ms);
+        bool setBacklashSteps(uint32_t steps);
+
+        // Lines written between beginBatch() and endBatch() are
+        // held back and sent with a single writev()
+        void beginBatch();
+        void endBatch();
+
+        // Refuses further lines once the link has gone
+        void fail() { _failed = true; }
+
+        CommandQueue *queue() { return &_queue; }
+
+    private:
+        // Captures the line HostComms formats for a command
+        class Render : public ELS::CommsWriter
+        {
+        public:
+            virtual bool writeLine(const char *line);
+            virtual void close() {}
+
+            char line[CommandQueue::g_maxLineLen + 1];
+        };
+
+    private:
+        bool writeKeyed(CommandKey key, RequestTracker::Command cmd);
+
     private:
         RKSC8Focuser *_parent;
-        char _buffer[1024];
+        CommandQueue _queue;
+        Render _rendered;
+        ELS::HostComms _render;
+        bool _failed;
     };
     friend class HCWriter;
 
 private:
-    class HCReader
+    // Reads and writes the serial port from the process-wide reactor
+    // thread (the "reader thread" for this device): frames input into
+    // lines for HostComms and flushes the command queue whenever it
+    // has something and the port will take it
+    class HCReader : public LineFramer::Listener,
+                     public SerialReactor::Handler
     {
     public:
         HCReader(int fd,
                  ELS::HostComms *comms,
+                 CommandQueue *queue,
+                 SerialReactor *reactor,
                  RKSC8Focuser *parent);
+        ~HCReader();
+
+        HCReader(const HCReader &) = delete;
+        HCReader &operator=(const HCReader &) = delete;
 
         bool start();
-        bool shutdown();
 
-    private:
-        void readThread();
+        // No callbacks run once this returns; safe to call more
+        // than once
+        void shutdown();
+
+        // SerialReactor::Handler
+        virtual bool ready(int fd, uint32_t events) override;
+        virtual void failed(int error) override;
+
+        // LineFramer::Listener
+        virtual void lineReceived(char *line, size_t len) override;
+        virtual void lineOverflow(size_t droppedBytes) override;
+        virtual void frameReceived(uint8_t type,
+                                   const uint8_t *payload,
+                                   size_t len) override;
+        virtual void frameCorrupt() override;
 
     private:
-        static void *readThreadRedirect(void *obj);
+        // Reads the port into the framer, through the traffic
+        // capture when one is running
+        ssize_t readPort();
+        bool flushQueue();
+
+        // Switches the framer when line acknowledges a framing request
+        bool framingAck(const char *line, size_t len);
 
     private:
         static const int g_bufSize = 1023;
@@ -113,24 +425,273 @@ private:
     private:
         int _fd;
         ELS::HostComms *_comms;
+        CommandQueue *_queue;
+        SerialReactor *_reactor;
         RKSC8Focuser *_parent;
-        pthread_t _readThreadHandle;
-        char _buffer[g_bufSize + 1];
-        int _bufLen;
-        int _pipefd[2];
+        uint32_t _id;
+        bool _wantWrite;
+        LineFramer _framer;
+        ResponseParser _parser;
     };
     friend class HCReader;
 
 private:
-    HCReader *_reader;
-    HCWriter *_writer;
-    ELS::HostComms *_comms;
+    // Receives HostCommsListener callbacks on the reader thread and
+    // marshals them onto the INDI main loop through an SPSC queue.
+    // A single byte on a pipe wakes the main loop, which then drains
+    // every queued event in one batch.
+    // Motion and state reports are also appended to the motion
+    // journal here, before they are queued.
+    class HCEvents : public ELS::HostCommsListener
+    {
+    public:
+        HCEvents(RKSC8Focuser *parent);
+        virtual ~HCEvents();
+
+        HCEvents(const HCEvents &) = delete;
+        HCEvents &operator=(const HCEvents &) = delete;
+
+        bool start();
+        void stop();
+
+        // From now on events that don't fit are dropped, so the
+        // reader can't wait on a main loop that is shutting it down
+        void discard() { _discarding.store(true, std::memory_order_release); }
+
+        // Drains queued events into the parent; main loop only
+        void drain();
+
+        // Becomes readable when events are waiting
+        int fd() const { return _pipefd[0]; }
+
+        // HostCommsListener (reader thread)
+        virtual void movingRel(ELS::FocusDirection dir,
+                               uint32_t steps) override;
+        virtual void movingAbs(uint32_t fromPosition,
+                               uint32_t toPosition) override;
+        virtual void stopped(uint32_t position) override;
+        virtual void motorEnabled(bool isEnabled) override;
+        virtual void zeroed() override;
+        virtual void position(uint32_t position) override;
+        virtual void microsteps(ELS::Microsteps ms) override;
+        virtual void maxPos(uint32_t position) override;
+        virtual void speed(ELS::FocusSpeed speed) override;
+        virtual void backlashEnabled(bool isEnabled) override;
+        virtual void backlashSteps(uint32_t steps) override;
+
+        // The reader thread stopped on a read or write error
+        void linkLost();
+
+        // The controller acknowledged a framing request
+        void framing(bool framed);
+
+    private:
+        enum EventType
+        {
+            EV_MOVING_REL,
+            EV_MOVING_ABS,
+            EV_STOPPED,
+            EV_MOTOR_ENABLED,
+            EV_ZEROED,
+            EV_POSITION,
+            EV_MICROSTEPS,
+            EV_MAX_POS,
+            EV_SPEED,
+            EV_BACKLASH_ENABLED,
+            EV_BACKLASH_STEPS,
+            EV_LINK_LOST,
+            EV_FRAMING
+        };
+
+        struct Event
+        {
+            EventType type;
+            uint32_t a;
+            uint32_t b;
+        };
+
+        void post(EventType type, uint32_t a = 0, uint32_t b = 0);
+        void dispatch(const Event &ev);
+
+    private:
+        static void drainRedirect(int fd, void *obj);
+
+    private:
+        static const size_t g_queueSize = 256;
+
+        // Slots only events other than position reports may use, so
+        // a burst of positions can't crowd out a stopped report
+        static const size_t g_reservedSlots = 16;
+
+    private:
+        RKSC8Focuser *_parent;
+        SpscQueue<Event, g_queueSize> _queue;
+        std::atomic<bool> _wakeupPending;
+        std::atomic<bool> _discarding;
+
+        // Set by the reactor thread when an event didn't fit and was
+        // dropped; the next drain reads the controller state back,
+        // and aborts any move if the lost event was a motion report
+        std::atomic<bool> _overflowed;
+        std::atomic<bool> _motionLost;
+        int _pipefd[2];
+        int _callbackId;
+    };
+    friend class HCEvents;
+
+private:
+    // Serial I/O thread shared by every device in the process
+    SerialReactor *_reactor;
+
+    // The comms stack for the current connection. The reader uses
+    // everything above it, so it is declared last and goes first
+    std::unique_ptr<C8Simulator> _simulator;
+    std::unique_ptr<HCEvents> _events;
+    std::unique_ptr<HCWriter> _writer;
+    std::unique_ptr<ELS::HostComms> _comms;
+    std::unique_ptr<HCReader> _reader;
 
     ELS::Microsteps _microsteps;
     uint32_t _maxPos;
     uint32_t _position;
     ELS::FocusSpeed _speed;
 
+    // Canonical = offset + controller steps * unitFactor(). The
+    // offset is re-established from a fresh position query after
+    // every microstep change, and set through setPosOffset() so the
+    // motion journal can follow it. A reconnect keeps it only while
+    // the controller's first reports agree with what it had before
+    // the drop; once it is thrown away the position shows ALERT
+    // until the next move or zero
+    bool _unitsKnown;
+    int64_t _posOffset;
+    int _offsetChecks;
+    bool _offsetLost;
+    uint32_t _devicePosition;
+    uint32_t _deviceMaxPos;
+    uint32_t _maxPosFactor;
+    bool _rebasePending;
+    uint32_t _rebasePosition;
+
+    // Predicts position and ETA between controller reports
+    MotionModel _motion;
+    int _predictTimerId;
+    int _lastMoveDir;
+
+    // Moves report BUSY until stopped and settled
+    MoveState _moveState;
+    uint32_t _requestedTarget;
+    int _settleTimerId;
+    uint64_t _settleDoneNs;
+
+    // Plan in progress; waiting means a sweep is parked on a point
+    // until NEXT or the dwell timer
+    MotionPlan _plan;
+    PlanType _planType;
+    uint32_t _planTarget;
+    bool _planRetried;
+    bool _planWaiting;
+
+    // A step sent while the previous move was still running is
+    // pending until a movingAbs confirms the controller took its
+    // target, then acknowledged
+    enum RetargetState
+    {
+        RT_NONE,
+        RT_PENDING,
+        RT_ACKNOWLEDGED
+    };
+    RetargetState _planRetarget;
+
+    // A move to _planTarget is planned once the running move,
+    // stopped to change its profile, reports stopped
+    bool _planHeld;
+
+    // Waiting for the settings of the next step's profile
+    bool _planConfiguring;
+    ELS::FocusSpeed _profileSpeed;
+    ELS::Microsteps _profileMicrosteps;
+    int _dwellTimerId;
+
+    // Best focus per filter/temperature, and what is snooped now
+    // (slots are 1-based as in INDI, and without a filter wheel
+    // everything is slot 1; NaN means no temperature source)
+    FocusCache _focusCache;
+    int _filterSlot;
+    double _ambientTemp;
+
+    // Temperature compensation: the model, the (temperature, position)
+    // corrections are measured from, and whether a camera exposure is
+    // running. Any move that is not a correction re-anchors
+    TempModel _tempModel;
+    bool _compAnchored;
+    double _compRefTemp;
+    uint32_t _compRefPos;
+    bool _compCorrecting;
+    uint64_t _compLastNs;
+    bool _exposing;
+
+    // Calibration in progress: the combination under test, the
+    // settings to restore afterwards and the current test move
+    CalState _calState;
+    int _calCombo;
+    ELS::FocusSpeed _calSpeed;
+    ELS::Microsteps _calMicrosteps;
+    ELS::FocusSpeed _calSavedSpeed;
+    ELS::Microsteps _calSavedMicrosteps;
+    ELS::FocusDirection _calDir;
+    uint32_t _calSteps;
+    MoveTiming _calTiming;
+    double _calForwardRate;
+    double _calSameSecs;
+
+    // Link health; a heartbeat query goes out whenever a period
+    // passes without any line from the controller
+    LinkState _linkState;
+    LinkSettings _linkSaved;
+    int _heartbeatTimerId;
+    uint64_t _heartbeatLines;
+    int _heartbeatMisses;
+    int _reconnectTimerId;
+    bool _handshaking;
+    int _handshakeQueries;
+    int _handshakeReplies;
+    uint64_t _handshakeStartNs;
+    int _handshakeTimerId;
+    int _reconnectAttempt;
+    uint64_t _reconnectAtNs;
+    uint32_t _reconnects;
+
+    // Telemetry from the controller arrives as BinaryFrame frames
+    // rather than text lines
+    bool _framed;
+
+    // Commands awaiting their reply
+    RequestTracker _tracker;
+    int _requestTimerId;
+
+    // Deferred logging for the reader thread
+    LogRing _logRing;
+    int _logCallbackId;
+
+    // Motion and state history, appended by the reader thread
+    MotionJournal _journal;
+
+    // Raw serial traffic for replay; spans reconnects
+    TrafficCapture _capture;
+
+    // Hot-path instrumentation
+    Metrics _metrics;
+    int _diagTimerId;
+    uint64_t _diagLastNs;
+    uint64_t _diagLastPublishes;
+    uint32_t _diagTicks;
+
+    // Position telemetry coalescing
+    bool _positionPending;
+    int _positionTimerId;
+    uint64_t _lastPositionPublishNs;
+
     // Enable/Disable
     ISwitch EnableS[2];
     ISwitchVectorProperty EnableSP;
@@ -146,4 +707,165 @@ private:
     // Zero
     ISwitch ZeroS[1];
     ISwitchVectorProperty ZeroSP;
+
+    // Telemetry
+    INumber TelemetryN[1];
+    INumberVectorProperty TelemetryNP;
+
+    // Diagnostics
+    enum
+    {
+        DIAG_BYTES_READ,
+        DIAG_BYTES_WRITTEN,
+        DIAG_LINES_PARSED,
+        DIAG_LINES_DROPPED,
+        DIAG_EVENTS,
+        DIAG_EVENTS_DROPPED,
+        DIAG_DISPATCH_MEAN,
+        DIAG_DISPATCH_MAX,
+        DIAG_PUBLISH_RATE,
+        DIAG_RTT_MEAN,
+        DIAG_RTT_P99,
+        DIAG_CMDS_SUPERSEDED,
+        DIAG_CMDS_REJECTED,
+        DIAG_COUNT
+    };
+    INumber DiagnosticsN[DIAG_COUNT];
+    INumberVectorProperty DiagnosticsNP;
+
+    // Round trip time per command
+    enum
+    {
+        LAT_REPLIES,
+        LAT_MEAN,
+        LAT_P99,
+        LAT_FIELDS
+    };
+    INumber LatencyN[RequestTracker::CMD_COUNT * LAT_FIELDS];
+    INumberVectorProperty LatencyNP;
+
+    // Motion model
+    INumber MotionModelN[2];
+    INumberVectorProperty MotionModelNP;
+
+    // Position prediction
+    ISwitch PredictS[2];
+    ISwitchVectorProperty PredictSP;
+
+    // Settle delay after each move
+    INumber SettleN[1];
+    INumberVectorProperty SettleNP;
+
+    // Focus cache: snooped devices, table file, bin width, current
+    // lookup, recording, actions and auto move on filter change
+    IText SnoopT[5];
+    ITextVectorProperty SnoopTP;
+    IText FocusCacheFileT[1];
+    ITextVectorProperty FocusCacheFileTP;
+    INumber FocusCacheOptionsN[1];
+    INumberVectorProperty FocusCacheOptionsNP;
+    INumber FocusCacheStateN[3];
+    INumberVectorProperty FocusCacheStateNP;
+    INumber FocusCacheRecordN[1];
+    INumberVectorProperty FocusCacheRecordNP;
+    ISwitch FocusCacheActionS[2];
+    ISwitchVectorProperty FocusCacheActionSP;
+    ISwitch FocusCacheAutoS[2];
+    ISwitchVectorProperty FocusCacheAutoSP;
+
+    // Temperature compensation: enable, model, limits and status
+    ISwitch TempCompS[2];
+    ISwitchVectorProperty TempCompSP;
+    ISwitch TempCompModelS[3];
+    ISwitchVectorProperty TempCompModelSP;
+    enum
+    {
+        TC_COEFFICIENT,
+        TC_SEGMENT,
+        TC_MIN_STEP,
+        TC_MAX_STEP,
+        TC_INTERVAL,
+        TC_COUNT
+    };
+    INumber TempCompSettingsN[TC_COUNT];
+    INumberVectorProperty TempCompSettingsNP;
+    INumber TempCompStatusN[4];
+    INumberVectorProperty TempCompStatusNP;
+
+    // Link status (reconnects, attempt, next retry) and supervisor
+    // options (heartbeat period, missed heartbeats, backoff limit)
+    INumber LinkStatusN[3];
+    INumberVectorProperty LinkStatusNP;
+    INumber LinkOptionsN[3];
+    INumberVectorProperty LinkOptionsNP;
+
+    // Telemetry framing preference (binary if supported, or text)
+    ISwitch FramingS[2];
+    ISwitchVectorProperty FramingSP;
+
+    // Calibration control, test move length and results
+    ISwitch CalibrateS[2];
+    ISwitchVectorProperty CalibrateSP;
+    INumber CalibrateOptionsN[1];
+    INumberVectorProperty CalibrateOptionsNP;
+    INumber StepRateN[8];
+    INumberVectorProperty StepRateNP;
+    INumber TakeUpN[1];
+    INumberVectorProperty TakeUpNP;
+
+    // Automatic speed and microstep selection
+    ISwitch AutoMotionS[2];
+    ISwitchVectorProperty AutoMotionSP;
+    INumber AutoMotionN[2];
+    INumberVectorProperty AutoMotionNP;
+
+    // Backlash handled by the firmware or planned by the driver
+    ISwitch BacklashModeS[2];
+    ISwitchVectorProperty BacklashModeSP;
+
+    // Driver backlash (inward, outward) and final approach direction
+    INumber DriverBacklashN[2];
+    INumberVectorProperty DriverBacklashNP;
+    ISwitch BacklashApproachS[2];
+    ISwitchVectorProperty BacklashApproachSP;
+
+    // Focus sweep targets, as a list or start/step/count
+    IText SweepListT[1];
+    ITextVectorProperty SweepListTP;
+    INumber SweepRangeN[3];
+    INumberVectorProperty SweepRangeNP;
+
+    // Focus sweep options (dwell, overshoot) and approach direction
+    INumber SweepOptionsN[2];
+    INumberVectorProperty SweepOptionsNP;
+    ISwitch SweepApproachS[2];
+    ISwitchVectorProperty SweepApproachSP;
+
+    // Focus sweep control (next, abort) and per-point status
+    ISwitch SweepControlS[2];
+    ISwitchVectorProperty SweepControlSP;
+    INumber SweepStatusN[3];
+    INumberVectorProperty SweepStatusNP;
+
+    // Motion (ETA, settle ETA, target)
+    INumber MotionN[3];
+    INumberVectorProperty MotionNP;
+
+    // Per-category log verbosity
+    INumber LogLevelN[LogRing::LC_COUNT];
+    INumberVectorProperty LogLevelNP;
+
+    // Diagnostics dump
+    IText DiagDumpFileT[1];
+    ITextVectorProperty DiagDumpFileTP;
+    INumber DiagDumpIntervalN[1];
+    INumberVectorProperty DiagDumpIntervalNP;
+
+    // Motion journal file (empty = off)
+    IText JournalFileT[1];
+    ITextVectorProperty JournalFileTP;
+
+    // Serial traffic capture file (empty = off)
+    IText CaptureFileT[1];
+    ITextVectorProperty CaptureFileTP;
 };
@@ -0,0 +1,133 @@
+#include <cstring>
+
+#include "BinaryFrame.hpp"
+#include "HostCommsListener.hpp"
+
+const char *const BinaryFrame::g_requestBinary = "#FRAMING BINARY";
+const char *const BinaryFrame::g_requestAscii = "#FRAMING ASCII";
+const char *const BinaryFrame::g_ackBinary = "#FRAMING BINARY OK";
+const char *const BinaryFrame::g_ackAscii = "#FRAMING ASCII OK";
+
+/* static */ size_t BinaryFrame::encode(Type type,
+                                        const uint8_t *payload,
+                                        size_t len,
+                                        uint8_t *out,
+                                        size_t outSize)
+{
+    if ((len + 1 > g_maxBody) || (len + 1 + g_overhead > outSize))
+    {
+        return 0;
+    }
+
+    out[0] = g_sync;
+    out[1] = (uint8_t)(len + 1);
+    out[2] = (uint8_t)type;
+    if (len > 0)
+    {
+        memcpy(out + 3, payload, len);
+    }
+
+    uint16_t crc = crc16(out + 1, len + 2);
+    out[len + 3] = (uint8_t)(crc >> 8);
+    out[len + 4] = (uint8_t)crc;
+
+    return len + 1 + g_overhead;
+}
+
+/* static */ size_t BinaryFrame::encodeValue(Type type,
+                                             uint32_t value,
+                                             uint8_t *out,
+                                             size_t outSize)
+{
+    uint8_t varint[g_maxVarint];
+
+    return encode(type, varint, putVarint(value, varint), out, outSize);
+}
+
+/* static */ bool BinaryFrame::dispatch(uint8_t type,
+                                        const uint8_t *payload,
+                                        size_t len,
+                                        ELS::HostCommsListener *listener)
+{
+    uint32_t value = 0;
+    if ((type == FT_LINE) || !getVarint(payload, len, &value))
+    {
+        return false;
+    }
+
+    switch (type)
+    {
+    case FT_POSITION:
+        listener->position(value);
+        break;
+    case FT_STOPPED:
+        listener->stopped(value);
+        break;
+    case FT_MAX_POS:
+        listener->maxPos(value);
+        break;
+    case FT_BACKLASH_STEPS:
+        listener->backlashSteps(value);
+        break;
+    default:
+        return false;
+    }
+
+    return true;
+}
+
+/* static */ size_t BinaryFrame::putVarint(uint32_t value, uint8_t *out)
+{
+    size_t n = 0;
+    while (value >= 0x80)
+    {
+        out[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = (uint8_t)value;
+
+    return n;
+}
+
+/* static */ bool BinaryFrame::getVarint(const uint8_t *p, size_t len, uint32_t *value)
+{
+    // The whole payload must be exactly one varint
+    if ((len == 0) || (len > g_maxVarint))
+    {
+        return false;
+    }
+
+    uint64_t v = 0;
+    for (size_t i = 0; i < len; i++)
+    {
+        bool last = ((p[i] & 0x80) == 0);
+        if (last != (i == len - 1))
+        {
+            return false;
+        }
+        v |= (uint64_t)(p[i] & 0x7f) << (7 * i);
+    }
+
+    if (v > 0xffffffffULL)
+    {
+        return false;
+    }
+
+    *value = (uint32_t)v;
+
+    return true;
+}
+
+/* static */ uint16_t BinaryFrame::crc16(const uint8_t *p, size_t len, uint16_t crc)
+{
+    while (len-- > 0)
+    {
+        crc ^= (uint16_t)(*p++) << 8;
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+
+    return crc;
+}
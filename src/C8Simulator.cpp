@@ -0,0 +1,461 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "C8Simulator.hpp"
+#include "MonotonicClock.hpp"
+
+// Default step pulses per second at FS_NORMAL for MS_X8 .. MS_X64
+static const uint32_t g_defaultStepRates[] = {250, 450, 700, 1000};
+
+C8Simulator::C8Simulator()
+    : _fd(-1),
+      _hostFd(-1),
+      _running(false),
+      _writer(this),
+      _comms(&_writer, this),
+      _framer(this),
+      _framed(false),
+      _position(g_defaultMaxPos / 2),
+      _maxPos(g_defaultMaxPos),
+      _microsteps(ELS::MS_X64),
+      _speed(ELS::FS_NORMAL),
+      _motorEnabled(false),
+      _backlashEnabled(true),
+      _backlashSteps(g_defaultBacklashSteps),
+      _moving(false),
+      _target(0),
+      _lastDir(ELS::FD_FOCUS_OUTWARD),
+      _backlashRemaining(0),
+      _stepAccum(0),
+      _lastTickNs(0),
+      _lastReportNs(0)
+{
+    _pipefd[0] = -1;
+    _pipefd[1] = -1;
+
+    for (int i = 0; i < 4; i++)
+    {
+        _stepRate[i] = g_defaultStepRates[i];
+    }
+}
+
+C8Simulator::~C8Simulator()
+{
+    stop();
+}
+
+int C8Simulator::start()
+{
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) != 0)
+    {
+        return -1;
+    }
+
+    if (pipe2(_pipefd, O_CLOEXEC) != 0)
+    {
+        ::close(sv[0]);
+        ::close(sv[1]);
+        return -1;
+    }
+
+    _fd = sv[0];
+    _hostFd = sv[1];
+
+    if (pthread_create(&_threadHandle, NULL, simThreadRedirect, this) != 0)
+    {
+        stop();
+        return -1;
+    }
+    _running = true;
+
+    return _hostFd;
+}
+
+void C8Simulator::stop()
+{
+    if (_running)
+    {
+        ::close(_pipefd[1]);
+        _pipefd[1] = -1;
+        pthread_join(_threadHandle, NULL);
+        _running = false;
+    }
+
+    for (int i = 0; i < 2; i++)
+    {
+        if (_pipefd[i] != -1)
+        {
+            ::close(_pipefd[i]);
+            _pipefd[i] = -1;
+        }
+    }
+
+    if (_fd != -1)
+    {
+        ::close(_fd);
+        _fd = -1;
+    }
+
+    // The host end belongs to the caller
+    _hostFd = -1;
+}
+
+void C8Simulator::focusRel(ELS::FocusDirection dir, uint32_t steps)
+{
+    uint32_t target = 0;
+    if (dir == ELS::FD_FOCUS_INWARD)
+    {
+        target = (steps > _position) ? 0 : _position - steps;
+    }
+    else
+    {
+        target = ((uint64_t)_position + steps > _maxPos) ? _maxPos : _position + steps;
+    }
+
+    _comms.movingRel(dir, steps);
+    beginMove(target);
+}
+
+void C8Simulator::focusAbs(uint32_t position)
+{
+    uint32_t target = (position > _maxPos) ? _maxPos : position;
+
+    _comms.movingAbs(_position, target);
+    beginMove(target);
+}
+
+void C8Simulator::focusAbort()
+{
+    _moving = false;
+    _backlashRemaining = 0;
+    report(BinaryFrame::FT_STOPPED, _position);
+}
+
+void C8Simulator::enableMotor(bool enable)
+{
+    _motorEnabled = enable;
+    if (!enable && _moving)
+    {
+        focusAbort();
+    }
+    _comms.motorEnabled(_motorEnabled);
+}
+
+void C8Simulator::zero()
+{
+    if (_moving)
+    {
+        focusAbort();
+    }
+    _position = 0;
+    _comms.zeroed();
+}
+
+void C8Simulator::setMicrostep(ELS::Microsteps ms)
+{
+    // The step counter is not rescaled; that is up to the host
+    if ((ms >= ELS::MS_X8) && (ms <= ELS::MS_X64))
+    {
+        _microsteps = ms;
+    }
+    _comms.microsteps(_microsteps);
+}
+
+void C8Simulator::setSpeed(ELS::FocusSpeed speed)
+{
+    _speed = speed;
+    _comms.speed(_speed);
+}
+
+void C8Simulator::enableBacklash(bool enable)
+{
+    _backlashEnabled = enable;
+    _comms.backlashEnabled(_backlashEnabled);
+}
+
+void C8Simulator::setBacklashSteps(uint32_t steps)
+{
+    _backlashSteps = steps;
+    report(BinaryFrame::FT_BACKLASH_STEPS, _backlashSteps);
+}
+
+void C8Simulator::getMotorEnabled()
+{
+    _comms.motorEnabled(_motorEnabled);
+}
+
+void C8Simulator::getPos()
+{
+    report(BinaryFrame::FT_POSITION, _position);
+}
+
+void C8Simulator::getMaxPos()
+{
+    report(BinaryFrame::FT_MAX_POS, _maxPos);
+}
+
+void C8Simulator::getMicrostep()
+{
+    _comms.microsteps(_microsteps);
+}
+
+void C8Simulator::getSpeed()
+{
+    _comms.speed(_speed);
+}
+
+void C8Simulator::getBacklashEnabled()
+{
+    _comms.backlashEnabled(_backlashEnabled);
+}
+
+void C8Simulator::getBacklashSteps()
+{
+    report(BinaryFrame::FT_BACKLASH_STEPS, _backlashSteps);
+}
+
+void C8Simulator::lineReceived(char *line, size_t)
+{
+    // The ack always goes out as text, and the new framing applies
+    // to everything after it
+    if (strcmp(line, BinaryFrame::g_requestBinary) == 0)
+    {
+        _framed = false;
+        _writer.writeLine(BinaryFrame::g_ackBinary);
+        _framed = true;
+        return;
+    }
+
+    if (strcmp(line, BinaryFrame::g_requestAscii) == 0)
+    {
+        _framed = false;
+        _writer.writeLine(BinaryFrame::g_ackAscii);
+        return;
+    }
+
+    _comms.processLine(line);
+}
+
+void C8Simulator::lineOverflow(size_t)
+{
+}
+
+void C8Simulator::simThread()
+{
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd == -1)
+    {
+        return;
+    }
+
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.fd = _fd;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, _fd, &ev);
+    ev.events = EPOLLIN;
+    ev.data.fd = _pipefd[0];
+    epoll_ctl(epfd, EPOLL_CTL_ADD, _pipefd[0], &ev);
+
+    struct epoll_event events[2];
+    bool running = true;
+    while (running)
+    {
+        int n = epoll_wait(epfd, events, 2, _moving ? g_tickMs : -1);
+        if ((n == -1) && (errno != EINTR))
+        {
+            break;
+        }
+
+        for (int i = 0; i < n; i++)
+        {
+            if (events[i].data.fd == _pipefd[0])
+            {
+                running = false;
+                break;
+            }
+
+            ssize_t bytesRead = _framer.readFrom(_fd);
+            if ((bytesRead == 0) ||
+                ((bytesRead == -1) && (errno != EAGAIN) && (errno != EINTR)))
+            {
+                // Host closed its end
+                running = false;
+                break;
+            }
+        }
+
+        if (_moving)
+        {
+            advance(monotonicNs());
+        }
+    }
+
+    close(epfd);
+}
+
+void C8Simulator::beginMove(uint32_t target)
+{
+    if (!_motorEnabled || (target == _position))
+    {
+        _moving = false;
+        report(BinaryFrame::FT_STOPPED, _position);
+        return;
+    }
+
+    ELS::FocusDirection dir = (target > _position) ? ELS::FD_FOCUS_OUTWARD
+                                                   : ELS::FD_FOCUS_INWARD;
+
+    // Taking up backlash costs travel time but does not change the
+    // step counter; only a move that is already under way in the
+    // same direction avoids it
+    if (_backlashEnabled && (dir != _lastDir))
+    {
+        _backlashRemaining = _backlashSteps;
+    }
+    _lastDir = dir;
+
+    if (!_moving)
+    {
+        _lastTickNs = monotonicNs();
+        _lastReportNs = _lastTickNs;
+        _stepAccum = 0;
+    }
+
+    _target = target;
+    _moving = true;
+}
+
+void C8Simulator::advance(uint64_t nowNs)
+{
+    _stepAccum += currentRate() * ((nowNs - _lastTickNs) / 1e9);
+    _lastTickNs = nowNs;
+
+    if (_backlashRemaining > 0)
+    {
+        double taken = (_stepAccum < _backlashRemaining) ? _stepAccum : _backlashRemaining;
+        _backlashRemaining -= taken;
+        _stepAccum -= taken;
+    }
+
+    uint32_t steps = (uint32_t)_stepAccum;
+    _stepAccum -= steps;
+
+    uint32_t remaining = (_target > _position) ? _target - _position
+                                               : _position - _target;
+    if (steps >= remaining)
+    {
+        _position = _target;
+        _moving = false;
+        report(BinaryFrame::FT_STOPPED, _position);
+        return;
+    }
+
+    if (_target > _position)
+    {
+        _position += steps;
+    }
+    else
+    {
+        _position -= steps;
+    }
+
+    if ((nowNs - _lastReportNs) >= (uint64_t)g_positionReportMs * 1000000ULL)
+    {
+        _lastReportNs = nowNs;
+        report(BinaryFrame::FT_POSITION, _position);
+    }
+}
+
+void C8Simulator::report(BinaryFrame::Type type, uint32_t value)
+{
+    if (_framed)
+    {
+        _writer.writeValue(type, value);
+        return;
+    }
+
+    switch (type)
+    {
+    case BinaryFrame::FT_POSITION:
+        _comms.position(value);
+        break;
+    case BinaryFrame::FT_STOPPED:
+        _comms.stopped(value);
+        break;
+    case BinaryFrame::FT_MAX_POS:
+        _comms.maxPos(value);
+        break;
+    case BinaryFrame::FT_BACKLASH_STEPS:
+        _comms.backlashSteps(value);
+        break;
+    default:
+        break;
+    }
+}
+
+void C8Simulator::setStepRate(ELS::Microsteps ms, uint32_t stepsPerSec)
+{
+    if ((ms >= ELS::MS_X8) && (ms <= ELS::MS_X64))
+    {
+        _stepRate[ms - ELS::MS_X8] = stepsPerSec;
+    }
+}
+
+uint32_t C8Simulator::currentRate() const
+{
+    uint32_t rate = _stepRate[_microsteps - ELS::MS_X8].load(std::memory_order_relaxed);
+
+    return (_speed == ELS::FS_X3) ? rate * 3 : rate;
+}
+
+/* static */ void *C8Simulator::simThreadRedirect(void *obj)
+{
+    ((C8Simulator *)(obj))->simThread();
+
+    return 0;
+}
+
+//
+// SimWriter
+//
+
+C8Simulator::SimWriter::SimWriter(C8Simulator *parent)
+    : _parent(parent)
+{
+}
+
+bool C8Simulator::SimWriter::writeLine(const char *line)
+{
+    ssize_t len = 0;
+    if (_parent->_framed)
+    {
+        len = BinaryFrame::encode(BinaryFrame::FT_LINE,
+                                  (const uint8_t *)line,
+                                  strlen(line),
+                                  _buffer,
+                                  sizeof(_buffer));
+    }
+    else
+    {
+        len = snprintf((char *)_buffer, sizeof(_buffer), "%s\r\n", line);
+    }
+
+    return (len > 0) && (write(_parent->_fd, _buffer, len) == len);
+}
+
+bool C8Simulator::SimWriter::writeValue(BinaryFrame::Type type, uint32_t value)
+{
+    ssize_t len = BinaryFrame::encodeValue(type, value, _buffer, sizeof(_buffer));
+
+    return (len > 0) && (write(_parent->_fd, _buffer, len) == len);
+}
+
+void C8Simulator::SimWriter::close()
+{
+}
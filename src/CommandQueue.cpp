@@ -0,0 +1,291 @@
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "CommandQueue.hpp"
+#include "TrafficCapture.hpp"
+
+CommandQueue::CommandQueue()
+    : _head(0),
+      _tail(0),
+      _inFlight(0),
+      _offset(0),
+      _holdCount(0),
+      _notifyPending(false)
+{
+    _pipefd[0] = -1;
+    _pipefd[1] = -1;
+
+    _stats.linesQueued = 0;
+    _stats.linesWritten = 0;
+    _stats.bytesWritten = 0;
+    _stats.writeCalls = 0;
+    _stats.partialWrites = 0;
+    _stats.wouldBlock = 0;
+    _stats.superseded = 0;
+    _stats.rejected = 0;
+}
+
+CommandQueue::~CommandQueue()
+{
+    close();
+}
+
+bool CommandQueue::open()
+{
+    return (pipe2(_pipefd, O_NONBLOCK | O_CLOEXEC) == 0);
+}
+
+void CommandQueue::close()
+{
+    for (int i = 0; i < 2; i++)
+    {
+        if (_pipefd[i] != -1)
+        {
+            ::close(_pipefd[i]);
+            _pipefd[i] = -1;
+        }
+    }
+}
+
+bool CommandQueue::push(const char *line, uint8_t key, int timeoutMs, bool *superseded)
+{
+    if (superseded != 0)
+    {
+        *superseded = false;
+    }
+
+    size_t len = strlen(line);
+    if (len > g_maxLineLen)
+    {
+        _stats.rejected.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    if (key != 0)
+    {
+        // Only the last queued line may be replaced in place; an
+        // earlier one is dropped and the new line queued at the tail
+        // so that it still follows every command pushed before it
+        for (uint64_t i = _head + _inFlight; i < _tail; i++)
+        {
+            Entry &entry = _entries[i % g_maxEntries];
+            if ((entry.key != key) || ((i == _head) && (_offset != 0)))
+            {
+                continue;
+            }
+
+            _stats.superseded.fetch_add(1, std::memory_order_relaxed);
+            if (superseded != 0)
+            {
+                *superseded = true;
+            }
+
+            if (i == (_tail - 1))
+            {
+                memcpy(entry.data, line, len);
+                memcpy(entry.data + len, "\r\n", 2);
+                entry.len = (uint16_t)(len + 2);
+                return true;
+            }
+
+            for (uint64_t j = i; j + 1 < _tail; j++)
+            {
+                _entries[j % g_maxEntries] = _entries[(j + 1) % g_maxEntries];
+            }
+            _tail--;
+            _stats.linesQueued.fetch_sub(1, std::memory_order_relaxed);
+            break;
+        }
+    }
+
+    // Backpressure
+    if (!_spaceCond.wait_for(lock,
+                             std::chrono::milliseconds(timeoutMs),
+                             [this] { return (_tail - _head) < g_maxEntries; }))
+    {
+        _stats.rejected.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    Entry &entry = _entries[_tail % g_maxEntries];
+    memcpy(entry.data, line, len);
+    memcpy(entry.data + len, "\r\n", 2);
+    entry.len = (uint16_t)(len + 2);
+    entry.key = key;
+    _tail++;
+
+    _stats.linesQueued.fetch_add(1, std::memory_order_relaxed);
+
+    if (_holdCount == 0)
+    {
+        notify();
+    }
+
+    return true;
+}
+
+void CommandQueue::hold()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _holdCount++;
+}
+
+void CommandQueue::release()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if ((_holdCount > 0) && (--_holdCount == 0) && (_tail != _head))
+    {
+        notify();
+    }
+}
+
+bool CommandQueue::flush(int fd, TrafficCapture *capture)
+{
+    struct iovec iov[g_maxEntries];
+    size_t count = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        if (_holdCount != 0)
+        {
+            return true;
+        }
+
+        // Snapshot the queued lines; they cannot be superseded
+        // while the write is in progress
+        for (uint64_t i = _head; i < _tail; i++)
+        {
+            Entry &entry = _entries[i % g_maxEntries];
+            size_t skip = (i == _head) ? _offset : 0;
+
+            iov[count].iov_base = entry.data + skip;
+            iov[count].iov_len = entry.len - skip;
+            count++;
+        }
+        _inFlight = count;
+    }
+
+    if (count == 0)
+    {
+        return true;
+    }
+
+    ssize_t written = writev(fd, iov, (int)count);
+    int err = errno;
+
+    _stats.writeCalls.fetch_add(1, std::memory_order_relaxed);
+
+    // The lines in flight can't change until _inFlight is cleared,
+    // so they are copied out without the lock
+    if ((written > 0) && (capture != 0) && capture->isOpen())
+    {
+        char buffer[g_maxEntries * (g_maxLineLen + 2)];
+        size_t len = 0;
+        for (size_t i = 0; (i < count) && (len < (size_t)written); i++)
+        {
+            size_t part = (iov[i].iov_len < (size_t)written - len) ? iov[i].iov_len
+                                                                   : (size_t)written - len;
+            memcpy(buffer + len, iov[i].iov_base, part);
+            len += part;
+        }
+        capture->record(TrafficCapture::TD_TX, buffer, len);
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _inFlight = 0;
+
+    if (written < 0)
+    {
+        if ((err == EAGAIN) || (err == EWOULDBLOCK) || (err == EINTR))
+        {
+            _stats.wouldBlock.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        return false;
+    }
+
+    _stats.bytesWritten.fetch_add(written, std::memory_order_relaxed);
+
+    size_t remaining = (size_t)written;
+    size_t completed = 0;
+    for (size_t i = 0; (i < count) && (remaining > 0); i++)
+    {
+        if (remaining >= iov[i].iov_len)
+        {
+            remaining -= iov[i].iov_len;
+            _head++;
+            _offset = 0;
+            completed++;
+        }
+        else
+        {
+            _offset += remaining;
+            remaining = 0;
+        }
+    }
+
+    if (completed < count)
+    {
+        _stats.partialWrites.fetch_add(1, std::memory_order_relaxed);
+    }
+    _stats.linesWritten.fetch_add(completed, std::memory_order_relaxed);
+
+    if (completed > 0)
+    {
+        _spaceCond.notify_all();
+    }
+
+    return true;
+}
+
+void CommandQueue::clearNotify()
+{
+    char scratch[64];
+    while (read(_pipefd[0], scratch, sizeof(scratch)) > 0)
+    {
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _notifyPending = false;
+}
+
+bool CommandQueue::hasPending() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    return (_tail != _head);
+}
+
+bool CommandQueue::waitEmpty(int timeoutMs)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    return _spaceCond.wait_for(lock,
+                               std::chrono::milliseconds(timeoutMs),
+                               [this] { return _tail == _head; });
+}
+
+void CommandQueue::notify()
+{
+    // Caller holds _mutex
+    if (!_notifyPending && (_pipefd[1] != -1))
+    {
+        char c = 0;
+        if (write(_pipefd[1], &c, 1) == 1)
+        {
+            _notifyPending = true;
+        }
+    }
+}
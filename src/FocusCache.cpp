@@ -0,0 +1,230 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "FocusCache.hpp"
+
+FocusCache::FocusCache()
+    : _count(0),
+      _binWidth(2.0)
+{
+}
+
+void FocusCache::setBinWidth(double degrees)
+{
+    if ((degrees <= 0) || (degrees == _binWidth))
+    {
+        return;
+    }
+
+    // Re-bin by each entry's centre temperature, merging entries
+    // that now share a bin
+    Entry old[g_maxEntries];
+    size_t count = _count;
+    memcpy(old, _entries, count * sizeof(Entry));
+    double oldWidth = _binWidth;
+
+    _binWidth = degrees;
+    _count = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        int16_t bin = (old[i].bin == g_noTempBin) ? g_noTempBin
+                                                  : binOf((old[i].bin + 0.5) * oldWidth);
+        merge(old[i].filter, bin, old[i].position, old[i].samples);
+    }
+}
+
+bool FocusCache::load(const char *path)
+{
+    FILE *fp = fopen(path, "r");
+    if (fp == nullptr)
+    {
+        return false;
+    }
+
+    _count = 0;
+
+    char line[128];
+    while (fgets(line, sizeof(line), fp) != nullptr)
+    {
+        if (line[0] == '#')
+        {
+            continue;
+        }
+
+        int filter = 0;
+        char temp[32];
+        unsigned position = 0;
+        unsigned samples = 0;
+        if (sscanf(line, "%d %31s %u %u", &filter, temp, &position, &samples) != 4)
+        {
+            continue;
+        }
+
+        int16_t bin = (strcmp(temp, "-") == 0) ? g_noTempBin : binOf(atof(temp));
+        merge(filter, bin, position, (samples > g_maxWeight) ? g_maxWeight : samples);
+    }
+
+    fclose(fp);
+
+    return true;
+}
+
+bool FocusCache::save(const char *path) const
+{
+    // Write a sibling file and rename it over the old one so a
+    // crash never leaves a truncated table
+    char tmpPath[1024];
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path);
+
+    FILE *fp = fopen(tmpPath, "w");
+    if (fp == nullptr)
+    {
+        return false;
+    }
+
+    fprintf(fp, "# filter temperature position samples\n");
+    for (size_t i = 0; i < _count; i++)
+    {
+        const Entry &e = _entries[i];
+        if (e.bin == g_noTempBin)
+        {
+            fprintf(fp, "%d - %u %u\n", e.filter, e.position, e.samples);
+        }
+        else
+        {
+            fprintf(fp, "%d %.2f %u %u\n", e.filter, binCentre(e.bin), e.position, e.samples);
+        }
+    }
+
+    bool ok = (fflush(fp) == 0);
+    ok = (fclose(fp) == 0) && ok;
+
+    return ok && (rename(tmpPath, path) == 0);
+}
+
+void FocusCache::entry(size_t i, int *filter, double *tempC, uint32_t *position, uint16_t *samples) const
+{
+    const Entry &e = _entries[i];
+
+    *filter = e.filter;
+    *tempC = (e.bin == g_noTempBin) ? NAN : binCentre(e.bin);
+    *position = e.position;
+    *samples = e.samples;
+}
+
+bool FocusCache::record(int filter, double tempC, uint32_t position)
+{
+    return merge(filter, binOf(tempC), position, 1);
+}
+
+bool FocusCache::predict(int filter, double tempC, uint32_t *position) const
+{
+    int16_t bin = binOf(tempC);
+
+    const Entry *below = nullptr;
+    const Entry *above = nullptr;
+    for (size_t i = 0; i < _count; i++)
+    {
+        const Entry &e = _entries[i];
+        if (e.filter != filter)
+        {
+            continue;
+        }
+
+        if (e.bin == bin)
+        {
+            *position = e.position;
+            return true;
+        }
+
+        if ((bin == g_noTempBin) || (e.bin == g_noTempBin))
+        {
+            continue;
+        }
+
+        if ((e.bin < bin) && ((below == nullptr) || (e.bin > below->bin)))
+        {
+            below = &e;
+        }
+        if ((e.bin > bin) && ((above == nullptr) || (e.bin < above->bin)))
+        {
+            above = &e;
+        }
+    }
+
+    if ((below != nullptr) && (above != nullptr))
+    {
+        double t = (tempC - binCentre(below->bin)) / (binCentre(above->bin) - binCentre(below->bin));
+        *position = (uint32_t)lround(below->position + t * ((double)above->position - below->position));
+        return true;
+    }
+
+    // With entries on one side only, a neighbouring bin is close
+    // enough to stand in; anything further says little about here
+    const Entry *nearest = (below != nullptr) ? below : above;
+    if ((nearest != nullptr) && (abs(nearest->bin - bin) <= g_maxNearestBins))
+    {
+        *position = nearest->position;
+        return true;
+    }
+
+    return false;
+}
+
+int16_t FocusCache::binOf(double tempC) const
+{
+    if (std::isnan(tempC))
+    {
+        return g_noTempBin;
+    }
+
+    double bin = floor(tempC / _binWidth);
+
+    return (int16_t)((bin < -32000) ? -32000 : (bin > 32000) ? 32000 : bin);
+}
+
+double FocusCache::binCentre(int16_t bin) const
+{
+    return (bin + 0.5) * _binWidth;
+}
+
+FocusCache::Entry *FocusCache::find(int filter, int16_t bin)
+{
+    for (size_t i = 0; i < _count; i++)
+    {
+        if ((_entries[i].filter == filter) && (_entries[i].bin == bin))
+        {
+            return &_entries[i];
+        }
+    }
+
+    return nullptr;
+}
+
+bool FocusCache::merge(int filter, int16_t bin, uint32_t position, uint16_t samples)
+{
+    Entry *e = find(filter, bin);
+    if (e == nullptr)
+    {
+        if (_count == g_maxEntries)
+        {
+            return false;
+        }
+
+        e = &_entries[_count++];
+        e->filter = (int16_t)filter;
+        e->bin = bin;
+        e->position = position;
+        e->samples = samples;
+        return true;
+    }
+
+    uint16_t weight = (e->samples > g_maxWeight) ? g_maxWeight : e->samples;
+    e->position = (uint32_t)lround(((double)e->position * weight + (double)position * samples) /
+                                   (weight + samples));
+    e->samples = (e->samples + samples > g_maxWeight) ? g_maxWeight : e->samples + samples;
+
+    return true;
+}
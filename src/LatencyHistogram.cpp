@@ -0,0 +1,71 @@
+#include "LatencyHistogram.hpp"
+
+LatencyHistogram::LatencyHistogram()
+{
+    reset();
+}
+
+void LatencyHistogram::record(uint64_t us)
+{
+    int idx = 0;
+    for (uint64_t v = us; (v > 1) && (idx < g_bucketCount - 1); v >>= 1)
+    {
+        idx++;
+    }
+
+    _buckets[idx].fetch_add(1, std::memory_order_relaxed);
+    _count.fetch_add(1, std::memory_order_relaxed);
+    _sumUs.fetch_add(us, std::memory_order_relaxed);
+
+    uint64_t prevMax = _maxUs.load(std::memory_order_relaxed);
+    while ((us > prevMax) &&
+           !_maxUs.compare_exchange_weak(prevMax, us,
+                                         std::memory_order_relaxed))
+    {
+    }
+}
+
+void LatencyHistogram::reset()
+{
+    _count.store(0, std::memory_order_relaxed);
+    _sumUs.store(0, std::memory_order_relaxed);
+    _maxUs.store(0, std::memory_order_relaxed);
+    for (int i = 0; i < g_bucketCount; i++)
+    {
+        _buckets[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+double LatencyHistogram::meanUs() const
+{
+    uint64_t n = count();
+
+    return (n == 0) ? 0.0 : (double)sumUs() / n;
+}
+
+uint64_t LatencyHistogram::percentileUs(double pct) const
+{
+    uint64_t n = count();
+    if (n == 0)
+    {
+        return 0;
+    }
+
+    uint64_t target = (uint64_t)(n * pct / 100.0);
+    if (target >= n)
+    {
+        target = n - 1;
+    }
+
+    uint64_t seen = 0;
+    for (int i = 0; i < g_bucketCount; i++)
+    {
+        seen += bucket(i);
+        if (seen > target)
+        {
+            return (uint64_t)2 << i;
+        }
+    }
+
+    return maxUs();
+}
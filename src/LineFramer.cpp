@@ -0,0 +1,341 @@
+#include <cstring>
+#include <sys/uio.h>
+
+#include "BinaryFrame.hpp"
+#include "LineFramer.hpp"
+
+LineFramer::LineFramer(Listener *listener,
+                       size_t capacity,
+                       size_t maxLineLen)
+    : _listener(listener),
+      _capacity(1),
+      _mask(0),
+      _maxLineLen(maxLineLen),
+      _ring(0),
+      _scratch(0),
+      _head(0),
+      _scan(0),
+      _tail(0),
+      _discarding(false),
+      _framed(false),
+      _lineCount(0),
+      _overflowCount(0),
+      _frameCount(0),
+      _corruptCount(0)
+{
+    // The ring must always be able to hold a maximum length line
+    // plus its delimiter with room to spare for the next read
+    if (capacity < 2 * (_maxLineLen + 2))
+    {
+        capacity = 2 * (_maxLineLen + 2);
+    }
+    if (capacity < 2 * BinaryFrame::g_maxFrame)
+    {
+        capacity = 2 * BinaryFrame::g_maxFrame;
+    }
+
+    while (_capacity < capacity)
+    {
+        _capacity <<= 1;
+    }
+    _mask = _capacity - 1;
+
+    _ring = new char[_capacity + 1];
+    size_t scratchLen = (_maxLineLen > BinaryFrame::g_maxFrame) ? _maxLineLen : BinaryFrame::g_maxFrame;
+    _scratch = new char[scratchLen + 1];
+}
+
+LineFramer::~LineFramer()
+{
+    delete[] _ring;
+    delete[] _scratch;
+}
+
+ssize_t LineFramer::readFrom(int fd)
+{
+    size_t freeBytes = _capacity - (size_t)(_tail - _head);
+    size_t tailIdx = (size_t)(_tail & _mask);
+
+    // Free space is at most two spans: from the tail to the end of
+    // the ring and from the start of the ring up to the head
+    struct iovec iov[2];
+    int iovcnt = 1;
+
+    iov[0].iov_base = _ring + tailIdx;
+    if (tailIdx + freeBytes <= _capacity)
+    {
+        iov[0].iov_len = freeBytes;
+    }
+    else
+    {
+        iov[0].iov_len = _capacity - tailIdx;
+        iov[1].iov_base = _ring;
+        iov[1].iov_len = freeBytes - iov[0].iov_len;
+        iovcnt = 2;
+    }
+
+    ssize_t bytesRead = readv(fd, iov, iovcnt);
+    if (bytesRead > 0)
+    {
+        _tail += bytesRead;
+        frame();
+    }
+
+    return bytesRead;
+}
+
+void LineFramer::push(const char *data, size_t len)
+{
+    while (len > 0)
+    {
+        size_t freeBytes = _capacity - (size_t)(_tail - _head);
+        size_t tailIdx = (size_t)(_tail & _mask);
+        size_t chunk = _capacity - tailIdx;
+        if (chunk > freeBytes)
+        {
+            chunk = freeBytes;
+        }
+        if (chunk > len)
+        {
+            chunk = len;
+        }
+
+        memcpy(_ring + tailIdx, data, chunk);
+        _tail += chunk;
+        data += chunk;
+        len -= chunk;
+
+        frame();
+    }
+}
+
+void LineFramer::reset()
+{
+    _head = _tail;
+    _scan = _tail;
+    _discarding = false;
+}
+
+void LineFramer::setFramed(bool framed)
+{
+    _framed = framed;
+    _discarding = false;
+    _scan = _head;
+}
+
+void LineFramer::frame()
+{
+    while (_scan < _tail)
+    {
+        if (_framed)
+        {
+            if (!deframe())
+            {
+                break;
+            }
+            continue;
+        }
+
+        // Search the contiguous part of the unscanned region
+        size_t scanIdx = (size_t)(_scan & _mask);
+        size_t span = (size_t)(_tail - _scan);
+        if (scanIdx + span > _capacity)
+        {
+            span = _capacity - scanIdx;
+        }
+
+        const char *lf = (const char *)memchr(_ring + scanIdx, '\n', span);
+        if (lf == 0)
+        {
+            _scan += span;
+            continue;
+        }
+
+        uint64_t lineEnd = _scan + (lf - (_ring + scanIdx));
+
+        if (_discarding)
+        {
+            // Tail end of an overlong line; drop it and resync
+            _discarding = false;
+        }
+        else
+        {
+            deliver(lineEnd);
+        }
+
+        _head = lineEnd + 1;
+        _scan = _head;
+    }
+
+    // Put a bound on partial lines
+    if (!_framed && !_discarding && ((size_t)(_tail - _head) > _maxLineLen))
+    {
+        _discarding = true;
+        _overflowCount++;
+        _listener->lineOverflow((size_t)(_tail - _head));
+    }
+
+    if (_discarding)
+    {
+        _head = _tail;
+        _scan = _tail;
+    }
+}
+
+void LineFramer::deliver(uint64_t lineEnd)
+{
+    size_t len = (size_t)(lineEnd - _head);
+
+    // Strip the CR of a CR/LF pair
+    if ((len > 0) && (_ring[(lineEnd - 1) & _mask] == '\r'))
+    {
+        len--;
+    }
+
+    if (len > _maxLineLen)
+    {
+        _overflowCount++;
+        _listener->lineOverflow(len);
+        return;
+    }
+
+    size_t headIdx = (size_t)(_head & _mask);
+    char *line = 0;
+
+    if (headIdx + len <= _capacity)
+    {
+        // Contiguous; terminate in place over the delimiter
+        line = _ring + headIdx;
+    }
+    else
+    {
+        // Wrapped around the end of the ring
+        size_t first = _capacity - headIdx;
+        memcpy(_scratch, _ring + headIdx, first);
+        memcpy(_scratch + first, _ring, len - first);
+        line = _scratch;
+    }
+    line[len] = 0;
+
+    _lineCount++;
+    _listener->lineReceived(line, len);
+}
+
+bool LineFramer::deframe()
+{
+    size_t headIdx = (size_t)(_head & _mask);
+    size_t avail = (size_t)(_tail - _head);
+
+    if (_ring[headIdx] == BinaryFrame::g_textMark)
+    {
+        return textLine();
+    }
+
+    if ((uint8_t)_ring[headIdx] != BinaryFrame::g_sync)
+    {
+        // Noise or the rest of a bad frame; skip to the next sync
+        // byte in the contiguous part of the ring
+        size_t span = (headIdx + avail > _capacity) ? _capacity - headIdx : avail;
+        const char *sync = (const char *)memchr(_ring + headIdx, BinaryFrame::g_sync, span);
+        _head += (sync != 0) ? (uint64_t)(sync - (_ring + headIdx)) : span;
+        _scan = _head;
+        return true;
+    }
+
+    if (avail < 2)
+    {
+        return false;
+    }
+
+    size_t body = (uint8_t)_ring[(_head + 1) & _mask];
+    size_t total = body + BinaryFrame::g_overhead;
+    if (body == 0)
+    {
+        _corruptCount++;
+        _listener->frameCorrupt();
+        _head++;
+        _scan = _head;
+        return true;
+    }
+
+    if (avail < total)
+    {
+        return false;
+    }
+
+    uint8_t *frame = (uint8_t *)_ring + headIdx;
+    if (headIdx + total > _capacity)
+    {
+        size_t first = _capacity - headIdx;
+        memcpy(_scratch, _ring + headIdx, first);
+        memcpy(_scratch + first, _ring, total - first);
+        frame = (uint8_t *)_scratch;
+    }
+
+    uint16_t crc = (uint16_t)((frame[body + 2] << 8) | frame[body + 3]);
+    if (BinaryFrame::crc16(frame + 1, body + 1) != crc)
+    {
+        _corruptCount++;
+        _listener->frameCorrupt();
+        _head++;
+        _scan = _head;
+        return true;
+    }
+
+    _head += total;
+    _scan = _head;
+    _frameCount++;
+
+    uint8_t type = frame[2];
+    uint8_t *payload = frame + 3;
+    size_t len = body - 1;
+    if (type == BinaryFrame::FT_LINE)
+    {
+        // Terminate over the CRC, which has been checked
+        payload[len] = 0;
+        _lineCount++;
+        _listener->lineReceived((char *)payload, len);
+    }
+    else
+    {
+        _listener->frameReceived(type, payload, len);
+    }
+
+    return true;
+}
+
+bool LineFramer::textLine()
+{
+    // A line ends before any sync byte; if one comes first this was
+    // noise, and the frame that follows is resynced on
+    size_t avail = (size_t)(_tail - _head);
+    size_t limit = (avail < _maxLineLen + 2) ? avail : _maxLineLen + 2;
+    for (size_t i = 1; i < limit; i++)
+    {
+        uint64_t at = _head + i;
+        char c = _ring[at & _mask];
+        if (c == '\n')
+        {
+            deliver(at);
+            _head = at + 1;
+            _scan = _head;
+            return true;
+        }
+        if ((uint8_t)c == BinaryFrame::g_sync)
+        {
+            _head = at;
+            _scan = _head;
+            return true;
+        }
+    }
+
+    if (limit == avail)
+    {
+        return false;
+    }
+
+    // Too long to be a negotiation line
+    _head++;
+    _scan = _head;
+    return true;
+}
@@ -0,0 +1,212 @@
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "LogRing.hpp"
+
+LogRing::LogRing()
+    : _wakeupPending(false),
+      _dropped(0)
+{
+    _pipefd[0] = -1;
+    _pipefd[1] = -1;
+
+    for (int i = 0; i < LC_COUNT; i++)
+    {
+        _levels[i].store(LL_INFO, std::memory_order_relaxed);
+    }
+}
+
+LogRing::~LogRing()
+{
+    close();
+}
+
+bool LogRing::open()
+{
+    return (pipe2(_pipefd, O_NONBLOCK | O_CLOEXEC) == 0);
+}
+
+void LogRing::close()
+{
+    for (int i = 0; i < 2; i++)
+    {
+        if (_pipefd[i] != -1)
+        {
+            ::close(_pipefd[i]);
+            _pipefd[i] = -1;
+        }
+    }
+}
+
+void LogRing::setLevel(Category category, Level level)
+{
+    _levels[category].store(level, std::memory_order_relaxed);
+}
+
+LogRing::Level LogRing::level(Category category) const
+{
+    return (Level)_levels[category].load(std::memory_order_relaxed);
+}
+
+void LogRing::drain(Sink *sink)
+{
+    char scratch[64];
+    while (read(_pipefd[0], scratch, sizeof(scratch)) > 0)
+    {
+    }
+
+    _wakeupPending.store(false, std::memory_order_release);
+
+    char msg[512];
+    Record rec;
+    while (_queue.pop(rec))
+    {
+        format(rec, msg, sizeof(msg));
+        sink->logRecord((Level)rec.level, (Category)rec.category, msg);
+    }
+}
+
+void LogRing::setArg(Arg &arg, Record &rec, const char *v)
+{
+    // Only one string is kept; any further ones are elided
+    arg.type = Arg::AT_TEXT;
+    arg.i = (rec.text[0] == 0) ? 0 : -1;
+
+    if (arg.i == 0)
+    {
+        strncpy(rec.text, (v != 0) ? v : "(null)", g_maxText - 1);
+        rec.text[g_maxText - 1] = 0;
+    }
+}
+
+void LogRing::push(const Record &rec)
+{
+    if (!_queue.push(rec))
+    {
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    if (!_wakeupPending.exchange(true, std::memory_order_acq_rel))
+    {
+        char c = 0;
+        if (write(_pipefd[1], &c, 1) != 1)
+        {
+            _wakeupPending.store(false, std::memory_order_release);
+        }
+    }
+}
+
+/* static */ void LogRing::format(const Record &rec, char *buf, size_t len)
+{
+    // Walk the format string and render each conversion with the
+    // type that was actually recorded, so a mismatch between the
+    // format and the argument can never read the wrong vararg
+    size_t out = 0;
+    size_t argIdx = 0;
+    const char *p = rec.fmt;
+
+    while ((*p != 0) && (out + 1 < len))
+    {
+        if (*p != '%')
+        {
+            buf[out++] = *p++;
+            continue;
+        }
+
+        if (p[1] == '%')
+        {
+            buf[out++] = '%';
+            p += 2;
+            continue;
+        }
+
+        // Copy flags, width and precision; drop length modifiers
+        char spec[32];
+        size_t specLen = 0;
+        spec[specLen++] = *p++;
+        while ((*p != 0) && (strchr("-+ #0123456789.", *p) != 0) && (specLen < 20))
+        {
+            spec[specLen++] = *p++;
+        }
+        while ((*p != 0) && (strchr("hlLqjzt", *p) != 0))
+        {
+            p++;
+        }
+
+        char conv = *p;
+        if (conv == 0)
+        {
+            break;
+        }
+        p++;
+
+        if (argIdx >= rec.argc)
+        {
+            continue;
+        }
+        const Arg &arg = rec.args[argIdx++];
+
+        int n = 0;
+        switch (conv)
+        {
+        case 'd':
+        case 'i':
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o':
+        case 'c':
+        {
+            long long v = (arg.type == Arg::AT_DOUBLE) ? (long long)arg.d : arg.i;
+            if (conv == 'c')
+            {
+                spec[specLen++] = 'c';
+                spec[specLen] = 0;
+                n = snprintf(buf + out, len - out, spec, (int)v);
+            }
+            else
+            {
+                spec[specLen++] = 'l';
+                spec[specLen++] = 'l';
+                spec[specLen++] = conv;
+                spec[specLen] = 0;
+                n = snprintf(buf + out, len - out, spec, v);
+            }
+            break;
+        }
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        {
+            double v = (arg.type == Arg::AT_DOUBLE) ? arg.d
+                       : (arg.type == Arg::AT_UINT) ? (double)arg.u
+                                                    : (double)arg.i;
+            spec[specLen++] = conv;
+            spec[specLen] = 0;
+            n = snprintf(buf + out, len - out, spec, v);
+            break;
+        }
+        case 's':
+            spec[specLen++] = 's';
+            spec[specLen] = 0;
+            n = snprintf(buf + out, len - out, spec,
+                         ((arg.type == Arg::AT_TEXT) && (arg.i == 0)) ? rec.text : "...");
+            break;
+        default:
+            break;
+        }
+
+        if (n > 0)
+        {
+            out += ((size_t)n < len - out) ? (size_t)n : len - out - 1;
+        }
+    }
+
+    buf[out] = 0;
+}
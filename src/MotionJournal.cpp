@@ -0,0 +1,233 @@
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "MonotonicClock.hpp"
+#include "MotionJournal.hpp"
+
+static const char g_magic[8] = {'R', 'K', 'S', 'J', 'R', 'N', 'L', 0};
+
+MotionJournal::MotionJournal()
+    : _header(nullptr),
+      _records(nullptr),
+      _mapSize(0),
+      _writable(false),
+      _appending(false)
+{
+}
+
+MotionJournal::~MotionJournal()
+{
+    close();
+}
+
+bool MotionJournal::open(const char *path, size_t capacity)
+{
+    close();
+
+    if (capacity == 0)
+    {
+        return false;
+    }
+
+    int fd = ::open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd == -1)
+    {
+        return false;
+    }
+
+    size_t size = sizeof(Header) + capacity * sizeof(Record);
+
+    struct stat st;
+    bool fresh = (fstat(fd, &st) != 0) || ((size_t)st.st_size != size);
+
+    // Allocate every block up front; a store into a hole of a sparse
+    // file raises SIGBUS if the filesystem has filled up meanwhile
+    if ((fresh && (ftruncate(fd, 0) != 0)) || (posix_fallocate(fd, 0, size) != 0))
+    {
+        ::close(fd);
+        return false;
+    }
+
+    void *map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED)
+    {
+        return false;
+    }
+
+    _header = (Header *)map;
+    _records = (Record *)(_header + 1);
+    _mapSize = size;
+    _writable = true;
+
+    if (fresh ||
+        (memcmp(_header->magic, g_magic, sizeof(g_magic)) != 0) ||
+        (_header->version != g_version) ||
+        (_header->recordSize != sizeof(Record)) ||
+        (_header->capacity != capacity))
+    {
+        memset(map, 0, size);
+        memcpy(_header->magic, g_magic, sizeof(g_magic));
+        _header->version = g_version;
+        _header->recordSize = sizeof(Record);
+        _header->capacity = capacity;
+        _header->count = 0;
+    }
+
+    append(JE_OPEN);
+
+    return true;
+}
+
+bool MotionJournal::openReadOnly(const char *path)
+{
+    close();
+
+    int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+    {
+        return false;
+    }
+
+    struct stat st;
+    if ((fstat(fd, &st) != 0) || ((size_t)st.st_size < sizeof(Header)))
+    {
+        ::close(fd);
+        return false;
+    }
+
+    void *map = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED)
+    {
+        return false;
+    }
+
+    _header = (Header *)map;
+    _records = (Record *)(_header + 1);
+    _mapSize = st.st_size;
+    _writable = false;
+
+    if ((memcmp(_header->magic, g_magic, sizeof(g_magic)) != 0) ||
+        (_header->version != g_version) ||
+        (_header->recordSize != sizeof(Record)) ||
+        (_header->capacity == 0) ||
+        (sizeof(Header) + _header->capacity * sizeof(Record) > _mapSize))
+    {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void MotionJournal::close()
+{
+    if (_header == nullptr)
+    {
+        return;
+    }
+
+    if (_writable)
+    {
+        msync(_header, _mapSize, MS_ASYNC);
+    }
+    munmap(_header, _mapSize);
+
+    _header = nullptr;
+    _records = nullptr;
+    _mapSize = 0;
+    _writable = false;
+}
+
+void MotionJournal::append(EventType type, uint32_t a, uint32_t b)
+{
+    if (!_writable)
+    {
+        return;
+    }
+
+    while (_appending.exchange(true, std::memory_order_acquire))
+    {
+    }
+
+    uint64_t index = _header->count;
+    Record &rec = _records[index % _header->capacity];
+
+    // Invalidate the slot before filling it, then publish its
+    // sequence number and the new count
+    __atomic_store_n(&rec.seq, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    rec.timeNs = realtimeNs();
+    rec.type = (uint16_t)type;
+    rec.reserved = 0;
+    rec.a = a;
+    rec.b = b;
+
+    __atomic_store_n(&rec.seq, (uint32_t)(index + 1), __ATOMIC_RELEASE);
+    __atomic_store_n(&_header->count, index + 1, __ATOMIC_RELEASE);
+
+    _appending.store(false, std::memory_order_release);
+}
+
+uint64_t MotionJournal::first() const
+{
+    uint64_t count = end();
+
+    return (count > _header->capacity) ? count - _header->capacity : 0;
+}
+
+uint64_t MotionJournal::end() const
+{
+    return (_header != nullptr) ? __atomic_load_n(&_header->count, __ATOMIC_ACQUIRE) : 0;
+}
+
+bool MotionJournal::read(uint64_t index, Record *rec) const
+{
+    if ((_header == nullptr) || (index < first()) || (index >= end()))
+    {
+        return false;
+    }
+
+    const Record &slot = _records[index % _header->capacity];
+    uint32_t seq = __atomic_load_n(&slot.seq, __ATOMIC_ACQUIRE);
+    *rec = slot;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+    // Reject a slot that was rewritten underneath the copy
+    return (seq == (uint32_t)(index + 1)) &&
+           (__atomic_load_n(&slot.seq, __ATOMIC_RELAXED) == seq);
+}
+
+/* static */ const char *MotionJournal::eventName(uint16_t type)
+{
+    switch (type)
+    {
+    case JE_OPEN:
+        return "open";
+    case JE_MOVING_REL:
+        return "moving_rel";
+    case JE_MOVING_ABS:
+        return "moving_abs";
+    case JE_STOPPED:
+        return "stopped";
+    case JE_POSITION:
+        return "position";
+    case JE_ZEROED:
+        return "zeroed";
+    case JE_MICROSTEPS:
+        return "microsteps";
+    case JE_BACKLASH_ENABLED:
+        return "backlash_enabled";
+    case JE_BACKLASH_STEPS:
+        return "backlash_steps";
+    case JE_OFFSET:
+        return "offset";
+    }
+
+    return "unknown";
+}
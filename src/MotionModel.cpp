@@ -0,0 +1,200 @@
+#include <cmath>
+
+#include "MotionModel.hpp"
+
+MotionModel::MotionModel()
+    : _rate(1000.0),
+      _accel(0.0),
+      _moving(false),
+      _from(0),
+      _to(0),
+      _startNs(0),
+      _dead(0),
+      _distance(0),
+      _accelTime(0),
+      _accelDist(0),
+      _cruiseTime(0),
+      _peakRate(0),
+      _totalTime(0)
+{
+}
+
+void MotionModel::setProfile(double stepRate, double accel)
+{
+    _rate = (stepRate > 0) ? stepRate : 1.0;
+    _accel = (accel > 0) ? accel : 0.0;
+
+    if (_moving)
+    {
+        plan();
+    }
+}
+
+void MotionModel::start(uint32_t from,
+                        uint32_t to,
+                        uint64_t nowNs,
+                        uint32_t deadSteps)
+{
+    _from = from;
+    _to = to;
+    _startNs = nowNs;
+    _dead = deadSteps;
+    _distance = _dead + ((to > from) ? to - from : from - to);
+    _moving = true;
+
+    plan();
+}
+
+void MotionModel::correct(uint32_t position, uint64_t nowNs)
+{
+    if (!_moving || (position == _from))
+    {
+        // Still taking up backlash or not started; no information
+        return;
+    }
+
+    double travelled = _dead + ((position > _from) ? position - _from : _from - position);
+    if (travelled > _distance)
+    {
+        travelled = _distance;
+    }
+
+    uint64_t offsetNs = (uint64_t)(timeAt(travelled) * 1e9);
+    _startNs = (nowNs > offsetNs) ? nowNs - offsetNs : 0;
+}
+
+void MotionModel::stop(uint32_t position)
+{
+    _moving = false;
+    _from = position;
+    _to = position;
+}
+
+uint32_t MotionModel::predict(uint64_t nowNs) const
+{
+    if (!_moving)
+    {
+        return _to;
+    }
+
+    double t = (nowNs > _startNs) ? (nowNs - _startNs) / 1e9 : 0.0;
+    double moved = distanceAt(t) - _dead;
+    if (moved <= 0)
+    {
+        return _from;
+    }
+
+    uint32_t steps = (uint32_t)moved;
+
+    return (_to > _from) ? _from + steps : _from - steps;
+}
+
+double MotionModel::remaining(uint64_t nowNs) const
+{
+    if (!_moving)
+    {
+        return 0.0;
+    }
+
+    double t = (nowNs > _startNs) ? (nowNs - _startNs) / 1e9 : 0.0;
+
+    return (t < _totalTime) ? _totalTime - t : 0.0;
+}
+
+double MotionModel::duration(uint32_t steps, uint32_t deadSteps) const
+{
+    MotionModel m(*this);
+    m._dead = deadSteps;
+    m._distance = (double)deadSteps + steps;
+    m.plan();
+
+    return m._totalTime;
+}
+
+double MotionModel::distanceAt(double t) const
+{
+    if (t <= 0)
+    {
+        return 0;
+    }
+
+    if (t < _accelTime)
+    {
+        return 0.5 * _accel * t * t;
+    }
+
+    t -= _accelTime;
+    if (t < _cruiseTime)
+    {
+        return _accelDist + _peakRate * t;
+    }
+
+    t -= _cruiseTime;
+    if (t < _accelTime)
+    {
+        return _accelDist + _peakRate * _cruiseTime + _peakRate * t - 0.5 * _accel * t * t;
+    }
+
+    return _distance;
+}
+
+double MotionModel::timeAt(double distance) const
+{
+    if (distance <= 0)
+    {
+        return 0;
+    }
+
+    if (distance < _accelDist)
+    {
+        return sqrt(2.0 * distance / _accel);
+    }
+
+    double cruiseDist = _peakRate * _cruiseTime;
+    if (distance < _accelDist + cruiseDist)
+    {
+        return _accelTime + (distance - _accelDist) / _peakRate;
+    }
+
+    double r = distance - _accelDist - cruiseDist;
+    if ((distance < _distance) && (_accel > 0))
+    {
+        double disc = _peakRate * _peakRate - 2.0 * _accel * r;
+        double td = (_peakRate - sqrt((disc > 0) ? disc : 0)) / _accel;
+        return _accelTime + _cruiseTime + td;
+    }
+
+    return _totalTime;
+}
+
+void MotionModel::plan()
+{
+    if (_accel <= 0)
+    {
+        _accelTime = 0;
+        _accelDist = 0;
+        _peakRate = _rate;
+        _cruiseTime = _distance / _rate;
+    }
+    else
+    {
+        _accelTime = _rate / _accel;
+        _accelDist = 0.5 * _accel * _accelTime * _accelTime;
+
+        if (2.0 * _accelDist >= _distance)
+        {
+            // Never reaches the step rate; triangular profile
+            _accelTime = sqrt(_distance / _accel);
+            _accelDist = _distance / 2.0;
+            _peakRate = _accel * _accelTime;
+            _cruiseTime = 0;
+        }
+        else
+        {
+            _peakRate = _rate;
+            _cruiseTime = (_distance - 2.0 * _accelDist) / _rate;
+        }
+    }
+
+    _totalTime = 2.0 * _accelTime + _cruiseTime;
+}
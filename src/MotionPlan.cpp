@@ -0,0 +1,113 @@
+#include "MotionPlan.hpp"
+
+MotionPlan::MotionPlan()
+    : _count(0),
+      _next(0),
+      _points(0),
+      _pointsDone(0),
+      _planPos(0),
+      _planDir(0),
+      _approachDir(1),
+      _overshoot(0),
+      _maxPos(0)
+{
+}
+
+void MotionPlan::begin(uint32_t from,
+                       int lastDir,
+                       int approachDir,
+                       uint32_t overshoot,
+                       uint32_t maxPos)
+{
+    clear();
+
+    _planPos = from;
+    _planDir = lastDir;
+    _approachDir = (approachDir < 0) ? -1 : 1;
+    _overshoot = overshoot;
+    _maxPos = maxPos;
+}
+
+void MotionPlan::clear()
+{
+    _count = 0;
+    _next = 0;
+    _points = 0;
+    _pointsDone = 0;
+}
+
+bool MotionPlan::approach(uint32_t target, StepKind kind, uint8_t profile)
+{
+    if (target > _maxPos)
+    {
+        target = _maxPos;
+    }
+
+    int dir = (target > _planPos) ? 1 : (target < _planPos) ? -1 : _planDir;
+
+    if ((dir != _approachDir) && (_overshoot > 0))
+    {
+        // Go past the target and come back in the approach direction
+        uint32_t waypoint = 0;
+        if (_approachDir > 0)
+        {
+            waypoint = (target > _overshoot) ? target - _overshoot : 0;
+        }
+        else
+        {
+            waypoint = ((uint64_t)target + _overshoot > _maxPos) ? _maxPos : target + _overshoot;
+        }
+
+        if (waypoint != target)
+        {
+            // Both steps or neither
+            if (_count + 2 > g_maxSteps)
+            {
+                return false;
+            }
+            add(waypoint, SK_WAYPOINT, profile);
+        }
+    }
+
+    return add(target, kind, profile);
+}
+
+bool MotionPlan::add(uint32_t target, StepKind kind, uint8_t profile)
+{
+    if (_count == g_maxSteps)
+    {
+        return false;
+    }
+
+    if (target != _planPos)
+    {
+        _planDir = (target > _planPos) ? 1 : -1;
+    }
+    _planPos = target;
+
+    _steps[_count].position = target;
+    _steps[_count].kind = kind;
+    _steps[_count].profile = profile;
+    _count++;
+
+    if (kind == SK_POINT)
+    {
+        _points++;
+    }
+
+    return true;
+}
+
+void MotionPlan::advance()
+{
+    if (!active())
+    {
+        return;
+    }
+
+    if (_steps[_next].kind == SK_POINT)
+    {
+        _pointsDone++;
+    }
+    _next++;
+}
@@ -0,0 +1,85 @@
+#include "MoveTiming.hpp"
+
+MoveTiming::MoveTiming()
+    : _running(false),
+      _complete(false),
+      _startPos(0),
+      _startNs(0),
+      _stopPos(0),
+      _stopNs(0),
+      _samples(0),
+      _firstPos(0),
+      _firstNs(0),
+      _lastPos(0),
+      _lastNs(0)
+{
+}
+
+void MoveTiming::start(uint32_t position, uint64_t nowNs)
+{
+    _running = true;
+    _complete = false;
+    _startPos = position;
+    _startNs = nowNs;
+    _samples = 0;
+}
+
+void MoveTiming::sample(uint32_t position, uint64_t nowNs)
+{
+    if (!_running)
+    {
+        return;
+    }
+
+    // Reports before the counter starts moving belong to the
+    // dead travel, not the cruise
+    if (position == _startPos)
+    {
+        return;
+    }
+
+    if (_samples == 0)
+    {
+        _firstPos = position;
+        _firstNs = nowNs;
+    }
+    _lastPos = position;
+    _lastNs = nowNs;
+    _samples++;
+}
+
+void MoveTiming::stop(uint32_t position, uint64_t nowNs)
+{
+    if (!_running)
+    {
+        return;
+    }
+
+    _running = false;
+    _complete = true;
+    _stopPos = position;
+    _stopNs = nowNs;
+}
+
+double MoveTiming::duration() const
+{
+    return (_stopNs > _startNs) ? (_stopNs - _startNs) / 1e9 : 0.0;
+}
+
+uint32_t MoveTiming::distance() const
+{
+    return (_stopPos > _startPos) ? _stopPos - _startPos : _startPos - _stopPos;
+}
+
+double MoveTiming::rate() const
+{
+    if ((_samples >= 2) && (_lastPos != _firstPos) && (_lastNs > _firstNs))
+    {
+        uint32_t steps = (_lastPos > _firstPos) ? _lastPos - _firstPos : _firstPos - _lastPos;
+        return steps / ((_lastNs - _firstNs) / 1e9);
+    }
+
+    double secs = duration();
+
+    return (secs > 0) ? distance() / secs : 0.0;
+}
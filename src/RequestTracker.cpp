@@ -0,0 +1,188 @@
+#include "RequestTracker.hpp"
+
+RequestTracker::RequestTracker()
+    : _count(0)
+{
+}
+
+bool RequestTracker::issued(Command cmd, uint64_t nowNs, uint32_t timeoutMs)
+{
+    if (_count == g_maxInFlight)
+    {
+        return false;
+    }
+
+    Request &req = _inFlight[_count++];
+    req.cmd = cmd;
+    req.issuedNs = nowNs;
+    req.deadlineNs = nowNs + (uint64_t)timeoutMs * 1000000ULL;
+
+    return true;
+}
+
+bool RequestTracker::completed(Reply reply,
+                               uint64_t nowNs,
+                               Command *cmd,
+                               uint64_t *latencyUs)
+{
+    for (int i = 0; i < _count; i++)
+    {
+        if (replyFor(_inFlight[i].cmd) == reply)
+        {
+            Command done = _inFlight[i].cmd;
+            if (cmd != 0)
+            {
+                *cmd = done;
+            }
+
+            if (!isTelemetry(reply))
+            {
+                uint64_t us = (nowNs - _inFlight[i].issuedNs) / 1000;
+                _histograms[done].record(us);
+
+                if (latencyUs != 0)
+                {
+                    *latencyUs = us;
+                }
+            }
+
+            remove(i);
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+int RequestTracker::expire(uint64_t nowNs, Command *expired, int max)
+{
+    int n = 0;
+    int i = 0;
+    while ((i < _count) && (n < max))
+    {
+        if (nowNs >= _inFlight[i].deadlineNs)
+        {
+            expired[n++] = _inFlight[i].cmd;
+            remove(i);
+        }
+        else
+        {
+            i++;
+        }
+    }
+
+    return n;
+}
+
+void RequestTracker::clear()
+{
+    _count = 0;
+}
+
+bool RequestTracker::pending(Command cmd) const
+{
+    for (int i = 0; i < _count; i++)
+    {
+        if (_inFlight[i].cmd == cmd)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* static */ RequestTracker::Reply RequestTracker::replyFor(Command cmd)
+{
+    switch (cmd)
+    {
+    case CMD_FOCUS_REL:
+        return RP_MOVING_REL;
+    case CMD_FOCUS_ABS:
+        return RP_MOVING_ABS;
+    case CMD_FOCUS_ABORT:
+        return RP_STOPPED;
+    case CMD_ENABLE_MOTOR:
+    case CMD_GET_MOTOR_ENABLED:
+        return RP_MOTOR_ENABLED;
+    case CMD_ZERO:
+        return RP_ZEROED;
+    case CMD_SET_MICROSTEP:
+    case CMD_GET_MICROSTEP:
+        return RP_MICROSTEPS;
+    case CMD_SET_SPEED:
+    case CMD_GET_SPEED:
+        return RP_SPEED;
+    case CMD_ENABLE_BACKLASH:
+    case CMD_GET_BACKLASH_ENABLED:
+        return RP_BACKLASH_ENABLED;
+    case CMD_SET_BACKLASH_STEPS:
+    case CMD_GET_BACKLASH_STEPS:
+        return RP_BACKLASH_STEPS;
+    case CMD_GET_POS:
+        return RP_POSITION;
+    case CMD_GET_MAX_POS:
+    case CMD_COUNT:
+        break;
+    }
+
+    return RP_MAX_POS;
+}
+
+/* static */ bool RequestTracker::isTelemetry(Reply reply)
+{
+    return (reply == RP_POSITION) || (reply == RP_STOPPED);
+}
+
+/* static */ const char *RequestTracker::commandName(Command cmd)
+{
+    switch (cmd)
+    {
+    case CMD_FOCUS_REL:
+        return "focusRel";
+    case CMD_FOCUS_ABS:
+        return "focusAbs";
+    case CMD_FOCUS_ABORT:
+        return "focusAbort";
+    case CMD_ENABLE_MOTOR:
+        return "enableMotor";
+    case CMD_ZERO:
+        return "zero";
+    case CMD_SET_MICROSTEP:
+        return "setMicrostep";
+    case CMD_SET_SPEED:
+        return "setSpeed";
+    case CMD_ENABLE_BACKLASH:
+        return "enableBacklash";
+    case CMD_SET_BACKLASH_STEPS:
+        return "setBacklashSteps";
+    case CMD_GET_MOTOR_ENABLED:
+        return "getMotorEnabled";
+    case CMD_GET_POS:
+        return "getPos";
+    case CMD_GET_MAX_POS:
+        return "getMaxPos";
+    case CMD_GET_MICROSTEP:
+        return "getMicrostep";
+    case CMD_GET_SPEED:
+        return "getSpeed";
+    case CMD_GET_BACKLASH_ENABLED:
+        return "getBacklashEnabled";
+    case CMD_GET_BACKLASH_STEPS:
+        return "getBacklashSteps";
+    case CMD_COUNT:
+        break;
+    }
+
+    return "unknown";
+}
+
+void RequestTracker::remove(int idx)
+{
+    for (int i = idx + 1; i < _count; i++)
+    {
+        _inFlight[i - 1] = _inFlight[i];
+    }
+    _count--;
+}
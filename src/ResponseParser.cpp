@@ -0,0 +1,318 @@
+#include <cstdio>
+#include <cstring>
+
+#include "FocuserComms.hpp"
+#include "FocuserCommsListener.hpp"
+#include "ResponseParser.hpp"
+
+// Renders single lines through the firmware side of the protocol
+class RenderWriter : public ELS::CommsWriter
+{
+public:
+    RenderWriter()
+        : lines(0)
+    {
+        line[0] = 0;
+    }
+
+    virtual bool writeLine(const char *text)
+    {
+        // The framer strips line endings, so the patterns must too
+        snprintf(line, sizeof(line), "%s", text);
+        size_t len = strlen(line);
+        while ((len > 0) && ((line[len - 1] == '\r') || (line[len - 1] == '\n')))
+        {
+            line[--len] = 0;
+        }
+        lines++;
+        return true;
+    }
+
+    virtual void close() {}
+
+    char line[128];
+    int lines;
+};
+
+class ProbeListener : public ELS::FocuserCommsListener
+{
+public:
+    virtual void focusRel(ELS::FocusDirection, uint32_t) {}
+    virtual void focusAbs(uint32_t) {}
+    virtual void focusAbort() {}
+    virtual void enableMotor(bool) {}
+    virtual void zero() {}
+    virtual void setMicrostep(ELS::Microsteps) {}
+    virtual void setSpeed(ELS::FocusSpeed) {}
+    virtual void enableBacklash(bool) {}
+    virtual void setBacklashSteps(uint32_t) {}
+    virtual void getMotorEnabled() {}
+    virtual void getPos() {}
+    virtual void getMaxPos() {}
+    virtual void getMicrostep() {}
+    virtual void getSpeed() {}
+    virtual void getBacklashEnabled() {}
+    virtual void getBacklashSteps() {}
+};
+
+// Renders one report of the given kind carrying value
+static bool render(ResponseParser::Kind kind, uint32_t value, RenderWriter *writer)
+{
+    ProbeListener listener;
+    ELS::FocuserComms comms(writer, &listener);
+
+    writer->lines = 0;
+    switch (kind)
+    {
+    case ResponseParser::RK_POSITION:
+        comms.position(value);
+        break;
+    case ResponseParser::RK_STOPPED:
+        comms.stopped(value);
+        break;
+    case ResponseParser::RK_MAX_POS:
+        comms.maxPos(value);
+        break;
+    case ResponseParser::RK_BACKLASH_STEPS:
+        comms.backlashSteps(value);
+        break;
+    default:
+        return false;
+    }
+
+    return (writer->lines == 1);
+}
+
+// Values whose decimal form is easy to find in a rendered line, and
+// the edge cases every learned pattern must reproduce
+static const uint32_t g_probe = 1234567u;
+static const uint32_t g_checks[] = {0u, 7u, 7654321u, 4294967295u};
+
+ResponseParser::ResponseParser()
+{
+    memset(_patterns, 0, sizeof(_patterns));
+    memset(_byFirst, 0, sizeof(_byFirst));
+}
+
+size_t ResponseParser::learn()
+{
+    size_t count = 0;
+    for (int k = 0; k < RK_COUNT; k++)
+    {
+        _patterns[k].valid = learnOne((Kind)k);
+    }
+    rebuildIndex();
+
+    // Reports the fast path doesn't handle must never match one that
+    // it does
+    RenderWriter writer;
+    ProbeListener listener;
+    ELS::FocuserComms comms(&writer, &listener);
+    for (int i = 0; i < 7; i++)
+    {
+        writer.lines = 0;
+        switch (i)
+        {
+        case 0:
+            comms.movingRel(ELS::FD_FOCUS_OUTWARD, g_probe);
+            break;
+        case 1:
+            comms.movingAbs(g_probe, g_probe + 1);
+            break;
+        case 2:
+            comms.motorEnabled(true);
+            break;
+        case 3:
+            comms.zeroed();
+            break;
+        case 4:
+            comms.microsteps(ELS::MS_X64);
+            break;
+        case 5:
+            comms.speed(ELS::FS_X3);
+            break;
+        default:
+            comms.backlashEnabled(true);
+            break;
+        }
+
+        Kind kind;
+        uint32_t value;
+        if ((writer.lines > 0) && match(writer.line, strlen(writer.line), &kind, &value))
+        {
+            _patterns[kind].valid = false;
+            rebuildIndex();
+        }
+    }
+
+    for (int k = 0; k < RK_COUNT; k++)
+    {
+        if (_patterns[k].valid)
+        {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+bool ResponseParser::dispatch(const char *line,
+                              size_t len,
+                              ELS::HostCommsListener *listener) const
+{
+    Kind kind;
+    uint32_t value;
+    if (!match(line, len, &kind, &value))
+    {
+        return false;
+    }
+
+    switch (kind)
+    {
+    case RK_POSITION:
+        listener->position(value);
+        break;
+    case RK_STOPPED:
+        listener->stopped(value);
+        break;
+    case RK_MAX_POS:
+        listener->maxPos(value);
+        break;
+    case RK_BACKLASH_STEPS:
+        listener->backlashSteps(value);
+        break;
+    default:
+        return false;
+    }
+
+    return true;
+}
+
+bool ResponseParser::match(const char *line, size_t len, Kind *kind, uint32_t *value) const
+{
+    if (len == 0)
+    {
+        return false;
+    }
+
+    uint8_t candidates = _byFirst[(uint8_t)line[0]];
+    for (int k = 0; candidates != 0; k++, candidates >>= 1)
+    {
+        if (!(candidates & 1))
+        {
+            continue;
+        }
+
+        const Pattern &p = _patterns[k];
+        size_t affix = (size_t)p.prefixLen + p.suffixLen;
+        if ((len <= affix) ||
+            (memcmp(line, p.prefix, p.prefixLen) != 0) ||
+            (memcmp(line + len - p.suffixLen, p.suffix, p.suffixLen) != 0))
+        {
+            continue;
+        }
+
+        if (parseUint(line + p.prefixLen, len - affix, value))
+        {
+            *kind = (Kind)k;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool ResponseParser::learnOne(Kind kind)
+{
+    RenderWriter writer;
+    if (!render(kind, g_probe, &writer))
+    {
+        return false;
+    }
+
+    char digits[16];
+    snprintf(digits, sizeof(digits), "%u", g_probe);
+
+    const char *at = strstr(writer.line, digits);
+    if ((at == nullptr) || (strstr(at + 1, digits) != nullptr))
+    {
+        return false;
+    }
+
+    size_t prefixLen = (size_t)(at - writer.line);
+    const char *suffix = at + strlen(digits);
+    size_t suffixLen = strlen(suffix);
+    if ((prefixLen == 0) || (prefixLen > g_maxAffix) || (suffixLen > g_maxAffix))
+    {
+        return false;
+    }
+
+    Pattern &p = _patterns[kind];
+    p.prefixLen = (uint8_t)prefixLen;
+    p.suffixLen = (uint8_t)suffixLen;
+    memcpy(p.prefix, writer.line, prefixLen);
+    memcpy(p.suffix, suffix, suffixLen);
+
+    // Only keep it if it reads back every check value exactly
+    for (size_t i = 0; i < sizeof(g_checks) / sizeof(g_checks[0]); i++)
+    {
+        if (!render(kind, g_checks[i], &writer))
+        {
+            return false;
+        }
+
+        size_t len = strlen(writer.line);
+        uint32_t value = 0;
+        if ((len <= prefixLen + suffixLen) ||
+            (memcmp(writer.line, p.prefix, prefixLen) != 0) ||
+            (memcmp(writer.line + len - suffixLen, p.suffix, suffixLen) != 0) ||
+            !parseUint(writer.line + prefixLen, len - prefixLen - suffixLen, &value) ||
+            (value != g_checks[i]))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void ResponseParser::rebuildIndex()
+{
+    memset(_byFirst, 0, sizeof(_byFirst));
+    for (int k = 0; k < RK_COUNT; k++)
+    {
+        if (_patterns[k].valid)
+        {
+            _byFirst[(uint8_t)_patterns[k].prefix[0]] |= (uint8_t)(1 << k);
+        }
+    }
+}
+
+/* static */ bool ResponseParser::parseUint(const char *p, size_t len, uint32_t *value)
+{
+    // At most 10 digits, checked for overflow once at the end
+    if ((len == 0) || (len > 10))
+    {
+        return false;
+    }
+
+    uint64_t v = 0;
+    for (size_t i = 0; i < len; i++)
+    {
+        unsigned d = (unsigned)(p[i] - '0');
+        if (d > 9)
+        {
+            return false;
+        }
+        v = v * 10 + d;
+    }
+
+    if (v > 0xffffffffULL)
+    {
+        return false;
+    }
+
+    *value = (uint32_t)v;
+
+    return true;
+}
@@ -0,0 +1,274 @@
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include "SerialReactor.hpp"
+
+SerialReactor::SerialReactor()
+    : _nextId(1),
+      _epfd(-1),
+      _running(false),
+      _failed(false)
+{
+    _pipefd[0] = -1;
+    _pipefd[1] = -1;
+
+    for (size_t i = 0; i < g_maxHandlers; i++)
+    {
+        _regs[i].id = 0;
+        _regs[i].handler = nullptr;
+        _regs[i].fdCount = 0;
+    }
+}
+
+SerialReactor::~SerialReactor()
+{
+    stop();
+}
+
+uint32_t SerialReactor::add(Handler *handler, const int *fds, size_t count)
+{
+    if (count > g_maxFds)
+    {
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (_failed)
+    {
+        // The thread has already exited, so this doesn't wait
+        stop();
+    }
+    if (!_running && !start())
+    {
+        return 0;
+    }
+
+    Registration *reg = find(0);
+    if (reg == nullptr)
+    {
+        return 0;
+    }
+
+    uint32_t id = _nextId++;
+    if (_nextId == 0)
+    {
+        _nextId = 1;
+    }
+
+    reg->id = id;
+    reg->handler = handler;
+    reg->fdCount = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.u64 = key(id, fds[i]);
+        if (epoll_ctl(_epfd, EPOLL_CTL_ADD, fds[i], &ev) != 0)
+        {
+            unwatch(*reg);
+            reg->id = 0;
+            return 0;
+        }
+        reg->fds[reg->fdCount++] = fds[i];
+    }
+
+    return id;
+}
+
+bool SerialReactor::modify(uint32_t id, int fd, uint32_t events)
+{
+    // epoll_ctl is thread safe, and the caller owns the fd, so this
+    // deliberately does not take the lock (callbacks already hold it)
+    struct epoll_event ev;
+    ev.events = events;
+    ev.data.u64 = key(id, fd);
+
+    return (epoll_ctl(_epfd, EPOLL_CTL_MOD, fd, &ev) == 0);
+}
+
+void SerialReactor::remove(uint32_t id)
+{
+    if (id == 0)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    Registration *reg = find(id);
+    if (reg != nullptr)
+    {
+        unwatch(*reg);
+        reg->id = 0;
+        reg->handler = nullptr;
+    }
+}
+
+size_t SerialReactor::handlers() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    size_t n = 0;
+    for (size_t i = 0; i < g_maxHandlers; i++)
+    {
+        if (_regs[i].id != 0)
+        {
+            n++;
+        }
+    }
+
+    return n;
+}
+
+bool SerialReactor::start()
+{
+    // Caller holds _mutex
+    _epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (_epfd == -1)
+    {
+        return false;
+    }
+
+    if (pipe2(_pipefd, O_CLOEXEC) != 0)
+    {
+        close(_epfd);
+        _epfd = -1;
+        return false;
+    }
+
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.u64 = 0;
+    epoll_ctl(_epfd, EPOLL_CTL_ADD, _pipefd[0], &ev);
+
+    if (pthread_create(&_threadHandle, NULL, runRedirect, this) != 0)
+    {
+        for (int i = 0; i < 2; i++)
+        {
+            close(_pipefd[i]);
+            _pipefd[i] = -1;
+        }
+        close(_epfd);
+        _epfd = -1;
+        return false;
+    }
+    _running = true;
+    _failed = false;
+
+    return true;
+}
+
+void SerialReactor::stop()
+{
+    if (_running)
+    {
+        close(_pipefd[1]);
+        _pipefd[1] = -1;
+        pthread_join(_threadHandle, NULL);
+        _running = false;
+    }
+
+    for (int i = 0; i < 2; i++)
+    {
+        if (_pipefd[i] != -1)
+        {
+            close(_pipefd[i]);
+            _pipefd[i] = -1;
+        }
+    }
+
+    if (_epfd != -1)
+    {
+        close(_epfd);
+        _epfd = -1;
+    }
+}
+
+void SerialReactor::run()
+{
+    struct epoll_event events[2 * g_maxHandlers];
+
+    while (true)
+    {
+        int n = epoll_wait(_epfd, events, 2 * g_maxHandlers, -1);
+        if (n == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            // Nothing will be watched from here on; tell every
+            // handler rather than leave them waiting for input
+            int error = errno;
+            std::lock_guard<std::mutex> lock(_mutex);
+            _failed = true;
+            for (size_t i = 0; i < g_maxHandlers; i++)
+            {
+                if ((_regs[i].id != 0) && (_regs[i].fdCount != 0))
+                {
+                    unwatch(_regs[i]);
+                    _regs[i].handler->failed(error);
+                }
+            }
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        for (int i = 0; i < n; i++)
+        {
+            if (events[i].data.u64 == 0)
+            {
+                // Wakeup pipe closed; shutting down
+                return;
+            }
+
+            uint32_t id = (uint32_t)(events[i].data.u64 >> 32);
+            int fd = (int)(uint32_t)events[i].data.u64;
+
+            Registration *reg = find(id);
+            if (reg == nullptr)
+            {
+                continue;
+            }
+
+            if (!reg->handler->ready(fd, events[i].events))
+            {
+                unwatch(*reg);
+            }
+        }
+    }
+}
+
+void SerialReactor::unwatch(Registration &reg)
+{
+    for (size_t i = 0; i < reg.fdCount; i++)
+    {
+        epoll_ctl(_epfd, EPOLL_CTL_DEL, reg.fds[i], nullptr);
+    }
+    reg.fdCount = 0;
+}
+
+SerialReactor::Registration *SerialReactor::find(uint32_t id)
+{
+    for (size_t i = 0; i < g_maxHandlers; i++)
+    {
+        if (_regs[i].id == id)
+        {
+            return &_regs[i];
+        }
+    }
+
+    return nullptr;
+}
+
+/* static */ void *SerialReactor::runRedirect(void *obj)
+{
+    ((SerialReactor *)obj)->run();
+
+    return 0;
+}
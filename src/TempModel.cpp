@@ -0,0 +1,206 @@
+#include <cmath>
+
+#include "TempModel.hpp"
+
+// Below this many degrees squared of spread (weighted) a slope is
+// not trusted
+static const double g_minSpread = 0.5;
+
+TempModel::TempModel()
+    : _valid(false),
+      _slope(0),
+      _segWidth(0),
+      _segBase(0),
+      _segCount(0)
+{
+}
+
+bool TempModel::fit(const Sample *samples, size_t count, Mode mode, double segmentWidth)
+{
+    _segCount = 0;
+    _valid = fitSlope(samples, count, -HUGE_VAL, HUGE_VAL, &_slope);
+    if (!_valid)
+    {
+        _slope = 0;
+        return false;
+    }
+
+    if ((mode != TM_PIECEWISE) || (segmentWidth <= 0))
+    {
+        return true;
+    }
+
+    double lo = HUGE_VAL;
+    double hi = -HUGE_VAL;
+    for (size_t i = 0; i < count; i++)
+    {
+        lo = fmin(lo, samples[i].tempC);
+        hi = fmax(hi, samples[i].tempC);
+    }
+
+    _segWidth = segmentWidth;
+    _segBase = (long)floor(lo / segmentWidth);
+    long last = (long)floor(hi / segmentWidth);
+    _segCount = (size_t)(last - _segBase + 1);
+    if (_segCount > g_maxSegments)
+    {
+        _segCount = g_maxSegments;
+    }
+
+    for (size_t i = 0; i < _segCount; i++)
+    {
+        double segLo = (_segBase + (long)i) * segmentWidth;
+        _segValid[i] = fitSlope(samples, count, segLo, segLo + segmentWidth, &_segSlope[i]);
+    }
+
+    return true;
+}
+
+void TempModel::setCoefficient(double stepsPerDegree)
+{
+    _valid = true;
+    _slope = stepsPerDegree;
+    _segCount = 0;
+}
+
+size_t TempModel::segments() const
+{
+    size_t n = 0;
+    for (size_t i = 0; i < _segCount; i++)
+    {
+        if (_segValid[i])
+        {
+            n++;
+        }
+    }
+
+    return n;
+}
+
+double TempModel::offset(double fromC, double toC) const
+{
+    if (!_valid || std::isnan(fromC) || std::isnan(toC))
+    {
+        return 0;
+    }
+
+    if (_segCount == 0)
+    {
+        return _slope * (toC - fromC);
+    }
+
+    double lo = fmin(fromC, toC);
+    double hi = fmax(fromC, toC);
+
+    // Walk the segments the interval crosses; beyond the fitted
+    // range slopeOf() returns the overall coefficient, so clamp the
+    // walk to that range plus the two open ends
+    long first = (long)floor(lo / _segWidth);
+    long last = (long)floor(hi / _segWidth);
+    long minSeg = _segBase - 1;
+    long maxSeg = _segBase + (long)_segCount;
+    first = (first < minSeg) ? minSeg : (first > maxSeg) ? maxSeg : first;
+    last = (last < minSeg) ? minSeg : (last > maxSeg) ? maxSeg : last;
+
+    double sum = 0;
+    for (long s = first; s <= last; s++)
+    {
+        double a = (s == first) ? lo : s * _segWidth;
+        double b = (s == last) ? hi : (s + 1) * _segWidth;
+        if (b > a)
+        {
+            sum += slopeOf(s) * (b - a);
+        }
+    }
+
+    return (toC >= fromC) ? sum : -sum;
+}
+
+bool TempModel::fitSlope(const Sample *samples,
+                         size_t count,
+                         double loC,
+                         double hiC,
+                         double *slope) const
+{
+    // Per-filter weighted means
+    int filters[g_maxFilters];
+    double sumW[g_maxFilters];
+    double sumT[g_maxFilters];
+    double sumP[g_maxFilters];
+    size_t groups = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const Sample &s = samples[i];
+        if ((s.tempC < loC) || (s.tempC >= hiC) || (s.weight <= 0))
+        {
+            continue;
+        }
+
+        size_t g = 0;
+        while ((g < groups) && (filters[g] != s.filter))
+        {
+            g++;
+        }
+        if (g == groups)
+        {
+            if (groups == g_maxFilters)
+            {
+                continue;
+            }
+            filters[g] = s.filter;
+            sumW[g] = sumT[g] = sumP[g] = 0;
+            groups++;
+        }
+
+        sumW[g] += s.weight;
+        sumT[g] += s.weight * s.tempC;
+        sumP[g] += s.weight * s.position;
+    }
+
+    double sxx = 0;
+    double sxy = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        const Sample &s = samples[i];
+        if ((s.tempC < loC) || (s.tempC >= hiC) || (s.weight <= 0))
+        {
+            continue;
+        }
+
+        size_t g = 0;
+        while ((g < groups) && (filters[g] != s.filter))
+        {
+            g++;
+        }
+        if (g == groups)
+        {
+            continue;
+        }
+
+        double dt = s.tempC - sumT[g] / sumW[g];
+        double dp = s.position - sumP[g] / sumW[g];
+        sxx += s.weight * dt * dt;
+        sxy += s.weight * dt * dp;
+    }
+
+    if (sxx < g_minSpread)
+    {
+        return false;
+    }
+
+    *slope = sxy / sxx;
+
+    return true;
+}
+
+double TempModel::slopeOf(long segment) const
+{
+    long i = segment - _segBase;
+    if ((i >= 0) && ((size_t)i < _segCount) && _segValid[i])
+    {
+        return _segSlope[i];
+    }
+
+    return _slope;
+}
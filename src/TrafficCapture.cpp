@@ -0,0 +1,150 @@
+#include <cstring>
+
+#include "MonotonicClock.hpp"
+#include "TrafficCapture.hpp"
+
+static const char g_magic[8] = {'R', 'K', 'S', 'C', 'A', 'P', 0, 1};
+
+// Records are written byte by byte so the file doesn't depend on the
+// host's endianness or struct layout
+static void putLE(uint8_t *p, uint64_t value, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        p[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+static uint64_t getLE(const uint8_t *p, size_t len)
+{
+    uint64_t value = 0;
+    for (size_t i = 0; i < len; i++)
+    {
+        value |= (uint64_t)p[i] << (8 * i);
+    }
+
+    return value;
+}
+
+TrafficCapture::TrafficCapture()
+    : _fp(nullptr),
+      _startNs(0),
+      _open(false)
+{
+}
+
+TrafficCapture::~TrafficCapture()
+{
+    close();
+}
+
+bool TrafficCapture::open(const char *path)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (_fp != nullptr)
+    {
+        fclose(_fp);
+        _open.store(false, std::memory_order_relaxed);
+    }
+
+    _fp = fopen(path, "wb");
+    if (_fp == nullptr)
+    {
+        return false;
+    }
+
+    _startNs = monotonicNs();
+    if (fwrite(g_magic, sizeof(g_magic), 1, _fp) != 1)
+    {
+        fclose(_fp);
+        _fp = nullptr;
+        return false;
+    }
+    _open.store(true, std::memory_order_relaxed);
+
+    return true;
+}
+
+void TrafficCapture::close()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (_fp != nullptr)
+    {
+        fclose(_fp);
+        _fp = nullptr;
+        _open.store(false, std::memory_order_relaxed);
+    }
+}
+
+void TrafficCapture::record(Direction direction, const void *data, size_t len)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (_fp != nullptr)
+    {
+        write(monotonicNs() - _startNs, direction, data, len);
+    }
+}
+
+void TrafficCapture::record(uint64_t timeNs, Direction direction, const void *data, size_t len)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (_fp != nullptr)
+    {
+        write(timeNs, direction, data, len);
+    }
+}
+
+void TrafficCapture::write(uint64_t timeNs, Direction direction, const void *data, size_t len)
+{
+    uint8_t header[16];
+    memset(header, 0, sizeof(header));
+
+    putLE(header, timeNs, 8);
+    header[8] = (uint8_t)direction;
+    putLE(header + 12, len, 4);
+
+    fwrite(header, sizeof(header), 1, _fp);
+    fwrite(data, 1, len, _fp);
+}
+
+/* static */ bool TrafficCapture::load(const char *path, std::vector<Chunk> *chunks)
+{
+    FILE *fp = fopen(path, "rb");
+    if (fp == nullptr)
+    {
+        return false;
+    }
+
+    char magic[sizeof(g_magic)];
+    if ((fread(magic, sizeof(magic), 1, fp) != 1) ||
+        (memcmp(magic, g_magic, sizeof(g_magic)) != 0))
+    {
+        fclose(fp);
+        return false;
+    }
+
+    // A capture cut short by a crash ends with a partial record,
+    // which is dropped
+    uint8_t header[16];
+    while (fread(header, sizeof(header), 1, fp) == 1)
+    {
+        Chunk chunk;
+        chunk.timeNs = getLE(header, 8);
+        chunk.direction = (header[8] == TD_TX) ? TD_TX : TD_RX;
+        chunk.data.resize((size_t)getLE(header + 12, 4));
+        if (!chunk.data.empty() &&
+            (fread(&chunk.data[0], chunk.data.size(), 1, fp) != 1))
+        {
+            break;
+        }
+
+        chunks->push_back(chunk);
+    }
+    fclose(fp);
+
+    return true;
+}
@@ -1,24 +1,153 @@
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
 #include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/epoll.h>
 #include <unistd.h>
+#include <vector>
 
+#include "libindi/connectionplugins/connectionserial.h"
+#include "libindi/eventloop.h"
 #include "libindi/indicom.h"
 
 #include "config.h"
 #include "indi_rks_c8_focuser.h"
+#include "MonotonicClock.hpp"
 
-// We declare an auto pointer to RKSC8Focuser.
-static std::unique_ptr<RKSC8Focuser> mydriver(new RKSC8Focuser());
+// How long Handshake() waits for replies to its state queries
+static const int g_handshakeTimeoutMs = 3000;
 
-RKSC8Focuser::RKSC8Focuser()
-    : _reader(0),
-      _writer(0),
-      _comms(0),
+// How often in-flight requests are checked against their deadline
+static const int g_requestCheckMs = 250;
+
+// How long Disconnect() waits for queued commands to go out
+static const int g_shutdownFlushMs = 500;
+
+// How often the Diagnostics properties are refreshed
+static const int g_diagnosticsPeriodMs = 1000;
+
+static const char *DIAGNOSTICS_TAB = "Diagnostics";
+static const char *SWEEP_TAB = "Focus Sweep";
+static const char *CALIBRATION_TAB = "Calibration";
+static const char *FOCUS_CACHE_TAB = "Focus Cache";
+static const char *TEMP_COMP_TAB = "Temperature";
+
+// Serial I/O for every device in the process; declared first so it
+// outlives them
+static SerialReactor reactor;
+
+// One device per controller. RKS_C8_FOCUSERS=N serves N controllers
+// from this process as "RKS C8 Focuser 1".."N", each with its own
+// port and config
+static std::vector<std::unique_ptr<RKSC8Focuser>> createDrivers()
+{
+    const char *env = getenv("RKS_C8_FOCUSERS");
+    int count = (env != nullptr) ? atoi(env) : 1;
+    if (count < 1)
+    {
+        count = 1;
+    }
+    if (count > (int)SerialReactor::g_maxHandlers)
+    {
+        count = (int)SerialReactor::g_maxHandlers;
+    }
+
+    std::vector<std::unique_ptr<RKSC8Focuser>> drivers;
+    for (int i = 0; i < count; i++)
+    {
+        drivers.emplace_back(new RKSC8Focuser(&reactor, (count == 1) ? 0 : i + 1));
+    }
+
+    return drivers;
+}
+
+static std::vector<std::unique_ptr<RKSC8Focuser>> drivers(createDrivers());
+
+RKSC8Focuser::RKSC8Focuser(SerialReactor *reactor, int unit)
+    : _reactor(reactor),
       _microsteps(ELS::MS_X64),
       _maxPos(0),
-      _position(0)
+      _position(0),
+      _speed(ELS::FS_NORMAL),
+      _unitsKnown(false),
+      _posOffset(0),
+      _offsetChecks(0),
+      _offsetLost(false),
+      _devicePosition(0),
+      _deviceMaxPos(0),
+      _maxPosFactor(1),
+      _rebasePending(false),
+      _rebasePosition(0),
+      _predictTimerId(-1),
+      _lastMoveDir(0),
+      _moveState(MV_IDLE),
+      _requestedTarget(0),
+      _settleTimerId(-1),
+      _settleDoneNs(0),
+      _planType(PT_MOVE),
+      _planTarget(0),
+      _planRetried(false),
+      _planWaiting(false),
+      _planRetarget(RT_NONE),
+      _planHeld(false),
+      _planConfiguring(false),
+      _profileSpeed(ELS::FS_NORMAL),
+      _profileMicrosteps(ELS::MS_X64),
+      _dwellTimerId(-1),
+      _filterSlot(1),
+      _ambientTemp(NAN),
+      _compAnchored(false),
+      _compRefTemp(NAN),
+      _compRefPos(0),
+      _compCorrecting(false),
+      _compLastNs(0),
+      _exposing(false),
+      _calState(CAL_IDLE),
+      _calCombo(0),
+      _calSpeed(ELS::FS_NORMAL),
+      _calMicrosteps(ELS::MS_X64),
+      _calSavedSpeed(ELS::FS_NORMAL),
+      _calSavedMicrosteps(ELS::MS_X64),
+      _calDir(ELS::FD_FOCUS_OUTWARD),
+      _calSteps(0),
+      _calForwardRate(0),
+      _calSameSecs(0),
+      _linkState(LINK_DOWN),
+      _heartbeatTimerId(-1),
+      _heartbeatLines(0),
+      _heartbeatMisses(0),
+      _reconnectTimerId(-1),
+      _handshaking(false),
+      _handshakeQueries(0),
+      _handshakeReplies(0),
+      _handshakeStartNs(0),
+      _handshakeTimerId(-1),
+      _reconnectAttempt(0),
+      _reconnectAtNs(0),
+      _reconnects(0),
+      _framed(false),
+      _requestTimerId(-1),
+      _logCallbackId(-1),
+      _diagTimerId(-1),
+      _diagLastNs(0),
+      _diagLastPublishes(0),
+      _diagTicks(0),
+      _positionPending(false),
+      _positionTimerId(-1),
+      _lastPositionPublishNs(0)
 {
     setVersion(CDRIVER_VERSION_MAJOR, CDRIVER_VERSION_MINOR);
 
+    if (unit > 0)
+    {
+        char name[MAXINDIDEVICE];
+        snprintf(name, sizeof(name), "%s %d", getDefaultName(), unit);
+        setDeviceName(name);
+    }
+
     // Here we tell the base Focuser class what types of connections we can support
     setSupportedConnections(CONNECTION_SERIAL);
 
@@ -37,6 +166,9 @@ bool RKSC8Focuser::initProperties()
     // initialize the parent's properties first
     INDI::Focuser::initProperties();
 
+    // Positions, limits and moves are in X64 microsteps whatever the
+    // controller's microstep setting, so a position stays the same
+    // physical place when the setting changes
     FocusAbsPosN[0].min = 0.0;
     FocusAbsPosN[0].max = 2048000.0;
     FocusAbsPosN[0].value = 1024000.0;
@@ -81,6 +213,323 @@ bool RKSC8Focuser::initProperties()
                        "Zero Position", "", OPTIONS_TAB, IP_RW,
                        ISR_1OFMANY, 0, IPS_IDLE);
 
+    // Telemetry
+    IUFillNumber(&TelemetryN[0], "POSITION_RATE", "Max position rate (Hz)",
+                 "%.1f", 0.5, 50.0, 0.5, 10.0);
+    IUFillNumberVector(&TelemetryNP, TelemetryN, 1, getDeviceName(),
+                       "Telemetry", "", OPTIONS_TAB, IP_RW,
+                       0, IPS_IDLE);
+
+    // Motion model
+    IUFillNumber(&MotionModelN[0], "STEP_RATE", "Pulse rate (microsteps/s)",
+                 "%.0f", 1, 100000, 10, 1000);
+    IUFillNumber(&MotionModelN[1], "ACCEL", "Acceleration (steps/s^2, 0 = none)",
+                 "%.0f", 0, 1000000, 100, 0);
+    IUFillNumberVector(&MotionModelNP, MotionModelN, 2, getDeviceName(),
+                       "Motion Model", "", OPTIONS_TAB, IP_RW,
+                       0, IPS_IDLE);
+
+    // Position prediction
+    IUFillSwitch(&PredictS[0], "ENABLE", "Enable", ISS_ON);
+    IUFillSwitch(&PredictS[1], "DISABLE", "Disable", ISS_OFF);
+    IUFillSwitchVector(&PredictSP, PredictS, 2, getDeviceName(),
+                       "Position Prediction", "", OPTIONS_TAB, IP_RW,
+                       ISR_1OFMANY, 0, IPS_IDLE);
+
+    // Settle delay
+    IUFillNumber(&SettleN[0], "SETTLE_MS", "Settle delay (ms)",
+                 "%.0f", 0, 10000, 50, 0);
+    IUFillNumberVector(&SettleNP, SettleN, 1, getDeviceName(),
+                       "Settle Delay", "", OPTIONS_TAB, IP_RW,
+                       0, IPS_IDLE);
+
+    // Focus cache
+    IUFillText(&SnoopT[0], "FILTER_DEVICE", "Filter wheel", "Filter Simulator");
+    IUFillText(&SnoopT[1], "TEMP_DEVICE", "Temperature device", "Weather Simulator");
+    IUFillText(&SnoopT[2], "TEMP_PROPERTY", "Temperature property", "WEATHER_PARAMETERS");
+    IUFillText(&SnoopT[3], "TEMP_ELEMENT", "Temperature element", "WEATHER_TEMPERATURE");
+    IUFillText(&SnoopT[4], "CAMERA_DEVICE", "Camera", "CCD Simulator");
+    IUFillTextVector(&SnoopTP, SnoopT, 5, getDeviceName(),
+                     "Snoop Devices", "", FOCUS_CACHE_TAB, IP_RW,
+                     0, IPS_IDLE);
+
+    char cachePath[512];
+    const char *home = getenv("HOME");
+    snprintf(cachePath, sizeof(cachePath), "%s/.indi/%s_focus_cache.txt",
+             (home != nullptr) ? home : "/tmp", getDeviceName());
+    IUFillText(&FocusCacheFileT[0], "FILE", "File", cachePath);
+    IUFillTextVector(&FocusCacheFileTP, FocusCacheFileT, 1, getDeviceName(),
+                     "Focus Cache File", "", FOCUS_CACHE_TAB, IP_RW,
+                     0, IPS_IDLE);
+    IUFillNumber(&FocusCacheOptionsN[0], "BIN_WIDTH", "Temperature bin (C)", "%.1f", 0.1, 20, 0.5, 2);
+    IUFillNumberVector(&FocusCacheOptionsNP, FocusCacheOptionsN, 1, getDeviceName(),
+                       "Focus Cache Options", "", FOCUS_CACHE_TAB, IP_RW,
+                       0, IPS_IDLE);
+    IUFillNumber(&FocusCacheStateN[0], "FILTER", "Filter slot", "%.0f", 1, 100, 0, 1);
+    IUFillNumber(&FocusCacheStateN[1], "TEMPERATURE", "Temperature (C)", "%.1f", -100, 100, 0, 0);
+    IUFillNumber(&FocusCacheStateN[2], "PREDICTED", "Predicted focus", "%.0f", 0, 2048000.0, 0, 0);
+    IUFillNumberVector(&FocusCacheStateNP, FocusCacheStateN, 3, getDeviceName(),
+                       "Focus Cache", "", FOCUS_CACHE_TAB, IP_RO,
+                       0, IPS_IDLE);
+    IUFillNumber(&FocusCacheRecordN[0], "POSITION", "Best focus", "%.0f", 0, 2048000.0, 1, 0);
+    IUFillNumberVector(&FocusCacheRecordNP, FocusCacheRecordN, 1, getDeviceName(),
+                       "Focus Cache Record", "", FOCUS_CACHE_TAB, IP_RW,
+                       0, IPS_IDLE);
+    IUFillSwitch(&FocusCacheActionS[0], "STORE_CURRENT", "Store current", ISS_OFF);
+    IUFillSwitch(&FocusCacheActionS[1], "GOTO_PREDICTED", "Go to predicted", ISS_OFF);
+    IUFillSwitchVector(&FocusCacheActionSP, FocusCacheActionS, 2, getDeviceName(),
+                       "Focus Cache Action", "", FOCUS_CACHE_TAB, IP_RW,
+                       ISR_ATMOST1, 0, IPS_IDLE);
+    IUFillSwitch(&FocusCacheAutoS[0], "ENABLE", "Enable", ISS_OFF);
+    IUFillSwitch(&FocusCacheAutoS[1], "DISABLE", "Disable", ISS_ON);
+    IUFillSwitchVector(&FocusCacheAutoSP, FocusCacheAutoS, 2, getDeviceName(),
+                       "Focus Cache Auto Move", "", FOCUS_CACHE_TAB, IP_RW,
+                       ISR_1OFMANY, 0, IPS_IDLE);
+
+    snoopDevices();
+
+    // Temperature compensation
+    IUFillSwitch(&TempCompS[0], "ENABLE", "Enable", ISS_OFF);
+    IUFillSwitch(&TempCompS[1], "DISABLE", "Disable", ISS_ON);
+    IUFillSwitchVector(&TempCompSP, TempCompS, 2, getDeviceName(),
+                       "Temperature Compensation", "", TEMP_COMP_TAB, IP_RW,
+                       ISR_1OFMANY, 0, IPS_IDLE);
+    IUFillSwitch(&TempCompModelS[0], "LINEAR", "Linear fit", ISS_ON);
+    IUFillSwitch(&TempCompModelS[1], "PIECEWISE", "Piecewise fit", ISS_OFF);
+    IUFillSwitch(&TempCompModelS[2], "MANUAL", "Manual coefficient", ISS_OFF);
+    IUFillSwitchVector(&TempCompModelSP, TempCompModelS, 3, getDeviceName(),
+                       "Compensation Model", "", TEMP_COMP_TAB, IP_RW,
+                       ISR_1OFMANY, 0, IPS_IDLE);
+    IUFillNumber(&TempCompSettingsN[TC_COEFFICIENT], "COEFFICIENT", "Manual coefficient (steps/C)", "%.1f", -100000, 100000, 10, 0);
+    IUFillNumber(&TempCompSettingsN[TC_SEGMENT], "SEGMENT", "Piecewise segment (C)", "%.1f", 1, 20, 1, 5);
+    IUFillNumber(&TempCompSettingsN[TC_MIN_STEP], "MIN_STEP", "Minimum correction", "%.0f", 0, 100000, 64, 256);
+    IUFillNumber(&TempCompSettingsN[TC_MAX_STEP], "MAX_STEP", "Maximum correction", "%.0f", 64, 1000000, 64, 4096);
+    IUFillNumber(&TempCompSettingsN[TC_INTERVAL], "INTERVAL", "Minimum interval (s)", "%.0f", 0, 3600, 10, 120);
+    IUFillNumberVector(&TempCompSettingsNP, TempCompSettingsN, TC_COUNT, getDeviceName(),
+                       "Compensation Settings", "", TEMP_COMP_TAB, IP_RW,
+                       0, IPS_IDLE);
+    IUFillNumber(&TempCompStatusN[0], "COEFFICIENT", "Coefficient (steps/C)", "%.1f", -100000, 100000, 0, 0);
+    IUFillNumber(&TempCompStatusN[1], "SEGMENTS", "Fitted segments", "%.0f", 0, TempModel::g_maxSegments, 0, 0);
+    IUFillNumber(&TempCompStatusN[2], "REFERENCE", "Reference (C)", "%.2f", -100, 100, 0, 0);
+    IUFillNumber(&TempCompStatusN[3], "ERROR", "Focus error", "%.0f", -1000000, 1000000, 0, 0);
+    IUFillNumberVector(&TempCompStatusNP, TempCompStatusN, 4, getDeviceName(),
+                       "Compensation Status", "", TEMP_COMP_TAB, IP_RO,
+                       0, IPS_IDLE);
+
+    // Link supervisor
+    IUFillNumber(&LinkStatusN[0], "RECONNECTS", "Reconnects", "%.0f", 0, 1e9, 0, 0);
+    IUFillNumber(&LinkStatusN[1], "ATTEMPT", "Attempt", "%.0f", 0, 1e9, 0, 0);
+    IUFillNumber(&LinkStatusN[2], "RETRY_IN", "Next retry (s)", "%.0f", 0, 3600, 0, 0);
+    IUFillNumberVector(&LinkStatusNP, LinkStatusN, 3, getDeviceName(),
+                       "Link Status", "", MAIN_CONTROL_TAB, IP_RO,
+                       0, IPS_IDLE);
+    IUFillNumber(&LinkOptionsN[0], "HEARTBEAT", "Heartbeat period (s)", "%.0f", 0, 600, 1, 5);
+    IUFillNumber(&LinkOptionsN[1], "MISSES", "Missed heartbeats", "%.0f", 1, 20, 1, 3);
+    IUFillNumber(&LinkOptionsN[2], "MAX_BACKOFF", "Max reconnect delay (s)", "%.0f", 1, 3600, 10, 60);
+    IUFillNumberVector(&LinkOptionsNP, LinkOptionsN, 3, getDeviceName(),
+                       "Link Supervisor", "", OPTIONS_TAB, IP_RW,
+                       0, IPS_IDLE);
+    IUFillSwitch(&FramingS[0], "BINARY", "Binary if supported", ISS_ON);
+    IUFillSwitch(&FramingS[1], "TEXT", "Text", ISS_OFF);
+    IUFillSwitchVector(&FramingSP, FramingS, 2, getDeviceName(),
+                       "Telemetry Framing", "", OPTIONS_TAB, IP_RW,
+                       ISR_1OFMANY, 0, IPS_IDLE);
+
+    // Calibration
+    IUFillSwitch(&CalibrateS[0], "START", "Start", ISS_OFF);
+    IUFillSwitch(&CalibrateS[1], "ABORT", "Abort", ISS_OFF);
+    IUFillSwitchVector(&CalibrateSP, CalibrateS, 2, getDeviceName(),
+                       "Calibrate", "", CALIBRATION_TAB, IP_RW,
+                       ISR_ATMOST1, 0, IPS_IDLE);
+    IUFillNumber(&CalibrateOptionsN[0], "TEST_TIME", "Test move (s)", "%.1f", 0.5, 30, 0.5, 2);
+    IUFillNumberVector(&CalibrateOptionsNP, CalibrateOptionsN, 1, getDeviceName(),
+                       "Calibration Options", "", CALIBRATION_TAB, IP_RW,
+                       0, IPS_IDLE);
+    IUFillNumber(&StepRateN[0], "NORMAL_X8", "Normal, x8 (steps/s)", "%.1f", 0, 1e6, 0, 0);
+    IUFillNumber(&StepRateN[1], "NORMAL_X16", "Normal, x16 (steps/s)", "%.1f", 0, 1e6, 0, 0);
+    IUFillNumber(&StepRateN[2], "NORMAL_X32", "Normal, x32 (steps/s)", "%.1f", 0, 1e6, 0, 0);
+    IUFillNumber(&StepRateN[3], "NORMAL_X64", "Normal, x64 (steps/s)", "%.1f", 0, 1e6, 0, 0);
+    IUFillNumber(&StepRateN[4], "X3_X8", "X3, x8 (steps/s)", "%.1f", 0, 1e6, 0, 0);
+    IUFillNumber(&StepRateN[5], "X3_X16", "X3, x16 (steps/s)", "%.1f", 0, 1e6, 0, 0);
+    IUFillNumber(&StepRateN[6], "X3_X32", "X3, x32 (steps/s)", "%.1f", 0, 1e6, 0, 0);
+    IUFillNumber(&StepRateN[7], "X3_X64", "X3, x64 (steps/s)", "%.1f", 0, 1e6, 0, 0);
+    IUFillNumberVector(&StepRateNP, StepRateN, 8, getDeviceName(),
+                       "Step Rates", "", CALIBRATION_TAB, IP_RW,
+                       0, IPS_IDLE);
+    IUFillNumber(&TakeUpN[0], "SECONDS", "Controller take-up (s)", "%.2f", 0, 60, 0, 0);
+    IUFillNumberVector(&TakeUpNP, TakeUpN, 1, getDeviceName(),
+                       "Reversal Take-up", "", CALIBRATION_TAB, IP_RW,
+                       0, IPS_IDLE);
+
+    // Automatic speed and microsteps
+    IUFillSwitch(&AutoMotionS[0], "ENABLE", "Enable", ISS_OFF);
+    IUFillSwitch(&AutoMotionS[1], "DISABLE", "Disable", ISS_ON);
+    IUFillSwitchVector(&AutoMotionSP, AutoMotionS, 2, getDeviceName(),
+                       "Auto Speed", "", OPTIONS_TAB, IP_RW,
+                       ISR_1OFMANY, 0, IPS_IDLE);
+    IUFillNumber(&AutoMotionN[0], "SLEW_MIN", "Slew moves longer than (steps)",
+                 "%.0f", 0, 2048000.0, 1000, 20000);
+    IUFillNumber(&AutoMotionN[1], "APPROACH", "Final approach (steps)",
+                 "%.0f", 0, 100000, 100, 2000);
+    IUFillNumberVector(&AutoMotionNP, AutoMotionN, 2, getDeviceName(),
+                       "Auto Speed Options", "", OPTIONS_TAB, IP_RW,
+                       0, IPS_IDLE);
+
+    // Backlash mode
+    IUFillSwitch(&BacklashModeS[0], "FIRMWARE", "Firmware", ISS_ON);
+    IUFillSwitch(&BacklashModeS[1], "DRIVER", "Driver", ISS_OFF);
+    IUFillSwitchVector(&BacklashModeSP, BacklashModeS, 2, getDeviceName(),
+                       "Backlash Mode", "", OPTIONS_TAB, IP_RW,
+                       ISR_1OFMANY, 0, IPS_IDLE);
+
+    // Driver backlash
+    IUFillNumber(&DriverBacklashN[0], "INWARD", "Inward (steps)", "%.0f", 0, 100000, 10, 650);
+    IUFillNumber(&DriverBacklashN[1], "OUTWARD", "Outward (steps)", "%.0f", 0, 100000, 10, 650);
+    IUFillNumberVector(&DriverBacklashNP, DriverBacklashN, 2, getDeviceName(),
+                       "Driver Backlash", "", OPTIONS_TAB, IP_RW,
+                       0, IPS_IDLE);
+    IUFillSwitch(&BacklashApproachS[0], "OUTWARD", "Outward", ISS_ON);
+    IUFillSwitch(&BacklashApproachS[1], "INWARD", "Inward", ISS_OFF);
+    IUFillSwitchVector(&BacklashApproachSP, BacklashApproachS, 2, getDeviceName(),
+                       "Backlash Approach", "", OPTIONS_TAB, IP_RW,
+                       ISR_1OFMANY, 0, IPS_IDLE);
+
+    // Focus sweep
+    IUFillText(&SweepListT[0], "POSITIONS", "Positions", "");
+    IUFillTextVector(&SweepListTP, SweepListT, 1, getDeviceName(),
+                     "Focus Sweep List", "Sweep list", SWEEP_TAB, IP_RW,
+                     0, IPS_IDLE);
+    IUFillNumber(&SweepRangeN[0], "START", "Start", "%.0f", 0, 2048000.0, 100, 0);
+    IUFillNumber(&SweepRangeN[1], "STEP", "Step", "%.0f", -100000, 100000, 10, 100);
+    IUFillNumber(&SweepRangeN[2], "COUNT", "Count", "%.0f", 1, 64, 1, 9);
+    IUFillNumberVector(&SweepRangeNP, SweepRangeN, 3, getDeviceName(),
+                       "Focus Sweep Range", "Sweep range", SWEEP_TAB, IP_RW,
+                       0, IPS_IDLE);
+    IUFillNumber(&SweepOptionsN[0], "DWELL_MS", "Dwell (ms, 0 = wait for next)",
+                 "%.0f", 0, 600000, 100, 0);
+    IUFillNumber(&SweepOptionsN[1], "OVERSHOOT", "Overshoot (steps, 0 = backlash)",
+                 "%.0f", 0, 100000, 10, 0);
+    IUFillNumberVector(&SweepOptionsNP, SweepOptionsN, 2, getDeviceName(),
+                       "Focus Sweep Options", "Sweep options", SWEEP_TAB, IP_RW,
+                       0, IPS_IDLE);
+    IUFillSwitch(&SweepApproachS[0], "OUTWARD", "Outward", ISS_ON);
+    IUFillSwitch(&SweepApproachS[1], "INWARD", "Inward", ISS_OFF);
+    IUFillSwitchVector(&SweepApproachSP, SweepApproachS, 2, getDeviceName(),
+                       "Focus Sweep Approach", "Approach", SWEEP_TAB, IP_RW,
+                       ISR_1OFMANY, 0, IPS_IDLE);
+    IUFillSwitch(&SweepControlS[0], "NEXT", "Next", ISS_OFF);
+    IUFillSwitch(&SweepControlS[1], "ABORT", "Abort", ISS_OFF);
+    IUFillSwitchVector(&SweepControlSP, SweepControlS, 2, getDeviceName(),
+                       "Focus Sweep Control", "Sweep", SWEEP_TAB, IP_RW,
+                       ISR_ATMOST1, 0, IPS_IDLE);
+    IUFillNumber(&SweepStatusN[0], "POINT", "Point", "%.0f", 0, 64, 0, 0);
+    IUFillNumber(&SweepStatusN[1], "POINTS", "Points", "%.0f", 0, 64, 0, 0);
+    IUFillNumber(&SweepStatusN[2], "POSITION", "Position", "%.0f", 0, 2048000.0, 0, 0);
+    IUFillNumberVector(&SweepStatusNP, SweepStatusN, 3, getDeviceName(),
+                       "Focus Sweep Status", "Sweep status", SWEEP_TAB, IP_RO,
+                       0, IPS_IDLE);
+
+    // Motion
+    IUFillNumber(&MotionN[0], "ETA", "Travel ETA (s)", "%.1f", 0, 1e6, 0, 0);
+    IUFillNumber(&MotionN[1], "SETTLE_ETA", "Settled ETA (s)", "%.1f", 0, 1e6, 0, 0);
+    IUFillNumber(&MotionN[2], "TARGET", "Target", "%.0f", 0, 2048000.0, 0, 0);
+    IUFillNumberVector(&MotionNP, MotionN, 3, getDeviceName(),
+                       "Motion", "", MAIN_CONTROL_TAB, IP_RO,
+                       0, IPS_IDLE);
+
+    // Diagnostics
+    IUFillNumber(&DiagnosticsN[DIAG_BYTES_READ], "BYTES_READ", "Bytes read",
+                 "%.0f", 0, 1e15, 0, 0);
+    IUFillNumber(&DiagnosticsN[DIAG_BYTES_WRITTEN], "BYTES_WRITTEN", "Bytes written",
+                 "%.0f", 0, 1e15, 0, 0);
+    IUFillNumber(&DiagnosticsN[DIAG_LINES_PARSED], "LINES_PARSED", "Lines parsed",
+                 "%.0f", 0, 1e15, 0, 0);
+    IUFillNumber(&DiagnosticsN[DIAG_LINES_DROPPED], "LINES_DROPPED", "Lines dropped",
+                 "%.0f", 0, 1e15, 0, 0);
+    IUFillNumber(&DiagnosticsN[DIAG_EVENTS], "EVENTS", "Events dispatched",
+                 "%.0f", 0, 1e15, 0, 0);
+    IUFillNumber(&DiagnosticsN[DIAG_EVENTS_DROPPED], "EVENTS_DROPPED", "Events dropped",
+                 "%.0f", 0, 1e15, 0, 0);
+    IUFillNumber(&DiagnosticsN[DIAG_DISPATCH_MEAN], "DISPATCH_MEAN_US", "Dispatch mean (us)",
+                 "%.1f", 0, 1e9, 0, 0);
+    IUFillNumber(&DiagnosticsN[DIAG_DISPATCH_MAX], "DISPATCH_MAX_US", "Dispatch max (us)",
+                 "%.0f", 0, 1e9, 0, 0);
+    IUFillNumber(&DiagnosticsN[DIAG_PUBLISH_RATE], "PUBLISH_RATE", "Property updates/s",
+                 "%.1f", 0, 1e6, 0, 0);
+    IUFillNumber(&DiagnosticsN[DIAG_RTT_MEAN], "RTT_MEAN_MS", "Round trip mean (ms)",
+                 "%.1f", 0, 1e6, 0, 0);
+    IUFillNumber(&DiagnosticsN[DIAG_RTT_P99], "RTT_P99_MS", "Round trip p99 (ms)",
+                 "%.1f", 0, 1e6, 0, 0);
+    IUFillNumber(&DiagnosticsN[DIAG_CMDS_SUPERSEDED], "CMDS_SUPERSEDED", "Commands superseded",
+                 "%.0f", 0, 1e15, 0, 0);
+    IUFillNumber(&DiagnosticsN[DIAG_CMDS_REJECTED], "CMDS_REJECTED", "Commands rejected",
+                 "%.0f", 0, 1e15, 0, 0);
+    IUFillNumberVector(&DiagnosticsNP, DiagnosticsN, DIAG_COUNT, getDeviceName(),
+                       "Diagnostics", "", DIAGNOSTICS_TAB, IP_RO,
+                       0, IPS_IDLE);
+
+    for (int i = 0; i < RequestTracker::CMD_COUNT; i++)
+    {
+        const char *cmd = RequestTracker::commandName((RequestTracker::Command)i);
+        INumber *n = &LatencyN[i * LAT_FIELDS];
+        char name[MAXINDINAME];
+        char label[MAXINDILABEL];
+
+        snprintf(name, sizeof(name), "%s_REPLIES", cmd);
+        snprintf(label, sizeof(label), "%s replies", cmd);
+        IUFillNumber(&n[LAT_REPLIES], name, label, "%.0f", 0, 1e15, 0, 0);
+        snprintf(name, sizeof(name), "%s_MEAN_MS", cmd);
+        snprintf(label, sizeof(label), "%s mean (ms)", cmd);
+        IUFillNumber(&n[LAT_MEAN], name, label, "%.1f", 0, 1e6, 0, 0);
+        snprintf(name, sizeof(name), "%s_P99_MS", cmd);
+        snprintf(label, sizeof(label), "%s p99 (ms)", cmd);
+        IUFillNumber(&n[LAT_P99], name, label, "%.1f", 0, 1e6, 0, 0);
+    }
+    IUFillNumberVector(&LatencyNP, LatencyN, RequestTracker::CMD_COUNT * LAT_FIELDS,
+                       getDeviceName(), "Command Latency", "", DIAGNOSTICS_TAB, IP_RO,
+                       0, IPS_IDLE);
+
+    // Per-category log verbosity
+    IUFillNumber(&LogLevelN[LogRing::LC_COMMS], "COMMS", "Comms (0-4)",
+                 "%.0f", LogRing::LL_OFF, LogRing::LL_DEBUG, 1, LogRing::LL_INFO);
+    IUFillNumber(&LogLevelN[LogRing::LC_MOTION], "MOTION", "Motion (0-4)",
+                 "%.0f", LogRing::LL_OFF, LogRing::LL_DEBUG, 1, LogRing::LL_INFO);
+    IUFillNumber(&LogLevelN[LogRing::LC_POSITION], "POSITION", "Position trace (0-4)",
+                 "%.0f", LogRing::LL_OFF, LogRing::LL_DEBUG, 1, LogRing::LL_OFF);
+    IUFillNumberVector(&LogLevelNP, LogLevelN, LogRing::LC_COUNT, getDeviceName(),
+                       "Log Verbosity", "", DIAGNOSTICS_TAB, IP_RW,
+                       0, IPS_IDLE);
+    for (int i = 0; i < LogRing::LC_COUNT; i++)
+    {
+        _logRing.setLevel((LogRing::Category)i, (LogRing::Level)(int)LogLevelN[i].value);
+    }
+
+    // Diagnostics dump
+    IUFillText(&DiagDumpFileT[0], "FILE", "File", "");
+    IUFillTextVector(&DiagDumpFileTP, DiagDumpFileT, 1, getDeviceName(),
+                     "Diagnostics Dump File", "", DIAGNOSTICS_TAB, IP_RW,
+                     0, IPS_IDLE);
+    IUFillNumber(&DiagDumpIntervalN[0], "INTERVAL", "Interval (s, 0 = off)",
+                 "%.0f", 0, 3600, 1, 0);
+    IUFillNumberVector(&DiagDumpIntervalNP, DiagDumpIntervalN, 1, getDeviceName(),
+                       "Diagnostics Dump Interval", "", DIAGNOSTICS_TAB, IP_RW,
+                       0, IPS_IDLE);
+
+    // Motion journal
+    char journalPath[512];
+    snprintf(journalPath, sizeof(journalPath), "%s/.indi/%s_journal.bin",
+             (home != nullptr) ? home : "/tmp", getDeviceName());
+    IUFillText(&JournalFileT[0], "FILE", "File", journalPath);
+    IUFillTextVector(&JournalFileTP, JournalFileT, 1, getDeviceName(),
+                     "Motion Journal", "", DIAGNOSTICS_TAB, IP_RW,
+                     0, IPS_IDLE);
+
+    // Serial traffic capture
+    IUFillText(&CaptureFileT[0], "FILE", "File", "");
+    IUFillTextVector(&CaptureFileTP, CaptureFileT, 1, getDeviceName(),
+                     "Traffic Capture", "", DIAGNOSTICS_TAB, IP_RW,
+                     0, IPS_IDLE);
+
     addAuxControls();
 
     return true;
@@ -104,6 +553,58 @@ bool RKSC8Focuser::updateProperties()
         defineProperty(&SpeedSP);
         defineProperty(&MicrostepSP);
         defineProperty(&ZeroSP);
+        defineProperty(&TelemetryNP);
+        defineProperty(&MotionNP);
+        defineProperty(&MotionModelNP);
+        defineProperty(&SettleNP);
+        defineProperty(&PredictSP);
+        defineProperty(&SnoopTP);
+        defineProperty(&FocusCacheFileTP);
+        defineProperty(&FocusCacheOptionsNP);
+        defineProperty(&FocusCacheStateNP);
+        defineProperty(&FocusCacheRecordNP);
+        defineProperty(&FocusCacheActionSP);
+        defineProperty(&FocusCacheAutoSP);
+        defineProperty(&LinkStatusNP);
+        defineProperty(&LinkOptionsNP);
+        defineProperty(&FramingSP);
+        defineProperty(&TempCompSP);
+        defineProperty(&TempCompModelSP);
+        defineProperty(&TempCompSettingsNP);
+        defineProperty(&TempCompStatusNP);
+        defineProperty(&CalibrateSP);
+        defineProperty(&CalibrateOptionsNP);
+        defineProperty(&StepRateNP);
+        defineProperty(&TakeUpNP);
+        defineProperty(&AutoMotionSP);
+        defineProperty(&AutoMotionNP);
+        defineProperty(&BacklashModeSP);
+        defineProperty(&DriverBacklashNP);
+        defineProperty(&BacklashApproachSP);
+        defineProperty(&SweepListTP);
+        defineProperty(&SweepRangeNP);
+        defineProperty(&SweepOptionsNP);
+        defineProperty(&SweepApproachSP);
+        defineProperty(&SweepControlSP);
+        defineProperty(&SweepStatusNP);
+        defineProperty(&DiagnosticsNP);
+        defineProperty(&LatencyNP);
+        defineProperty(&LogLevelNP);
+        defineProperty(&DiagDumpFileTP);
+        defineProperty(&DiagDumpIntervalNP);
+        defineProperty(&JournalFileTP);
+        defineProperty(&CaptureFileTP);
+
+        startDiagnostics();
+
+        _focusCache.setBinWidth(FocusCacheOptionsN[0].value);
+        if (_focusCache.load(FocusCacheFileT[0].text))
+        {
+            LOGF_INFO("Loaded %u focus cache entries", (unsigned)_focusCache.size());
+        }
+        focusCacheChanged();
+        _compAnchored = false;
+        tempCompFit();
     }
     else
     {
@@ -111,6 +612,49 @@ bool RKSC8Focuser::updateProperties()
         deleteProperty(SpeedSP.name);
         deleteProperty(MicrostepSP.name);
         deleteProperty(ZeroSP.name);
+        deleteProperty(TelemetryNP.name);
+        deleteProperty(MotionNP.name);
+        deleteProperty(MotionModelNP.name);
+        deleteProperty(SettleNP.name);
+        deleteProperty(PredictSP.name);
+        deleteProperty(SnoopTP.name);
+        deleteProperty(FocusCacheFileTP.name);
+        deleteProperty(FocusCacheOptionsNP.name);
+        deleteProperty(FocusCacheStateNP.name);
+        deleteProperty(FocusCacheRecordNP.name);
+        deleteProperty(FocusCacheActionSP.name);
+        deleteProperty(FocusCacheAutoSP.name);
+        deleteProperty(LinkStatusNP.name);
+        deleteProperty(LinkOptionsNP.name);
+        deleteProperty(FramingSP.name);
+        deleteProperty(TempCompSP.name);
+        deleteProperty(TempCompModelSP.name);
+        deleteProperty(TempCompSettingsNP.name);
+        deleteProperty(TempCompStatusNP.name);
+        deleteProperty(CalibrateSP.name);
+        deleteProperty(CalibrateOptionsNP.name);
+        deleteProperty(StepRateNP.name);
+        deleteProperty(TakeUpNP.name);
+        deleteProperty(AutoMotionSP.name);
+        deleteProperty(AutoMotionNP.name);
+        deleteProperty(BacklashModeSP.name);
+        deleteProperty(DriverBacklashNP.name);
+        deleteProperty(BacklashApproachSP.name);
+        deleteProperty(SweepListTP.name);
+        deleteProperty(SweepRangeNP.name);
+        deleteProperty(SweepOptionsNP.name);
+        deleteProperty(SweepApproachSP.name);
+        deleteProperty(SweepControlSP.name);
+        deleteProperty(SweepStatusNP.name);
+        deleteProperty(DiagnosticsNP.name);
+        deleteProperty(LatencyNP.name);
+        deleteProperty(LogLevelNP.name);
+        deleteProperty(DiagDumpFileTP.name);
+        deleteProperty(DiagDumpIntervalNP.name);
+        deleteProperty(JournalFileTP.name);
+        deleteProperty(CaptureFileTP.name);
+
+        stopDiagnostics();
     }
 
     return true;
@@ -121,7 +665,181 @@ bool RKSC8Focuser::ISNewNumber(const char *dev, const char *name, double values[
     // Make sure it is for us.
     if (dev != nullptr && strcmp(dev, getDeviceName()) == 0)
     {
-        // TODO: Check to see if this is for any of my custom Number properties.
+        // Telemetry
+        if (strcmp(TelemetryNP.name, name) == 0)
+        {
+            IUUpdateNumber(&TelemetryNP, values, names, n);
+            TelemetryNP.s = IPS_OK;
+            publish(&TelemetryNP);
+            return true;
+        }
+
+        // Motion model
+        if (strcmp(MotionModelNP.name, name) == 0)
+        {
+            IUUpdateNumber(&MotionModelNP, values, names, n);
+            _motion.setProfile(stepRate(), MotionModelN[1].value);
+            MotionModelNP.s = IPS_OK;
+            publish(&MotionModelNP);
+            return true;
+        }
+
+        // Focus sweep range
+        if (strcmp(SweepRangeNP.name, name) == 0)
+        {
+            IUUpdateNumber(&SweepRangeNP, values, names, n);
+
+            uint32_t targets[64];
+            size_t count = (size_t)SweepRangeN[2].value;
+            bool valid = (count > 0) && (count <= 64);
+            for (size_t i = 0; valid && (i < count); i++)
+            {
+                double pos = SweepRangeN[0].value + i * SweepRangeN[1].value;
+                valid = (pos >= 0) && (pos <= FocusMaxPosN[0].value);
+                targets[i] = valid ? (uint32_t)pos : 0;
+            }
+
+            if (!valid)
+            {
+                LOG_ERROR("Focus sweep range is outside the focuser travel");
+            }
+
+            SweepRangeNP.s = (valid && startSweep(targets, count)) ? IPS_OK : IPS_ALERT;
+            publish(&SweepRangeNP);
+            return true;
+        }
+
+        // Focus cache options
+        if (strcmp(FocusCacheOptionsNP.name, name) == 0)
+        {
+            IUUpdateNumber(&FocusCacheOptionsNP, values, names, n);
+            _focusCache.setBinWidth(FocusCacheOptionsN[0].value);
+            FocusCacheOptionsNP.s = IPS_OK;
+            publish(&FocusCacheOptionsNP);
+            focusCacheChanged();
+            tempCompFit();
+            return true;
+        }
+
+        // Link supervisor options
+        if (strcmp(LinkOptionsNP.name, name) == 0)
+        {
+            IUUpdateNumber(&LinkOptionsNP, values, names, n);
+            LinkOptionsNP.s = IPS_OK;
+            publish(&LinkOptionsNP);
+            if (_linkState == LINK_UP)
+            {
+                startHeartbeat();
+            }
+            return true;
+        }
+
+        // Temperature compensation settings
+        if (strcmp(TempCompSettingsNP.name, name) == 0)
+        {
+            IUUpdateNumber(&TempCompSettingsNP, values, names, n);
+            TempCompSettingsNP.s = IPS_OK;
+            publish(&TempCompSettingsNP);
+            tempCompFit();
+            return true;
+        }
+
+        // Focus cache record
+        if (strcmp(FocusCacheRecordNP.name, name) == 0)
+        {
+            IUUpdateNumber(&FocusCacheRecordNP, values, names, n);
+            focusCacheRecord((uint32_t)FocusCacheRecordN[0].value);
+            FocusCacheRecordNP.s = IPS_OK;
+            publish(&FocusCacheRecordNP);
+            return true;
+        }
+
+        // Calibration options
+        if (strcmp(CalibrateOptionsNP.name, name) == 0)
+        {
+            IUUpdateNumber(&CalibrateOptionsNP, values, names, n);
+            CalibrateOptionsNP.s = IPS_OK;
+            publish(&CalibrateOptionsNP);
+            return true;
+        }
+
+        // Calibrated step rates
+        if (strcmp(StepRateNP.name, name) == 0)
+        {
+            IUUpdateNumber(&StepRateNP, values, names, n);
+            _motion.setProfile(stepRate(), MotionModelN[1].value);
+            StepRateNP.s = IPS_OK;
+            publish(&StepRateNP);
+            return true;
+        }
+
+        // Reversal take-up time
+        if (strcmp(TakeUpNP.name, name) == 0)
+        {
+            IUUpdateNumber(&TakeUpNP, values, names, n);
+            TakeUpNP.s = IPS_OK;
+            publish(&TakeUpNP);
+            return true;
+        }
+
+        // Auto speed options
+        if (strcmp(AutoMotionNP.name, name) == 0)
+        {
+            IUUpdateNumber(&AutoMotionNP, values, names, n);
+            AutoMotionNP.s = IPS_OK;
+            publish(&AutoMotionNP);
+            return true;
+        }
+
+        // Driver backlash
+        if (strcmp(DriverBacklashNP.name, name) == 0)
+        {
+            IUUpdateNumber(&DriverBacklashNP, values, names, n);
+            DriverBacklashNP.s = IPS_OK;
+            publish(&DriverBacklashNP);
+            return true;
+        }
+
+        // Focus sweep options
+        if (strcmp(SweepOptionsNP.name, name) == 0)
+        {
+            IUUpdateNumber(&SweepOptionsNP, values, names, n);
+            SweepOptionsNP.s = IPS_OK;
+            publish(&SweepOptionsNP);
+            return true;
+        }
+
+        // Settle delay
+        if (strcmp(SettleNP.name, name) == 0)
+        {
+            IUUpdateNumber(&SettleNP, values, names, n);
+            SettleNP.s = IPS_OK;
+            publish(&SettleNP);
+            return true;
+        }
+
+        // Log verbosity
+        if (strcmp(LogLevelNP.name, name) == 0)
+        {
+            IUUpdateNumber(&LogLevelNP, values, names, n);
+            for (int i = 0; i < LogRing::LC_COUNT; i++)
+            {
+                _logRing.setLevel((LogRing::Category)i,
+                                  (LogRing::Level)(int)LogLevelN[i].value);
+            }
+            LogLevelNP.s = IPS_OK;
+            publish(&LogLevelNP);
+            return true;
+        }
+
+        // Diagnostics dump interval
+        if (strcmp(DiagDumpIntervalNP.name, name) == 0)
+        {
+            IUUpdateNumber(&DiagDumpIntervalNP, values, names, n);
+            DiagDumpIntervalNP.s = IPS_OK;
+            publish(&DiagDumpIntervalNP);
+            return true;
+        }
     }
 
     // Nobody has claimed this, so let the parent handle it
@@ -149,13 +867,14 @@ bool RKSC8Focuser::ISNewSwitch(const char *dev,
             if (currentEnabled == targetEnabled)
             {
                 EnableSP.s = IPS_OK;
-                IDSetSwitch(&EnableSP, nullptr);
+                publish(&EnableSP);
                 return true;
             }
 
             if (_comms != 0)
             {
                 _comms->enableMotor(targetEnabled);
+                track(RequestTracker::CMD_ENABLE_MOTOR);
             }
         }
 
@@ -171,13 +890,13 @@ bool RKSC8Focuser::ISNewSwitch(const char *dev,
             if (currentSpeed == targetSpeed)
             {
                 SpeedSP.s = IPS_OK;
-                IDSetSwitch(&SpeedSP, nullptr);
+                publish(&SpeedSP);
                 return true;
             }
 
             if (_comms != 0)
             {
-                _comms->setSpeed((ELS::FocusSpeed)(currentSpeed + 1));
+                _writer->setSpeed((ELS::FocusSpeed)(currentSpeed + 1));
             }
         }
 
@@ -193,14 +912,193 @@ bool RKSC8Focuser::ISNewSwitch(const char *dev,
             if (currentMS == targetMS)
             {
                 MicrostepSP.s = IPS_OK;
-                IDSetSwitch(&MicrostepSP, nullptr);
+                publish(&MicrostepSP);
                 return true;
             }
 
             if (_comms != 0)
             {
-                _comms->setMicrostep((ELS::Microsteps)(targetMS + 1));
+                _writer->setMicrostep((ELS::Microsteps)(targetMS + 1));
+            }
+        }
+
+        // Focus cache action
+        if (strcmp(FocusCacheActionSP.name, name) == 0)
+        {
+            IUUpdateSwitch(&FocusCacheActionSP, states, names, n);
+            int action = IUFindOnSwitchIndex(&FocusCacheActionSP);
+            IUResetSwitch(&FocusCacheActionSP);
+
+            uint32_t predicted = 0;
+            FocusCacheActionSP.s = IPS_OK;
+            if (action == 0)
+            {
+                focusCacheRecord(_position);
+            }
+            else if ((action == 1) && focusCachePredict(&predicted))
+            {
+                FocusAbsPosNP.s = MoveAbsFocuser(predicted);
+                publish(&FocusAbsPosNP);
+            }
+            else if (action == 1)
+            {
+                LOGF_WARN("No cached focus for filter %d", _filterSlot);
+                FocusCacheActionSP.s = IPS_ALERT;
+            }
+
+            publish(&FocusCacheActionSP);
+            return true;
+        }
+
+        // Focus cache auto move
+        if (strcmp(FocusCacheAutoSP.name, name) == 0)
+        {
+            IUUpdateSwitch(&FocusCacheAutoSP, states, names, n);
+            FocusCacheAutoSP.s = IPS_OK;
+            publish(&FocusCacheAutoSP);
+            return true;
+        }
+
+        // Telemetry framing; takes effect when the controller
+        // acknowledges
+        if (strcmp(FramingSP.name, name) == 0)
+        {
+            IUUpdateSwitch(&FramingSP, states, names, n);
+            requestFraming();
+            FramingSP.s = _framed ? IPS_OK : IPS_IDLE;
+            publish(&FramingSP);
+            return true;
+        }
+
+        // Temperature compensation
+        if (strcmp(TempCompSP.name, name) == 0)
+        {
+            IUUpdateSwitch(&TempCompSP, states, names, n);
+            TempCompSP.s = IPS_OK;
+            publish(&TempCompSP);
+
+            // Compensate relative to wherever focus is now
+            _compAnchored = false;
+            _compLastNs = 0;
+            if (tempCompEnabled() && !_tempModel.valid())
+            {
+                LOG_WARN("Temperature compensation has no model yet; record focus at more temperatures");
+            }
+            tempCompCheck();
+            publishTempComp();
+            return true;
+        }
+
+        // Temperature compensation model
+        if (strcmp(TempCompModelSP.name, name) == 0)
+        {
+            IUUpdateSwitch(&TempCompModelSP, states, names, n);
+            TempCompModelSP.s = IPS_OK;
+            publish(&TempCompModelSP);
+            tempCompFit();
+            return true;
+        }
+
+        // Calibration
+        if (strcmp(CalibrateSP.name, name) == 0)
+        {
+            IUUpdateSwitch(&CalibrateSP, states, names, n);
+            int action = IUFindOnSwitchIndex(&CalibrateSP);
+            IUResetSwitch(&CalibrateSP);
+
+            if (action == 0)
+            {
+                CalibrateSP.s = startCalibration() ? IPS_BUSY : IPS_ALERT;
+            }
+            else if ((action == 1) && calibrating())
+            {
+                AbortFocuser();
+            }
+
+            publish(&CalibrateSP);
+            return true;
+        }
+
+        // Auto speed
+        if (strcmp(AutoMotionSP.name, name) == 0)
+        {
+            IUUpdateSwitch(&AutoMotionSP, states, names, n);
+            AutoMotionSP.s = IPS_OK;
+            publish(&AutoMotionSP);
+            return true;
+        }
+
+        // Backlash mode
+        if (strcmp(BacklashModeSP.name, name) == 0)
+        {
+            IUUpdateSwitch(&BacklashModeSP, states, names, n);
+
+            // The two schemes must not both compensate
+            if (_comms != 0)
+            {
+                _comms->enableBacklash(!driverBacklash());
+                track(RequestTracker::CMD_ENABLE_BACKLASH);
+            }
+
+            LOGF_INFO("Backlash compensated by the %s",
+                      driverBacklash() ? "driver" : "firmware");
+            BacklashModeSP.s = IPS_OK;
+            publish(&BacklashModeSP);
+            return true;
+        }
+
+        // Backlash approach direction
+        if (strcmp(BacklashApproachSP.name, name) == 0)
+        {
+            IUUpdateSwitch(&BacklashApproachSP, states, names, n);
+            BacklashApproachSP.s = IPS_OK;
+            publish(&BacklashApproachSP);
+            return true;
+        }
+
+        // Focus sweep approach direction
+        if (strcmp(SweepApproachSP.name, name) == 0)
+        {
+            IUUpdateSwitch(&SweepApproachSP, states, names, n);
+            SweepApproachSP.s = IPS_OK;
+            publish(&SweepApproachSP);
+            return true;
+        }
+
+        // Focus sweep control
+        if (strcmp(SweepControlSP.name, name) == 0)
+        {
+            IUUpdateSwitch(&SweepControlSP, states, names, n);
+            int action = IUFindOnSwitchIndex(&SweepControlSP);
+            IUResetSwitch(&SweepControlSP);
+
+            if ((action == 0) && _plan.active() && _planWaiting)
+            {
+                if (_dwellTimerId != -1)
+                {
+                    IERmTimer(_dwellTimerId);
+                    _dwellTimerId = -1;
+                }
+                _planWaiting = false;
+                runPlan();
+            }
+            else if ((action == 1) && _plan.active())
+            {
+                AbortFocuser();
             }
+
+            SweepControlSP.s = IPS_OK;
+            publish(&SweepControlSP);
+            return true;
+        }
+
+        // Position prediction
+        if (strcmp(PredictSP.name, name) == 0)
+        {
+            IUUpdateSwitch(&PredictSP, states, names, n);
+            PredictSP.s = IPS_OK;
+            publish(&PredictSP);
+            return true;
         }
 
         // Zero
@@ -215,13 +1113,14 @@ bool RKSC8Focuser::ISNewSwitch(const char *dev,
             if (currentZero == targetZero)
             {
                 MicrostepSP.s = IPS_OK;
-                IDSetSwitch(&MicrostepSP, nullptr);
+                publish(&MicrostepSP);
                 return true;
             }
 
             if (_comms != 0)
             {
                 _comms->zero();
+                track(RequestTracker::CMD_ZERO);
             }
         }
     }
@@ -235,25 +1134,149 @@ bool RKSC8Focuser::ISNewText(const char *dev, const char *name, char *texts[], c
     // Make sure it is for us.
     if (dev != nullptr && strcmp(dev, getDeviceName()) == 0)
     {
-        // TODO: Check to see if this is for any of my custom Text properties.
+        // Diagnostics dump file
+        if (strcmp(DiagDumpFileTP.name, name) == 0)
+        {
+            IUUpdateText(&DiagDumpFileTP, texts, names, n);
+            DiagDumpFileTP.s = IPS_OK;
+            publish(&DiagDumpFileTP);
+            return true;
+        }
+
+        // Motion journal file; the reader thread appends to the
+        // journal, so it is only switched over on connect
+        if (strcmp(JournalFileTP.name, name) == 0)
+        {
+            IUUpdateText(&JournalFileTP, texts, names, n);
+            if (isConnected())
+            {
+                LOG_INFO("The new journal file is used from the next connection");
+            }
+            JournalFileTP.s = IPS_OK;
+            publish(&JournalFileTP);
+            return true;
+        }
+
+        // Traffic capture file; clearing it stops a capture at once,
+        // a new file is started on the next connection
+        if (strcmp(CaptureFileTP.name, name) == 0)
+        {
+            IUUpdateText(&CaptureFileTP, texts, names, n);
+            if (CaptureFileT[0].text[0] == 0)
+            {
+                _capture.close();
+            }
+            else if (isConnected())
+            {
+                LOG_INFO("Traffic capture starts with the next connection");
+            }
+            CaptureFileTP.s = IPS_OK;
+            publish(&CaptureFileTP);
+            return true;
+        }
+
+        // Snooped devices
+        if (strcmp(SnoopTP.name, name) == 0)
+        {
+            IUUpdateText(&SnoopTP, texts, names, n);
+            snoopDevices();
+            SnoopTP.s = IPS_OK;
+            publish(&SnoopTP);
+            return true;
+        }
+
+        // Focus cache file
+        if (strcmp(FocusCacheFileTP.name, name) == 0)
+        {
+            IUUpdateText(&FocusCacheFileTP, texts, names, n);
+
+            // A missing file just starts an empty table
+            _focusCache.clear();
+            _focusCache.load(FocusCacheFileT[0].text);
+            focusCacheChanged();
+            tempCompFit();
+
+            FocusCacheFileTP.s = IPS_OK;
+            publish(&FocusCacheFileTP);
+            return true;
+        }
+
+        // Focus sweep list
+        if (strcmp(SweepListTP.name, name) == 0)
+        {
+            IUUpdateText(&SweepListTP, texts, names, n);
+
+            // Positions separated by commas and/or whitespace
+            uint32_t targets[64];
+            size_t count = 0;
+            bool valid = true;
+            const char *p = SweepListT[0].text;
+            while (valid && (*p != 0))
+            {
+                if ((*p == ',') || (*p == ' ') || (*p == '\t') || (*p == ';'))
+                {
+                    p++;
+                    continue;
+                }
+
+                char *end = 0;
+                unsigned long pos = strtoul(p, &end, 10);
+                valid = (end != p) && (count < 64) && (pos <= FocusMaxPosN[0].value);
+                if (valid)
+                {
+                    targets[count++] = (uint32_t)pos;
+                    p = end;
+                }
+            }
+
+            if (!valid || (count == 0))
+            {
+                LOGF_ERROR("Invalid focus sweep list '%s'", SweepListT[0].text);
+                valid = false;
+            }
+
+            SweepListTP.s = (valid && startSweep(targets, count)) ? IPS_OK : IPS_ALERT;
+            publish(&SweepListTP);
+            return true;
+        }
     }
 
     // Nobody has claimed this, so let the parent handle it
     return INDI::Focuser::ISNewText(dev, name, texts, names, n);
 }
 
-bool RKSC8Focuser::ISSnoopDevice(XMLEle *root)
-{
-    // TODO: Check to see if this is for any of my custom Snoops. Fo shizzle.
-
-    return INDI::Focuser::ISSnoopDevice(root);
-}
-
 bool RKSC8Focuser::saveConfigItems(FILE *fp)
 {
     INDI::Focuser::saveConfigItems(fp);
 
-    // TODO: Call IUSaveConfig* for any custom properties I want to save.
+    IUSaveConfigNumber(fp, &TelemetryNP);
+    IUSaveConfigNumber(fp, &MotionModelNP);
+    IUSaveConfigNumber(fp, &SettleNP);
+    IUSaveConfigText(fp, &SnoopTP);
+    IUSaveConfigText(fp, &FocusCacheFileTP);
+    IUSaveConfigNumber(fp, &FocusCacheOptionsNP);
+    IUSaveConfigSwitch(fp, &FocusCacheAutoSP);
+    IUSaveConfigNumber(fp, &LinkOptionsNP);
+    IUSaveConfigSwitch(fp, &FramingSP);
+    IUSaveConfigSwitch(fp, &TempCompSP);
+    IUSaveConfigSwitch(fp, &TempCompModelSP);
+    IUSaveConfigNumber(fp, &TempCompSettingsNP);
+    IUSaveConfigNumber(fp, &CalibrateOptionsNP);
+    IUSaveConfigNumber(fp, &StepRateNP);
+    IUSaveConfigNumber(fp, &TakeUpNP);
+    IUSaveConfigSwitch(fp, &AutoMotionSP);
+    IUSaveConfigNumber(fp, &AutoMotionNP);
+    IUSaveConfigSwitch(fp, &BacklashModeSP);
+    IUSaveConfigNumber(fp, &DriverBacklashNP);
+    IUSaveConfigSwitch(fp, &BacklashApproachSP);
+    IUSaveConfigNumber(fp, &SweepOptionsNP);
+    IUSaveConfigSwitch(fp, &SweepApproachSP);
+    IUSaveConfigSwitch(fp, &PredictSP);
+    IUSaveConfigNumber(fp, &LogLevelNP);
+    IUSaveConfigText(fp, &DiagDumpFileTP);
+    IUSaveConfigText(fp, &JournalFileTP);
+    IUSaveConfigText(fp, &CaptureFileTP);
+    IUSaveConfigNumber(fp, &DiagDumpIntervalNP);
 
     return true;
 }
@@ -267,96 +1290,470 @@ bool RKSC8Focuser::Connect()
 
 bool RKSC8Focuser::Disconnect()
 {
-    _comms->enableMotor(false);
+    stopHeartbeat();
+    if (_reconnectTimerId != -1)
+    {
+        IERmTimer(_reconnectTimerId);
+        _reconnectTimerId = -1;
+    }
+    if (_handshakeTimerId != -1)
+    {
+        IERmTimer(_handshakeTimerId);
+        _handshakeTimerId = -1;
+    }
+    _handshaking = false;
+
+    if ((_linkState == LINK_UP) && (_comms != 0))
+    {
+        _comms->enableMotor(false);
+
+        // Give the reader thread a bounded chance to put everything
+        // on the wire
+        if (!_writer->queue()->waitEmpty(g_shutdownFlushMs))
+        {
+            LOGF_WARN("Disconnecting with commands still queued after %d ms",
+                      g_shutdownFlushMs);
+        }
+    }
 
-    _reader->shutdown();
+    stopComms();
+    _capture.close();
+    _linkState = LINK_DOWN;
+    _reconnectAttempt = 0;
 
     bool rc = INDI::Focuser::Disconnect();
 
     return rc;
 }
 
-bool RKSC8Focuser::Handshake()
+void RKSC8Focuser::stopComms()
 {
-    if (isSimulation())
+    // Tear down in dependency order: the reader thread uses the
+    // comms, the command queue and the event queue
+    if (_events)
     {
-        LOGF_INFO("Connected successfully to simulated %s.", getDeviceName());
-        return true;
+        _events->discard();
+    }
+    _reader.reset();
+    if (_events)
+    {
+        _events->stop();
     }
+    _journal.close();
 
-    _writer = new HCWriter(this);
-    _comms = new ELS::HostComms(_writer, this);
-    _reader = new HCReader(PortFD, _comms, this);
-    _reader->start();
+    // Emit whatever the reader thread logged on its way out
+    if (_logCallbackId != -1)
+    {
+        IERmCallback(_logCallbackId);
+        _logCallbackId = -1;
+    }
+    _logRing.drain(this);
+    _logRing.close();
 
-    _comms->getMaxPos();
-    _comms->getPos();
-    _comms->getMicrostep();
-    _comms->getSpeed();
-    _comms->getMotorEnabled();
-    _comms->getBacklashEnabled();
-    _comms->getBacklashSteps();
+    if (_simulator)
+    {
+        _simulator.reset();
 
-    _comms->enableMotor(true);
+        close(PortFD);
+        PortFD = -1;
+    }
 
-    return true;
-}
+    if (_writer)
+    {
+        const CommandQueue::Stats &stats = _writer->queue()->stats();
+        LOGF_DEBUG("Command queue: %llu queued, %llu written in %llu writes "
+                   "(%llu bytes), %llu partial, %llu would block, "
+                   "%llu superseded, %llu rejected",
+                   (unsigned long long)stats.linesQueued.load(),
+                   (unsigned long long)stats.linesWritten.load(),
+                   (unsigned long long)stats.writeCalls.load(),
+                   (unsigned long long)stats.bytesWritten.load(),
+                   (unsigned long long)stats.partialWrites.load(),
+                   (unsigned long long)stats.wouldBlock.load(),
+                   (unsigned long long)stats.superseded.load(),
+                   (unsigned long long)stats.rejected.load());
+    }
 
-IPState RKSC8Focuser::MoveFocuser(FocusDirection dir, int speed, uint16_t duration)
-{
-    // NOTE: This is needed if we don't specify FOCUSER_CAN_ABS_MOVE
-    // TODO: Actual code to move the focuser. You can use IEAddTimer to do a
-    // callback after "duration" to stop your focuser.
-    LOGF_INFO("MoveFocuser: %d %d %d", dir, speed, duration);
-    return IPS_OK;
-}
+    _comms.reset();
+    _writer.reset();
+    _events.reset();
 
-IPState RKSC8Focuser::MoveAbsFocuser(uint32_t targetTicks)
-{
-    // NOTE: This is needed if we do specify FOCUSER_CAN_ABS_MOVE
-    // TODO: Actual code to move the focuser.
-    LOGF_INFO("MoveAbsFocuser: %d", targetTicks);
-    if (_comms != 0)
+    if (_positionTimerId != -1)
     {
-        _comms->focusAbs(targetTicks);
+        IERmTimer(_positionTimerId);
+        _positionTimerId = -1;
     }
-    return IPS_OK;
-}
-
-IPState RKSC8Focuser::MoveRelFocuser(FocusDirection dir, uint32_t ticks)
-{
-    // NOTE: This is needed if we do specify FOCUSER_CAN_REL_MOVE
+    if (_predictTimerId != -1)
+    {
+        IERmTimer(_predictTimerId);
+        _predictTimerId = -1;
+    }
+    cancelSettle();
+    _moveState = MV_IDLE;
+    if (planPending())
+    {
+        abortPlan("disconnected");
+    }
+    _calState = CAL_IDLE;
+
+    logLatencies();
+    _tracker.clear();
+    if (_requestTimerId != -1)
+    {
+        IERmTimer(_requestTimerId);
+        _requestTimerId = -1;
+    }
+}
+
+bool RKSC8Focuser::Handshake()
+{
+    if (!startHandshake())
+    {
+        return false;
+    }
+
+    // Reconnecting; the replies finish the handshake from the
+    // event drain, or the timer gives up on them
+    if (_linkState == LINK_RECONNECTING)
+    {
+        _handshakeTimerId = IEAddTimer(g_handshakeTimeoutMs, handshakeTimerRedirect, this);
+        return true;
+    }
+
+    uint64_t deadlineNs = _handshakeStartNs + (uint64_t)g_handshakeTimeoutMs * 1000000ULL;
+    while (_handshakeReplies < _handshakeQueries)
+    {
+        uint64_t nowNs = monotonicNs();
+        if (nowNs >= deadlineNs)
+        {
+            break;
+        }
+
+        struct pollfd pfd;
+        pfd.fd = _events->fd();
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+
+        int timeoutMs = (int)((deadlineNs - nowNs + 999999) / 1000000);
+        if (poll(&pfd, 1, timeoutMs) > 0)
+        {
+            _events->drain();
+        }
+    }
+
+    return finishHandshake();
+}
+
+bool RKSC8Focuser::startHandshake()
+{
+    if (!startComms())
+    {
+        stopComms();
+        return false;
+    }
+
+    _handshakeStartNs = monotonicNs();
+
+    // Send every state query in one write; the connection is
+    // established once all of the replies are in (or the timeout)
+    _tracker.clear();
+
+    // Positions are rescaled once the microstep setting is known.
+    // A reconnect keeps the offset unless the first reports show
+    // the controller's counter didn't carry on where it was
+    _unitsKnown = false;
+    _framed = false;
+    if (_linkState == LINK_RECONNECTING)
+    {
+        _offsetChecks = OC_POSITION | OC_MICROSTEPS;
+    }
+    else
+    {
+        _offsetChecks = 0;
+        _offsetLost = false;
+        setPosOffset(0);
+    }
+    _rebasePending = false;
+
+    _writer->beginBatch();
+    requestFraming();
+    _comms->getMaxPos();
+    track(RequestTracker::CMD_GET_MAX_POS);
+    _comms->getPos();
+    track(RequestTracker::CMD_GET_POS);
+    _comms->getMicrostep();
+    track(RequestTracker::CMD_GET_MICROSTEP);
+    _comms->getSpeed();
+    track(RequestTracker::CMD_GET_SPEED);
+    _comms->getMotorEnabled();
+    track(RequestTracker::CMD_GET_MOTOR_ENABLED);
+    _comms->getBacklashEnabled();
+    track(RequestTracker::CMD_GET_BACKLASH_ENABLED);
+    _comms->getBacklashSteps();
+    track(RequestTracker::CMD_GET_BACKLASH_STEPS);
+    _writer->endBatch();
+
+    _handshaking = true;
+    _handshakeQueries = _tracker.pending();
+    _handshakeReplies = 0;
+
+    return true;
+}
+
+bool RKSC8Focuser::finishHandshake()
+{
+    _handshaking = false;
+
+    double elapsedMs = (monotonicNs() - _handshakeStartNs) / 1e6;
+
+    if (_handshakeReplies == 0)
+    {
+        LOGF_ERROR("No reply to handshake queries after %.1f ms", elapsedMs);
+        stopComms();
+        return false;
+    }
+
+    if (_handshakeReplies < _handshakeQueries)
+    {
+        LOGF_WARN("Handshake timed out after %.1f ms (%d of %d replies missing)",
+                  elapsedMs, _handshakeQueries - _handshakeReplies, _handshakeQueries);
+
+        // Leave the stragglers to the request timer
+    }
+    else
+    {
+        LOGF_INFO("Handshake completed in %.1f ms", elapsedMs);
+    }
+
+    // Any ack comes back ahead of the query replies, so by now
+    // silence means the firmware doesn't know about framing
+    if ((FramingS[0].s == ISS_ON) && !_framed)
+    {
+        LOG_INFO("Controller does not support binary framing; using text");
+    }
+
+    _comms->enableMotor(true);
+    track(RequestTracker::CMD_ENABLE_MOTOR);
+
+    _linkState = LINK_UP;
+    startHeartbeat();
+    publishLink();
+
+    return true;
+}
+
+void RKSC8Focuser::checkHandshake()
+{
+    // Finishing never tears the comms stack down from inside the
+    // drain: there has been at least one reply
+    if ((_handshakeTimerId == -1) || (_handshakeReplies == 0) ||
+        (_handshakeReplies < _handshakeQueries))
+    {
+        return;
+    }
+
+    IERmTimer(_handshakeTimerId);
+    _handshakeTimerId = -1;
+    reconnectDone(finishHandshake());
+}
+
+/* static */ void RKSC8Focuser::handshakeTimerRedirect(void *obj)
+{
+    RKSC8Focuser *focuser = (RKSC8Focuser *)obj;
+
+    focuser->_handshakeTimerId = -1;
+    focuser->reconnectDone(focuser->finishHandshake());
+}
+
+bool RKSC8Focuser::startComms()
+{
+    if (isSimulation())
+    {
+        // Put a simulated controller on the other end of the
+        // link and run the normal comms stack against it
+        _simulator.reset(new C8Simulator());
+        PortFD = _simulator->start();
+        if (PortFD == -1)
+        {
+            LOG_ERROR("Failed to start simulated controller");
+            return false;
+        }
+
+        LOGF_INFO("Connecting to simulated %s.", getDeviceName());
+    }
+
+    _events.reset(new HCEvents(this));
+    if (!_events->start())
+    {
+        LOG_ERROR("Failed to start event queue");
+        return false;
+    }
+
+    if (!_logRing.open())
+    {
+        LOG_ERROR("Failed to open log ring");
+        return false;
+    }
+    _logCallbackId = IEAddCallback(_logRing.notifyFd(), logRingRedirect, this);
+
+    // The reader thread multiplexes reads and queued writes, so
+    // neither may block it
+    int flags = fcntl(PortFD, F_GETFL, 0);
+    if ((flags == -1) || (fcntl(PortFD, F_SETFL, flags | O_NONBLOCK) == -1))
+    {
+        LOG_ERROR("Failed to make serial port non-blocking");
+        return false;
+    }
+
+    // A capture runs from connect to disconnect, so a reconnect
+    // carries on with the same file
+    if ((CaptureFileT[0].text[0] != 0) && !_capture.isOpen())
+    {
+        if (_capture.open(CaptureFileT[0].text))
+        {
+            LOGF_INFO("Capturing serial traffic to %s", CaptureFileT[0].text);
+        }
+        else
+        {
+            LOGF_WARN("Failed to open traffic capture %s", CaptureFileT[0].text);
+        }
+    }
+
+    // Not fatal; the journal is only for analysis afterwards
+    if ((JournalFileT[0].text[0] != 0) && !_journal.open(JournalFileT[0].text))
+    {
+        LOGF_WARN("Failed to open motion journal %s", JournalFileT[0].text);
+    }
+
+    _writer.reset(new HCWriter(this));
+    if (!_writer->open())
+    {
+        LOG_ERROR("Failed to open command queue");
+        return false;
+    }
+    _comms.reset(new ELS::HostComms(_writer.get(), _events.get()));
+    _reader.reset(new HCReader(PortFD, _comms.get(), _writer->queue(), _reactor, this));
+    if (!_reader->start())
+    {
+        LOG_ERROR("Failed to register with the serial reactor");
+        return false;
+    }
+
+    return true;
+}
+
+IPState RKSC8Focuser::MoveFocuser(FocusDirection dir, int speed, uint16_t duration)
+{
+    // NOTE: This is needed if we don't specify FOCUSER_CAN_ABS_MOVE
+    // TODO: Actual code to move the focuser. You can use IEAddTimer to do a
+    // callback after "duration" to stop your focuser.
+    LOGF_INFO("MoveFocuser: %d %d %d", dir, speed, duration);
+    return IPS_OK;
+}
+
+IPState RKSC8Focuser::MoveAbsFocuser(uint32_t targetTicks)
+{
+    // NOTE: This is needed if we do specify FOCUSER_CAN_ABS_MOVE
     // TODO: Actual code to move the focuser.
+    LOGF_INFO("MoveAbsFocuser: %d", targetTicks);
+    if (_linkState == LINK_RECONNECTING)
+    {
+        LOG_ERROR("Cannot move while reconnecting");
+        return IPS_ALERT;
+    }
+
+    if (!_compCorrecting)
+    {
+        // Temperature compensation restarts from wherever this ends
+        _compAnchored = false;
+    }
+
+    if (calibrating())
+    {
+        LOG_ERROR("Cannot move while calibrating");
+        return IPS_ALERT;
+    }
+
+    if (_plan.active() && (_planType == PT_SWEEP))
+    {
+        abortPlan("superseded by a manual move");
+    }
+
+    return (driverBacklash() || autoMotion()) ? planMove(targetTicks) : sendAbsMove(targetTicks);
+}
+
+IPState RKSC8Focuser::MoveRelFocuser(FocusDirection dir, uint32_t ticks)
+{
+    // NOTE: This is needed if we do specify FOCUSER_CAN_REL_MOVE
+    ELS::FocusDirection elsDir = ELS::FD_FOCUS_OUTWARD;
     switch (dir)
     {
     case FOCUS_INWARD:
         LOGF_INFO("MoveRelFocuser IN %d", ticks);
-        if (_comms != 0)
-        {
-            _comms->focusRel(ELS::FD_FOCUS_INWARD, ticks);
-        }
+        elsDir = ELS::FD_FOCUS_INWARD;
         break;
     case FOCUS_OUTWARD:
         LOGF_INFO("MoveRelFocuser OUT %d", ticks);
-        if (_comms != 0)
-        {
-            _comms->focusRel(ELS::FD_FOCUS_OUTWARD, ticks);
-        }
         break;
     }
-    return IPS_OK;
+
+    if ((_comms == 0) || (_linkState == LINK_RECONNECTING))
+    {
+        return IPS_ALERT;
+    }
+
+    if (calibrating())
+    {
+        LOG_ERROR("Cannot move while calibrating");
+        return IPS_ALERT;
+    }
+
+    if (!_compCorrecting)
+    {
+        _compAnchored = false;
+    }
+
+    if (_plan.active() && (_planType == PT_SWEEP))
+    {
+        abortPlan("superseded by a manual move");
+    }
+
+    if (driverBacklash() || autoMotion())
+    {
+        // Successive relative moves accumulate onto the planned target
+        uint32_t from = planPending() ? _planTarget : _position;
+        return planMove(relativeTarget(from, elsDir, ticks));
+    }
+
+    // Predict the distance the controller will actually move
+    uint32_t steps = (ticks + unitFactor() / 2) / unitFactor();
+    _comms->focusRel(elsDir, steps);
+    track(RequestTracker::CMD_FOCUS_REL);
+
+    return requestMove(relativeTarget(_position, elsDir, steps * unitFactor()));
 }
 
 bool RKSC8Focuser::SetFocuserBacklash(int32_t steps)
 {
     LOGF_INFO("SetFocuserBacklash: %d steps", steps);
 
+    // The firmware's compensation stays off while the driver
+    // compensates, so the standard property sets the driver's
+    if (driverBacklash())
+    {
+        DriverBacklashN[0].value = (steps < 0) ? 0 : steps;
+        DriverBacklashN[1].value = DriverBacklashN[0].value;
+        DriverBacklashNP.s = IPS_OK;
+        publish(&DriverBacklashNP);
+        return true;
+    }
+
     if (_comms != 0)
     {
-        _comms->setBacklashSteps(steps);
+        _writer->setBacklashSteps(steps);
 
         FocusBacklashNP.s = IPS_BUSY;
-        IDSetNumber(&FocusBacklashNP, nullptr);
+        publish(&FocusBacklashNP);
     }
 
     return true;
@@ -366,12 +1763,19 @@ bool RKSC8Focuser::SetFocuserBacklashEnabled(bool enabled)
 {
     LOGF_INFO("SetFocuserBacklashEnabled: %s", enabled ? "true" : "false");
 
+    if (enabled && driverBacklash())
+    {
+        LOG_ERROR("Backlash is compensated by the driver; select firmware backlash mode first");
+        return false;
+    }
+
     if (_comms != 0)
     {
         _comms->enableBacklash(enabled);
+        track(RequestTracker::CMD_ENABLE_BACKLASH);
 
         FocusBacklashSP.s = IPS_BUSY;
-        IDSetSwitch(&FocusBacklashSP, nullptr);
+        publish(&FocusBacklashSP);
     }
 
     return true;
@@ -381,44 +1785,97 @@ bool RKSC8Focuser::AbortFocuser()
 {
     // NOTE: This is needed if we do specify FOCUSER_CAN_ABORT
     LOG_INFO("AbortFocuser");
+
+    // An aborted move completes as soon as it stops; no settling
+    cancelSettle();
+    _moveState = MV_IDLE;
+    if (planPending())
+    {
+        abortPlan("aborted");
+    }
+    if (calibrating())
+    {
+        finishCalibration(false, "aborted");
+    }
+
     if (_comms != 0)
     {
         _comms->focusAbort();
+        track(RequestTracker::CMD_FOCUS_ABORT);
     }
     return true;
 }
 
 void RKSC8Focuser::movingRel(ELS::FocusDirection dir, uint32_t steps)
 {
-    LOGF_INFO("Moving relative %s %u steps",
-              (dir == ELS::FD_FOCUS_INWARD) ? "IN" : "OUT", steps);
+    if (logEnabled(LogRing::LC_MOTION, LogRing::LL_INFO))
+    {
+        LOGF_INFO("Moving relative %s %u steps",
+                  (dir == ELS::FD_FOCUS_INWARD) ? "IN" : "OUT", steps);
+    }
+    replied(RequestTracker::RP_MOVING_REL);
+    steps *= unitFactor();
+    _moveState = MV_MOVING;
+    if (calibrating())
+    {
+        _calTiming.start(_position, monotonicNs());
+    }
+    beginPrediction(_position, relativeTarget(_position, dir, steps));
+
     FocusAbsPosNP.s = IPS_BUSY;
     FocusRelPosNP.s = IPS_BUSY;
-    IDSetNumber(&FocusRelPosNP, nullptr);
-    IDSetNumber(&FocusAbsPosNP, nullptr);
+    publish(&FocusRelPosNP);
+    publish(&FocusAbsPosNP);
 }
 
 void RKSC8Focuser::movingAbs(uint32_t fromPosition, uint32_t toPosition)
 {
-    LOGF_INFO("Moving absolute from %u to %u", fromPosition, toPosition);
+    if (logEnabled(LogRing::LC_MOTION, LogRing::LL_INFO))
+    {
+        LOGF_INFO("Moving absolute from %u to %u", fromPosition, toPosition);
+    }
+    replied(RequestTracker::RP_MOVING_ABS);
+    fromPosition = fromDevice(fromPosition);
+    toPosition = fromDevice(toPosition);
+    _moveState = MV_MOVING;
+    beginPrediction(fromPosition, toPosition);
+
+    if ((_planRetarget == RT_PENDING) && _plan.active() &&
+        (toPosition == reachable(_plan.current().position)))
+    {
+        _planRetarget = RT_ACKNOWLEDGED;
+    }
+
     FocusAbsPosNP.s = IPS_BUSY;
     FocusRelPosNP.s = IPS_BUSY;
-    IDSetNumber(&FocusRelPosNP, nullptr);
-    IDSetNumber(&FocusAbsPosNP, nullptr);
+    publish(&FocusRelPosNP);
+    publish(&FocusAbsPosNP);
 }
 
 void RKSC8Focuser::stopped(uint32_t position)
 {
-    LOGF_INFO("Stopped at %u", position);
+    if (logEnabled(LogRing::LC_MOTION, LogRing::LL_INFO))
+    {
+        LOGF_INFO("Stopped at %u", position);
+    }
+    replied(RequestTracker::RP_STOPPED);
+    _devicePosition = position;
+    position = fromDevice(position);
     _position = position;
-    updateAbsPosition(_position);
-    FocusRelPosNP.s = IPS_OK;
-    IDSetNumber(&FocusRelPosNP, nullptr);
+    _calTiming.stop(position, monotonicNs());
+    endPrediction(position);
+    moveStopped();
+
+    // Terminal events always flush any coalesced position
+    flushPosition();
+    FocusRelPosNP.s = moveIPState();
+    publish(&FocusRelPosNP);
 }
 
 void RKSC8Focuser::motorEnabled(bool isEnabled)
 {
     LOGF_INFO("Motor is %s", isEnabled ? "ENABLED" : "DISABLED");
+    replied(RequestTracker::RP_MOTOR_ENABLED);
 
     IUResetSwitch(&EnableSP);
 
@@ -432,30 +1889,110 @@ void RKSC8Focuser::motorEnabled(bool isEnabled)
     }
 
     EnableSP.s = IPS_OK;
-    IDSetSwitch(&EnableSP, nullptr);
+    publish(&EnableSP);
 }
 
 void RKSC8Focuser::zeroed()
 {
     LOG_INFO("Zeroed");
+    replied(RequestTracker::RP_ZEROED);
+
+    // The controller's counter is now zero in any units
+    _compAnchored = false;
+    setPosOffset(0);
+    _offsetLost = false;
+    _devicePosition = 0;
+    _position = 0;
+    flushPosition();
 
     IUResetSwitch(&ZeroSP);
     ZeroS[0].s = ISS_OFF;
     ZeroSP.s = IPS_OK;
-    IDSetSwitch(&ZeroSP, nullptr);
+    publish(&ZeroSP);
 }
 
 void RKSC8Focuser::position(uint32_t position)
 {
-    LOGF_INFO("Position is now %u", position);
+    if (logEnabled(LogRing::LC_POSITION, LogRing::LL_INFO))
+    {
+        LOGF_INFO("Position is now %u", position);
+    }
+    replied(RequestTracker::RP_POSITION);
+    _devicePosition = position;
+
+    if (_offsetChecks & OC_POSITION)
+    {
+        checkOffset(OC_POSITION, position == _linkSaved.devicePosition, "position");
+    }
+
+    if (_rebasePending)
+    {
+        // First report in the new units; anchor it where we were
+        setPosOffset((int64_t)_rebasePosition - (int64_t)position * unitFactor());
+        _rebasePending = false;
+        settingsApplied();
+    }
+
+    position = fromDevice(position);
     _position = position;
-    updateAbsPosition(_position);
+    _motion.correct(position, monotonicNs());
+    _calTiming.sample(position, monotonicNs());
+    _positionPending = true;
+
+    // A publish is already scheduled; it will pick up the
+    // newest position when it fires
+    if (_positionTimerId != -1)
+    {
+        return;
+    }
+
+    uint64_t periodNs = (uint64_t)(1e9 / TelemetryN[0].value);
+    uint64_t sinceLastNs = monotonicNs() - _lastPositionPublishNs;
+    if (sinceLastNs >= periodNs)
+    {
+        flushPosition();
+    }
+    else
+    {
+        int delayMs = (int)((periodNs - sinceLastNs + 999999) / 1000000);
+        _positionTimerId = IEAddTimer(delayMs, positionTimerRedirect, this);
+    }
 }
 
 void RKSC8Focuser::microsteps(ELS::Microsteps ms)
 {
     const char *s = 0;
 
+    replied(RequestTracker::RP_MICROSTEPS);
+
+    if (_offsetChecks & OC_MICROSTEPS)
+    {
+        checkOffset(OC_MICROSTEPS, ms == _linkSaved.microsteps, "microstep setting");
+    }
+
+    bool unitsLearned = !_unitsKnown;
+    if (!_unitsKnown)
+    {
+        // The handshake reports may have arrived before this one
+        _unitsKnown = true;
+        _microsteps = ms;
+        _maxPosFactor = unitFactor();
+        _position = fromDevice(_devicePosition);
+        publishMaxPos();
+        flushPosition();
+    }
+    else if (ms != _microsteps)
+    {
+        // Rebase on a fresh report rather than assume whether the
+        // controller rescaled its counter
+        _rebasePosition = _position;
+        _rebasePending = true;
+        if (_comms != 0)
+        {
+            _comms->getPos();
+            track(RequestTracker::CMD_GET_POS);
+        }
+    }
     _microsteps = ms;
 
     IUResetSwitch(&MicrostepSP);
@@ -481,29 +2018,108 @@ void RKSC8Focuser::microsteps(ELS::Microsteps ms)
     }
 
     MicrostepSP.s = IPS_OK;
-    IDSetSwitch(&MicrostepSP, nullptr);
+    publish(&MicrostepSP);
 
     LOGF_INFO("Microsteps is now %s", s);
+
+    // Whether or not Auto Speed is on, positions don't change scale
+    // with the setting, so say what a client's steps are
+    if (unitsLearned && (unitFactor() != 1))
+    {
+        LOGF_INFO("Positions are in X64 microsteps; each controller step at %s is %u of them",
+                  s, unitFactor());
+    }
+
+    _motion.setProfile(stepRate(), MotionModelN[1].value);
+    settingsApplied();
 }
 
 void RKSC8Focuser::maxPos(uint32_t position)
 {
     LOGF_INFO("Max position is %u", position);
-    _maxPos = position;
+    replied(RequestTracker::RP_MAX_POS);
+    _deviceMaxPos = position;
+    publishMaxPos();
+}
+
+void RKSC8Focuser::publishMaxPos()
+{
+    // The travel limit is physical, so it keeps the scale it had
+    // when the units were first learned
+    _maxPos = _deviceMaxPos * (_unitsKnown ? _maxPosFactor : unitFactor());
     FocusMaxPosN[0].value = _maxPos;
-    IDSetNumber(&FocusMaxPosNP, nullptr);
+    publish(&FocusMaxPosNP);
+    FocusAbsPosN[0].max = _maxPos;
     IUUpdateMinMax(&FocusAbsPosNP);
+    SweepRangeN[0].max = _maxPos;
+    IUUpdateMinMax(&SweepRangeNP);
 }
 
-void RKSC8Focuser::speed(ELS::FocusSpeed speed)
+uint32_t RKSC8Focuser::unitFactor() const
 {
-    const char *s = 0;
-
-    _speed = speed;
-
-    IUResetSwitch(&SpeedSP);
-
-    switch (speed)
+    switch (_microsteps)
+    {
+    case ELS::MS_X8:
+        return 8;
+    case ELS::MS_X16:
+        return 4;
+    case ELS::MS_X32:
+        return 2;
+    case ELS::MS_X64:
+        break;
+    }
+
+    return 1;
+}
+
+uint32_t RKSC8Focuser::fromDevice(uint32_t steps) const
+{
+    int64_t position = _posOffset + (int64_t)steps * unitFactor();
+
+    return (position < 0) ? 0 : (position > UINT32_MAX) ? UINT32_MAX : (uint32_t)position;
+}
+
+uint32_t RKSC8Focuser::toDevice(uint32_t position) const
+{
+    int64_t factor = unitFactor();
+    int64_t steps = ((int64_t)position - _posOffset + factor / 2) / factor;
+
+    return (steps < 0) ? 0 : (steps > UINT32_MAX) ? UINT32_MAX : (uint32_t)steps;
+}
+
+void RKSC8Focuser::setPosOffset(int64_t offset)
+{
+    _posOffset = offset;
+    _journal.append(MotionJournal::JE_OFFSET, (uint32_t)offset, (uint32_t)((uint64_t)offset >> 32));
+}
+
+void RKSC8Focuser::settingsApplied()
+{
+    if (_rebasePending)
+    {
+        return;
+    }
+
+    calibrationSettingsChanged();
+
+    if (_planConfiguring && (_speed == _profileSpeed) && (_microsteps == _profileMicrosteps))
+    {
+        _planConfiguring = false;
+        runPlan();
+    }
+}
+
+void RKSC8Focuser::speed(ELS::FocusSpeed speed)
+{
+    const char *s = 0;
+
+    _speed = speed;
+    _motion.setProfile(stepRate(), MotionModelN[1].value);
+    replied(RequestTracker::RP_SPEED);
+
+    IUResetSwitch(&SpeedSP);
+
+    switch (speed)
     {
     case ELS::FS_NORMAL:
         s = "Normal";
@@ -516,13 +2132,24 @@ void RKSC8Focuser::speed(ELS::FocusSpeed speed)
     }
 
     SpeedSP.s = IPS_OK;
-    IDSetSwitch(&SpeedSP, nullptr);
+    publish(&SpeedSP);
 
     LOGF_INFO("Speed is now %s", s);
+
+    settingsApplied();
 }
 
 void RKSC8Focuser::backlashEnabled(bool isEnabled)
 {
+    replied(RequestTracker::RP_BACKLASH_ENABLED);
+
+    if (isEnabled && driverBacklash() && (_comms != 0))
+    {
+        LOG_INFO("Disabling firmware backlash; the driver compensates");
+        _comms->enableBacklash(false);
+        track(RequestTracker::CMD_ENABLE_BACKLASH);
+    }
+
     IUResetSwitch(&FocusBacklashSP);
 
     FocusBacklashSP.s = IPS_OK;
@@ -536,209 +2163,1234 @@ void RKSC8Focuser::backlashEnabled(bool isEnabled)
         FocusBacklashS[1].s = ISS_ON;
     }
 
-    IDSetSwitch(&FocusBacklashSP, nullptr);
+    publish(&FocusBacklashSP);
 }
 
 void RKSC8Focuser::backlashSteps(uint32_t steps)
 {
+    replied(RequestTracker::RP_BACKLASH_STEPS);
+
     FocusBacklashNP.s = IPS_OK;
     FocusBacklashN[0].value = steps;
-    IDSetNumber(&FocusBacklashNP, nullptr);
+    publish(&FocusBacklashNP);
 }
 
-void RKSC8Focuser::log(const char *fmt, ...)
+double RKSC8Focuser::stepRate() const
 {
-    char buffer[1024];
-    va_list args;
-    va_start(args, fmt);
-    vsprintf(buffer, fmt, args);
-    LOG_INFO(buffer);
+    double measured = StepRateN[stepRateIndex(_speed, _microsteps)].value;
+    if (measured > 0)
+    {
+        return measured;
+    }
+
+    // Nominal; the pulse rate does not depend on the microstep
+    // setting, but each pulse covers more X64 steps when coarser
+    double rate = MotionModelN[0].value * unitFactor();
+
+    return (_speed == ELS::FS_X3) ? rate * 3 : rate;
 }
 
-void RKSC8Focuser::updateAbsPosition(uint32_t position)
+uint32_t RKSC8Focuser::relativeTarget(uint32_t from, ELS::FocusDirection dir, uint32_t steps) const
 {
-    FocusAbsPosN[0].value = position;
-    FocusAbsPosNP.s = IPS_OK;
-    FocusRelPosNP.s = IPS_OK;
-    IDSetNumber(&FocusAbsPosNP, nullptr);
+    if (dir == ELS::FD_FOCUS_INWARD)
+    {
+        return (steps > from) ? 0 : from - steps;
+    }
+
+    uint32_t maxPos = (uint32_t)FocusMaxPosN[0].value;
+
+    return ((uint64_t)from + steps > maxPos) ? maxPos : from + steps;
 }
 
-//
-// HCWriter
-//
+uint32_t RKSC8Focuser::backlashSteps(uint32_t from, uint32_t to) const
+{
+    int dir = (to > from) ? 1 : (to < from) ? -1 : 0;
 
-RKSC8Focuser::HCWriter::HCWriter(RKSC8Focuser *parent)
-    : _parent(parent)
+    // The firmware takes up its configured backlash when the
+    // direction reverses
+    if ((dir != 0) && (_lastMoveDir != 0) && (dir != _lastMoveDir) &&
+        (FocusBacklashS[0].s == ISS_ON))
+    {
+        return (uint32_t)FocusBacklashN[0].value * unitFactor();
+    }
+
+    return 0;
+}
+
+void RKSC8Focuser::beginPrediction(uint32_t from, uint32_t to)
 {
+    uint32_t deadSteps = backlashSteps(from, to);
+    if (to != from)
+    {
+        _lastMoveDir = (to > from) ? 1 : -1;
+    }
+
+    _motion.setProfile(stepRate(), MotionModelN[1].value);
+    _motion.start(from, to, monotonicNs(), deadSteps);
+    publishMotion();
+
+    if (_predictTimerId == -1)
+    {
+        int periodMs = (int)(1000.0 / TelemetryN[0].value);
+        _predictTimerId = IEAddTimer(periodMs, predictTimerRedirect, this);
+    }
 }
 
-bool RKSC8Focuser::HCWriter::writeLine(const char *line)
+void RKSC8Focuser::endPrediction(uint32_t position)
 {
-    int len = sprintf(_buffer, "%s\r\n", line);
+    if (_predictTimerId != -1)
+    {
+        IERmTimer(_predictTimerId);
+        _predictTimerId = -1;
+    }
 
-    return (write(_parent->PortFD, _buffer, len) == len);
+    _motion.stop(position);
 }
 
-void RKSC8Focuser::HCWriter::close()
+void RKSC8Focuser::publishMotion()
 {
-    // Do nothing because INDI is managing the
-    // file handle
+    double travel = 0.0;
+    uint32_t target = _motion.target();
+
+    switch (_moveState)
+    {
+    case MV_REQUESTED:
+    {
+        // Not acknowledged yet; estimate the whole move
+        uint32_t steps = (_requestedTarget > _position) ? _requestedTarget - _position
+                                                        : _position - _requestedTarget;
+        _motion.setProfile(stepRate(), MotionModelN[1].value);
+        travel = _motion.duration(steps, backlashSteps(_position, _requestedTarget));
+        target = _requestedTarget;
+        break;
+    }
+    case MV_MOVING:
+        travel = _motion.remaining(monotonicNs());
+        break;
+    default:
+        break;
+    }
+
+    MotionN[0].value = travel;
+    MotionN[1].value = travel + settleRemaining();
+    MotionN[2].value = target;
+    MotionNP.s = moveIPState();
+    publish(&MotionNP);
 }
 
-//
-// HCReader
-//
+IPState RKSC8Focuser::sendAbsMove(uint32_t target)
+{
+    if (_comms == 0)
+    {
+        return IPS_ALERT;
+    }
 
-RKSC8Focuser::HCReader::HCReader(int fd,
-                                 ELS::HostComms *comms,
-                                 RKSC8Focuser *parent)
-    : _fd(fd),
-      _comms(comms),
-      _parent(parent),
-      _bufLen(0)
+    _writer->focusAbs(toDevice(target));
+
+    return requestMove(reachable(target));
+}
+
+IPState RKSC8Focuser::requestMove(uint32_t target)
 {
-    _buffer[g_bufSize] = 0;
+    cancelSettle();
+    _moveState = MV_REQUESTED;
+    _requestedTarget = target;
+    _offsetLost = false;
+    publishMotion();
+
+    // Completion is reported when the controller stops and the
+    // settle delay has elapsed
+    return IPS_BUSY;
 }
 
-bool RKSC8Focuser::HCReader::start()
+void RKSC8Focuser::moveStopped()
 {
+    if (_moveState == MV_IDLE)
+    {
+        publishMotion();
+        return;
+    }
 
-    if (pipe(_pipefd) != 0)
+    if (SettleN[0].value <= 0)
     {
-        _parent->log("Failed to allocate pipe");
-        return false;
+        _moveState = MV_IDLE;
+        publishMotion();
+        moveCompleted();
+        return;
     }
 
-    return (pthread_create(&_readThreadHandle,
-                           NULL,
-                           readThreadRedirect,
-                           this) == 0);
+    cancelSettle();
+    _moveState = MV_SETTLING;
+    _settleDoneNs = monotonicNs() + (uint64_t)(SettleN[0].value * 1e6);
+    _settleTimerId = IEAddTimer((int)SettleN[0].value, settleTimerRedirect, this);
+    publishMotion();
 }
 
-bool RKSC8Focuser::HCReader::shutdown()
+void RKSC8Focuser::moveFailed()
 {
-    close(_pipefd[1]);
+    endPrediction(_position);
+    cancelSettle();
+    _moveState = MV_IDLE;
+    if (planPending())
+    {
+        abortPlan("the controller did not answer");
+    }
+    if (calibrating())
+    {
+        finishCalibration(false, "the controller did not answer");
+    }
+    publishMotion();
+}
 
-    if (pthread_join(_readThreadHandle, NULL) != 0)
+void RKSC8Focuser::cancelSettle()
+{
+    if (_settleTimerId != -1)
     {
-        return false;
+        IERmTimer(_settleTimerId);
+        _settleTimerId = -1;
+    }
+}
+
+double RKSC8Focuser::settleRemaining() const
+{
+    if (_moveState == MV_SETTLING)
+    {
+        uint64_t nowNs = monotonicNs();
+        return (_settleDoneNs > nowNs) ? (_settleDoneNs - nowNs) / 1e9 : 0.0;
     }
 
-    return true;
+    return ((_moveState == MV_REQUESTED) || (_moveState == MV_MOVING)) ? SettleN[0].value / 1000.0 : 0.0;
 }
 
-void RKSC8Focuser::HCReader::readThread()
+/* static */ void RKSC8Focuser::settleTimerRedirect(void *obj)
 {
-    fd_set fds;
-    ssize_t bytesRead = 0;
+    RKSC8Focuser *focuser = (RKSC8Focuser *)obj;
 
-    FD_ZERO(&fds);
-    FD_SET(_fd, &fds);
-    FD_SET(_pipefd[0], &fds);
+    focuser->_settleTimerId = -1;
+    focuser->_moveState = MV_IDLE;
+    focuser->publishMotion();
+    focuser->moveCompleted();
 
-    int max_fd = _fd;
-    if (_pipefd[0] > max_fd)
-    {
-        max_fd = _pipefd[0];
-    }
-    max_fd++;
+    focuser->FocusAbsPosNP.s = focuser->moveIPState();
+    focuser->FocusRelPosNP.s = focuser->moveIPState();
+    focuser->publish(&focuser->FocusAbsPosNP);
+    focuser->publish(&focuser->FocusRelPosNP);
+}
 
-    while (select(max_fd, &fds, NULL, NULL, NULL) != -1)
+void RKSC8Focuser::moveCompleted()
+{
+    if (_planHeld)
     {
-        if (FD_ISSET(_pipefd[0], &fds))
+        _planHeld = false;
+        if (planMove(_planTarget) != IPS_BUSY)
         {
-            return;
+            abortPlan("unable to plan the move");
         }
+    }
+    else if (planRunning())
+    {
+        planStepDone();
+    }
+    else if (calibrating())
+    {
+        calibrationStep();
+    }
+
+    if (!_compAnchored && (moveIPState() == IPS_OK) && !calibrating())
+    {
+        tempCompAnchor();
+    }
+}
+
+/* static */ int RKSC8Focuser::stepRateIndex(ELS::FocusSpeed speed, ELS::Microsteps ms)
+{
+    int index = (speed == ELS::FS_X3) ? 4 : 0;
+
+    switch (ms)
+    {
+    case ELS::MS_X8:
+        break;
+    case ELS::MS_X16:
+        index += 1;
+        break;
+    case ELS::MS_X32:
+        index += 2;
+        break;
+    case ELS::MS_X64:
+        index += 3;
+        break;
+    }
+
+    return index;
+}
+
+void RKSC8Focuser::predictPosition()
+{
+    if (!_motion.moving())
+    {
+        return;
+    }
+
+    uint64_t nowNs = monotonicNs();
+    uint64_t periodNs = (uint64_t)(1e9 / TelemetryN[0].value);
+
+    // Fill the gaps between real reports; a real report always
+    // takes precedence and shares the same publish budget
+    if ((PredictS[0].s == ISS_ON) &&
+        (_positionTimerId == -1) &&
+        (nowNs - _lastPositionPublishNs >= periodNs))
+    {
+        _lastPositionPublishNs = nowNs;
+        FocusAbsPosN[0].value = _motion.predict(nowNs);
+        publish(&FocusAbsPosNP);
+    }
+
+    publishMotion();
+}
+
+/* static */ void RKSC8Focuser::predictTimerRedirect(void *obj)
+{
+    RKSC8Focuser *focuser = (RKSC8Focuser *)obj;
+
+    focuser->_predictTimerId = -1;
+    focuser->predictPosition();
+
+    if (focuser->_motion.moving())
+    {
+        int periodMs = (int)(1000.0 / focuser->TelemetryN[0].value);
+        focuser->_predictTimerId = IEAddTimer(periodMs, predictTimerRedirect, obj);
+    }
+}
+
+void RKSC8Focuser::track(RequestTracker::Command cmd)
+{
+    _tracker.issued(cmd, monotonicNs());
+
+    if (_requestTimerId == -1)
+    {
+        _requestTimerId = IEAddTimer(g_requestCheckMs, requestTimerRedirect, this);
+    }
+}
+
+void RKSC8Focuser::replied(RequestTracker::Reply reply)
+{
+    uint64_t latencyUs = 0;
+    if (!_tracker.completed(reply, monotonicNs(), 0, &latencyUs))
+    {
+        return;
+    }
+
+    if (_handshaking)
+    {
+        _handshakeReplies++;
+    }
+    if (!RequestTracker::isTelemetry(reply))
+    {
+        _metrics.roundTrip.record(latencyUs);
+    }
+}
+
+void RKSC8Focuser::checkRequests()
+{
+    RequestTracker::Command expired[8];
+    int n = 0;
 
-        if (FD_ISSET(_fd, &fds))
+    while ((n = _tracker.expire(monotonicNs(), expired, 8)) > 0)
+    {
+        for (int i = 0; i < n; i++)
         {
-            bytesRead = read(_fd,
-                             _buffer + _bufLen,
-                             g_bufSize - _bufLen);
-            _bufLen += bytesRead;
-            _buffer[_bufLen] = 0;
+            LOGF_WARN("No reply to %s", RequestTracker::commandName(expired[i]));
 
-            char *currentSegment = _buffer;
-            int bytesLeft = _bufLen;
-            while (bytesLeft > 0)
+            switch (expired[i])
             {
-                // Search for LF or CR/LF pair
-                int crIdx = -1;
-                int lfIdx = -1;
-                for (int i = 0; i < bytesLeft; i++)
+            case RequestTracker::CMD_FOCUS_REL:
+            case RequestTracker::CMD_FOCUS_ABS:
+            case RequestTracker::CMD_FOCUS_ABORT:
+                moveFailed();
+                FocusAbsPosNP.s = IPS_ALERT;
+                FocusRelPosNP.s = IPS_ALERT;
+                publish(&FocusAbsPosNP);
+                publish(&FocusRelPosNP);
+                break;
+            case RequestTracker::CMD_ENABLE_MOTOR:
+                EnableSP.s = IPS_ALERT;
+                publish(&EnableSP);
+                break;
+            case RequestTracker::CMD_ZERO:
+                ZeroSP.s = IPS_ALERT;
+                publish(&ZeroSP);
+                break;
+            case RequestTracker::CMD_SET_MICROSTEP:
+                if (calibrating())
                 {
-                    if (currentSegment[i] == '\r')
-                    {
-                        crIdx = i;
-                    }
-                    if (currentSegment[i] == '\n')
-                    {
-                        lfIdx = i;
-                        break;
-                    }
+                    finishCalibration(false, "the controller did not answer");
                 }
-
-                // Check if found
-                if (lfIdx != -1)
+                if (_planConfiguring)
+                {
+                    abortPlan("the controller did not answer");
+                }
+                MicrostepSP.s = IPS_ALERT;
+                publish(&MicrostepSP);
+                break;
+            case RequestTracker::CMD_SET_SPEED:
+                if (calibrating())
                 {
-                    int cmdLen = lfIdx;
-                    if ((crIdx != -1) && ((crIdx + 1) == lfIdx))
-                    {
-                        cmdLen -= 1;
-                    }
-                    currentSegment[cmdLen] = 0;
-
-                    if (_comms != 0)
-                    {
-                        _comms->processLine(currentSegment);
-                    }
-
-                    currentSegment += lfIdx + 1;
-                    bytesLeft -= lfIdx + 1;
-                    _bufLen -= lfIdx + 1;
+                    finishCalibration(false, "the controller did not answer");
                 }
-                else
+                if (_planConfiguring)
                 {
-                    // Were we searching from the beginning?
-                    if (currentSegment == _buffer)
-                    {
-                        // Is buffer full?
-                        if (_bufLen == g_bufSize)
-                        {
-                            _bufLen = 0;
-                        }
-                    }
-                    else
-                    {
-                        char *tmp = _buffer;
-                        while (true)
-                        {
-                            *tmp = *currentSegment;
-
-                            if (*tmp == 0)
-                            {
-                                break;
-                            }
-
-                            tmp++;
-                            currentSegment++;
-                        }
-                        _bufLen = bytesLeft;
-                    }
-
-                    bytesLeft = 0;
+                    abortPlan("the controller did not answer");
                 }
+                SpeedSP.s = IPS_ALERT;
+                publish(&SpeedSP);
+                break;
+            case RequestTracker::CMD_ENABLE_BACKLASH:
+                FocusBacklashSP.s = IPS_ALERT;
+                publish(&FocusBacklashSP);
+                break;
+            case RequestTracker::CMD_SET_BACKLASH_STEPS:
+                FocusBacklashNP.s = IPS_ALERT;
+                publish(&FocusBacklashNP);
+                break;
+            default:
+                // Queries only refresh state; nothing to flag
+                break;
             }
         }
+    }
 
-        FD_SET(_fd, &fds);
-        FD_SET(_pipefd[0], &fds);
+    if (_tracker.pending() > 0)
+    {
+        _requestTimerId = IEAddTimer(g_requestCheckMs, requestTimerRedirect, this);
     }
 }
 
-/* static */ void *RKSC8Focuser::HCReader::readThreadRedirect(void *obj)
+void RKSC8Focuser::logLatencies()
 {
-    ((HCReader *)(obj))->readThread();
+    for (int i = 0; i < RequestTracker::CMD_COUNT; i++)
+    {
+        RequestTracker::Command cmd = (RequestTracker::Command)i;
+        const LatencyHistogram &h = _tracker.histogram(cmd);
+        if (h.count() == 0)
+        {
+            continue;
+        }
 
-    return 0;
+        LOGF_DEBUG("%s: %llu replies, mean %.1f ms, p50 < %.1f ms, "
+                   "p99 < %.1f ms, max %.1f ms",
+                   RequestTracker::commandName(cmd),
+                   (unsigned long long)h.count(),
+                   h.meanUs() / 1000.0,
+                   h.percentileUs(50) / 1000.0,
+                   h.percentileUs(99) / 1000.0,
+                   h.maxUs() / 1000.0);
+    }
+}
+
+/* static */ void RKSC8Focuser::requestTimerRedirect(void *obj)
+{
+    RKSC8Focuser *focuser = (RKSC8Focuser *)obj;
+
+    focuser->_requestTimerId = -1;
+    focuser->checkRequests();
+}
+
+void RKSC8Focuser::startDiagnostics()
+{
+    _metrics.reset();
+    _diagLastNs = monotonicNs();
+    _diagLastPublishes = 0;
+    _diagTicks = 0;
+
+    if (_diagTimerId == -1)
+    {
+        _diagTimerId = IEAddTimer(g_diagnosticsPeriodMs, diagnosticsTimerRedirect, this);
+    }
+}
+
+void RKSC8Focuser::stopDiagnostics()
+{
+    if (_diagTimerId != -1)
+    {
+        IERmTimer(_diagTimerId);
+        _diagTimerId = -1;
+    }
+}
+
+void RKSC8Focuser::updateDiagnostics()
+{
+    uint64_t nowNs = monotonicNs();
+    uint64_t publishes = _metrics.publishes.get();
+    double elapsedS = (nowNs - _diagLastNs) / 1e9;
+
+    DiagnosticsN[DIAG_BYTES_READ].value = _metrics.bytesRead.get();
+    DiagnosticsN[DIAG_LINES_PARSED].value = _metrics.linesParsed.get();
+    DiagnosticsN[DIAG_LINES_DROPPED].value = _metrics.linesDropped.get();
+    DiagnosticsN[DIAG_EVENTS].value = _metrics.eventsDispatched.get();
+    DiagnosticsN[DIAG_EVENTS_DROPPED].value = _metrics.eventsDropped.get();
+    DiagnosticsN[DIAG_DISPATCH_MEAN].value = _metrics.dispatchTime.meanUs();
+    DiagnosticsN[DIAG_DISPATCH_MAX].value = _metrics.dispatchTime.maxUs();
+    DiagnosticsN[DIAG_PUBLISH_RATE].value =
+        (elapsedS > 0) ? (publishes - _diagLastPublishes) / elapsedS : 0;
+    DiagnosticsN[DIAG_RTT_MEAN].value = _metrics.roundTrip.meanUs() / 1000.0;
+    DiagnosticsN[DIAG_RTT_P99].value = _metrics.roundTrip.percentileUs(99) / 1000.0;
+
+    if (_writer != 0)
+    {
+        const CommandQueue::Stats &stats = _writer->queue()->stats();
+        DiagnosticsN[DIAG_BYTES_WRITTEN].value = stats.bytesWritten.load(std::memory_order_relaxed);
+        DiagnosticsN[DIAG_CMDS_SUPERSEDED].value = stats.superseded.load(std::memory_order_relaxed);
+        DiagnosticsN[DIAG_CMDS_REJECTED].value = stats.rejected.load(std::memory_order_relaxed);
+    }
+
+    _diagLastNs = nowNs;
+    _diagLastPublishes = publishes;
+
+    DiagnosticsNP.s = IPS_OK;
+    publish(&DiagnosticsNP);
+
+    for (int i = 0; i < RequestTracker::CMD_COUNT; i++)
+    {
+        const LatencyHistogram &h = _tracker.histogram((RequestTracker::Command)i);
+        INumber *n = &LatencyN[i * LAT_FIELDS];
+        n[LAT_REPLIES].value = h.count();
+        n[LAT_MEAN].value = h.meanUs() / 1000.0;
+        n[LAT_P99].value = h.percentileUs(99) / 1000.0;
+    }
+    LatencyNP.s = IPS_OK;
+    publish(&LatencyNP);
+
+    uint32_t interval = (uint32_t)DiagDumpIntervalN[0].value;
+    if ((interval > 0) && (++_diagTicks >= interval))
+    {
+        _diagTicks = 0;
+        dumpDiagnostics();
+    }
+}
+
+void RKSC8Focuser::dumpDiagnostics()
+{
+    const char *path = DiagDumpFileT[0].text;
+    if ((path == nullptr) || (path[0] == 0))
+    {
+        return;
+    }
+
+    FILE *fp = fopen(path, "a");
+    if (fp == nullptr)
+    {
+        LOGF_WARN("Unable to open diagnostics dump file %s: %s",
+                  path, strerror(errno));
+        return;
+    }
+
+    char timestamp[32];
+    time_t now = time(nullptr);
+    struct tm tm;
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%S",
+             gmtime_r(&now, &tm));
+
+    fprintf(fp, "%s", timestamp);
+    for (int i = 0; i < DIAG_COUNT; i++)
+    {
+        fprintf(fp, " %s=%g", DiagnosticsN[i].name, DiagnosticsN[i].value);
+    }
+    fprintf(fp, "\n");
+
+    fclose(fp);
+}
+
+/* static */ void RKSC8Focuser::diagnosticsTimerRedirect(void *obj)
+{
+    RKSC8Focuser *focuser = (RKSC8Focuser *)obj;
+
+    focuser->updateDiagnostics();
+    focuser->_diagTimerId = IEAddTimer(g_diagnosticsPeriodMs, diagnosticsTimerRedirect, obj);
+}
+
+void RKSC8Focuser::requestFraming()
+{
+    if (_writer == 0)
+    {
+        return;
+    }
+
+    // Older firmware ignores the request and stays in text mode
+    _writer->writeLine((FramingS[0].s == ISS_ON) ? BinaryFrame::g_requestBinary
+                                                 : BinaryFrame::g_requestAscii);
 }
+
+void RKSC8Focuser::framingChanged(bool framed)
+{
+    if (framed != _framed)
+    {
+        LOGF_INFO("Controller telemetry is now %s", framed ? "binary framed" : "text");
+    }
+
+    _framed = framed;
+    FramingSP.s = _framed ? IPS_OK : IPS_IDLE;
+    publish(&FramingSP);
+}
+
+void RKSC8Focuser::log(const char *fmt, ...)
+{
+    char buffer[1024];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(buffer, sizeof(buffer), fmt, args);
+    va_end(args);
+    LOG_INFO(buffer);
+}
+
+void RKSC8Focuser::logRecord(LogRing::Level level,
+                             LogRing::Category,
+                             const char *msg)
+{
+    switch (level)
+    {
+    case LogRing::LL_ERROR:
+        LOGF_ERROR("%s", msg);
+        break;
+    case LogRing::LL_WARN:
+        LOGF_WARN("%s", msg);
+        break;
+    case LogRing::LL_INFO:
+        LOGF_INFO("%s", msg);
+        break;
+    case LogRing::LL_DEBUG:
+        LOGF_DEBUG("%s", msg);
+        break;
+    case LogRing::LL_OFF:
+        break;
+    }
+}
+
+/* static */ void RKSC8Focuser::logRingRedirect(int, void *obj)
+{
+    RKSC8Focuser *focuser = (RKSC8Focuser *)obj;
+
+    focuser->_logRing.drain(focuser);
+}
+
+void RKSC8Focuser::flushPosition()
+{
+    if (_positionTimerId != -1)
+    {
+        IERmTimer(_positionTimerId);
+        _positionTimerId = -1;
+    }
+
+    _positionPending = false;
+    _lastPositionPublishNs = monotonicNs();
+    updateAbsPosition(_position);
+}
+
+/* static */ void RKSC8Focuser::positionTimerRedirect(void *obj)
+{
+    RKSC8Focuser *focuser = (RKSC8Focuser *)obj;
+
+    focuser->_positionTimerId = -1;
+    if (focuser->_positionPending)
+    {
+        focuser->flushPosition();
+    }
+}
+
+void RKSC8Focuser::publish(INumberVectorProperty *nvp)
+{
+    _metrics.publishes.add();
+    IDSetNumber(nvp, nullptr);
+}
+
+void RKSC8Focuser::publish(ISwitchVectorProperty *svp)
+{
+    _metrics.publishes.add();
+    IDSetSwitch(svp, nullptr);
+}
+
+void RKSC8Focuser::publish(ITextVectorProperty *tvp)
+{
+    _metrics.publishes.add();
+    IDSetText(tvp, nullptr);
+}
+
+void RKSC8Focuser::updateAbsPosition(uint32_t position)
+{
+    FocusAbsPosN[0].value = position;
+    FocusAbsPosNP.s = _offsetLost ? IPS_ALERT : moveIPState();
+    FocusRelPosNP.s = moveIPState();
+    publish(&FocusAbsPosNP);
+}
+
+//
+// HCWriter
+//
+
+RKSC8Focuser::HCWriter::HCWriter(RKSC8Focuser *parent)
+    : _parent(parent),
+      _render(&_rendered, parent),
+      _failed(false)
+{
+    _rendered.line[0] = 0;
+}
+
+bool RKSC8Focuser::HCWriter::open()
+{
+    return _queue.open();
+}
+
+bool RKSC8Focuser::HCWriter::writeLine(const char *line)
+{
+    return writeLine(line, CK_NONE);
+}
+
+bool RKSC8Focuser::HCWriter::writeLine(const char *line, CommandKey key, bool *superseded)
+{
+    if (_failed)
+    {
+        _parent->log("Dropped command, serial link down: %s", line);
+        return false;
+    }
+
+    if (!_queue.push(line, (uint8_t)key, CommandQueue::g_defaultPushTimeoutMs, superseded))
+    {
+        _parent->log("Dropped command, serial link saturated: %s", line);
+        return false;
+    }
+
+    return true;
+}
+
+bool RKSC8Focuser::HCWriter::focusAbs(uint32_t position)
+{
+    _render.focusAbs(position);
+    return writeKeyed(CK_FOCUS_ABS, RequestTracker::CMD_FOCUS_ABS);
+}
+
+bool RKSC8Focuser::HCWriter::setSpeed(ELS::FocusSpeed speed)
+{
+    _render.setSpeed(speed);
+    return writeKeyed(CK_SPEED, RequestTracker::CMD_SET_SPEED);
+}
+
+bool RKSC8Focuser::HCWriter::setMicrostep(ELS::Microsteps ms)
+{
+    _render.setMicrostep(ms);
+    return writeKeyed(CK_MICROSTEP, RequestTracker::CMD_SET_MICROSTEP);
+}
+
+bool RKSC8Focuser::HCWriter::setBacklashSteps(uint32_t steps)
+{
+    _render.setBacklashSteps(steps);
+    return writeKeyed(CK_BACKLASH_STEPS, RequestTracker::CMD_SET_BACKLASH_STEPS);
+}
+
+bool RKSC8Focuser::HCWriter::writeKeyed(CommandKey key, RequestTracker::Command cmd)
+{
+    bool superseded = false;
+    bool queued = writeLine(_rendered.line, key, &superseded);
+
+    // Only one reply comes for the pair
+    if (!superseded || !_parent->_tracker.pending(cmd))
+    {
+        _parent->track(cmd);
+    }
+
+    return queued;
+}
+
+bool RKSC8Focuser::HCWriter::Render::writeLine(const char *text)
+{
+    snprintf(line, sizeof(line), "%s", text);
+    return true;
+}
+
+void RKSC8Focuser::HCWriter::beginBatch()
+{
+    _queue.hold();
+}
+
+void RKSC8Focuser::HCWriter::endBatch()
+{
+    _queue.release();
+}
+
+void RKSC8Focuser::HCWriter::close()
+{
+    // Do nothing because INDI is managing the
+    // file handle
+}
+
+//
+// HCEvents
+//
+
+RKSC8Focuser::HCEvents::HCEvents(RKSC8Focuser *parent)
+    : _parent(parent),
+      _wakeupPending(false),
+      _discarding(false),
+      _overflowed(false),
+      _motionLost(false),
+      _callbackId(-1)
+{
+    _pipefd[0] = -1;
+    _pipefd[1] = -1;
+}
+
+RKSC8Focuser::HCEvents::~HCEvents()
+{
+    stop();
+}
+
+bool RKSC8Focuser::HCEvents::start()
+{
+    if (pipe2(_pipefd, O_NONBLOCK | O_CLOEXEC) != 0)
+    {
+        _parent->log("Failed to allocate event pipe");
+        return false;
+    }
+
+    _callbackId = IEAddCallback(_pipefd[0], drainRedirect, this);
+
+    return true;
+}
+
+void RKSC8Focuser::HCEvents::stop()
+{
+    if (_callbackId != -1)
+    {
+        IERmCallback(_callbackId);
+        _callbackId = -1;
+    }
+
+    for (int i = 0; i < 2; i++)
+    {
+        if (_pipefd[i] != -1)
+        {
+            close(_pipefd[i]);
+            _pipefd[i] = -1;
+        }
+    }
+}
+
+void RKSC8Focuser::HCEvents::drain()
+{
+    char scratch[64];
+    while (read(_pipefd[0], scratch, sizeof(scratch)) > 0)
+    {
+    }
+
+    // Clear before popping so an event pushed after the last pop
+    // always produces a fresh wakeup
+    _wakeupPending.store(false, std::memory_order_release);
+
+    Event ev;
+    while (_queue.pop(ev))
+    {
+        uint64_t startNs = monotonicNs();
+
+        dispatch(ev);
+
+        _parent->_metrics.dispatchTime.record((monotonicNs() - startNs) / 1000);
+        _parent->_metrics.eventsDispatched.add();
+    }
+
+    _parent->checkHandshake();
+
+    if (_overflowed.exchange(false, std::memory_order_acq_rel))
+    {
+        _parent->eventsLost(_motionLost.exchange(false, std::memory_order_acq_rel));
+    }
+}
+
+void RKSC8Focuser::HCEvents::post(EventType type, uint32_t a, uint32_t b)
+{
+    Event ev;
+    ev.type = type;
+    ev.a = a;
+    ev.b = b;
+
+    // This runs on the reactor thread, which every device's I/O
+    // waits behind, so a full queue can't wait for the main loop.
+    // Position reports are superseded by the next one, so they are
+    // the first to go as the queue fills; anything else is counted
+    // and recovered from by the next drain
+    bool isPosition = (type == EV_POSITION);
+    if (!_queue.push(ev, isPosition ? g_reservedSlots : 0))
+    {
+        if (isPosition || _discarding.load(std::memory_order_acquire))
+        {
+            return;
+        }
+
+        _parent->_metrics.eventsDropped.add();
+        if ((type == EV_MOVING_REL) || (type == EV_MOVING_ABS) || (type == EV_STOPPED))
+        {
+            _motionLost.store(true, std::memory_order_release);
+        }
+        _overflowed.store(true, std::memory_order_release);
+    }
+
+    if (!_wakeupPending.exchange(true, std::memory_order_acq_rel))
+    {
+        char c = 0;
+        if (write(_pipefd[1], &c, 1) != 1)
+        {
+            _wakeupPending.store(false, std::memory_order_release);
+        }
+    }
+}
+
+void RKSC8Focuser::HCEvents::dispatch(const Event &ev)
+{
+    switch (ev.type)
+    {
+    case EV_MOVING_REL:
+        _parent->movingRel((ELS::FocusDirection)ev.a, ev.b);
+        break;
+    case EV_MOVING_ABS:
+        _parent->movingAbs(ev.a, ev.b);
+        break;
+    case EV_STOPPED:
+        _parent->stopped(ev.a);
+        break;
+    case EV_MOTOR_ENABLED:
+        _parent->motorEnabled(ev.a != 0);
+        break;
+    case EV_ZEROED:
+        _parent->zeroed();
+        break;
+    case EV_POSITION:
+        _parent->position(ev.a);
+        break;
+    case EV_MICROSTEPS:
+        _parent->microsteps((ELS::Microsteps)ev.a);
+        break;
+    case EV_MAX_POS:
+        _parent->maxPos(ev.a);
+        break;
+    case EV_SPEED:
+        _parent->speed((ELS::FocusSpeed)ev.a);
+        break;
+    case EV_BACKLASH_ENABLED:
+        _parent->backlashEnabled(ev.a != 0);
+        break;
+    case EV_BACKLASH_STEPS:
+        _parent->backlashSteps(ev.a);
+        break;
+    case EV_LINK_LOST:
+        _parent->linkLost("the serial link failed");
+        break;
+    case EV_FRAMING:
+        _parent->framingChanged(ev.a != 0);
+        break;
+    }
+}
+
+void RKSC8Focuser::HCEvents::movingRel(ELS::FocusDirection dir,
+                                       uint32_t steps)
+{
+    _parent->_journal.append(MotionJournal::JE_MOVING_REL, dir == ELS::FD_FOCUS_OUTWARD, steps);
+    post(EV_MOVING_REL, dir, steps);
+}
+
+void RKSC8Focuser::HCEvents::movingAbs(uint32_t fromPosition,
+                                       uint32_t toPosition)
+{
+    _parent->_journal.append(MotionJournal::JE_MOVING_ABS, fromPosition, toPosition);
+    post(EV_MOVING_ABS, fromPosition, toPosition);
+}
+
+void RKSC8Focuser::HCEvents::stopped(uint32_t position)
+{
+    _parent->_journal.append(MotionJournal::JE_STOPPED, position);
+    post(EV_STOPPED, position);
+}
+
+void RKSC8Focuser::HCEvents::motorEnabled(bool isEnabled)
+{
+    post(EV_MOTOR_ENABLED, isEnabled);
+}
+
+void RKSC8Focuser::HCEvents::zeroed()
+{
+    _parent->_journal.append(MotionJournal::JE_ZEROED);
+    post(EV_ZEROED);
+}
+
+void RKSC8Focuser::HCEvents::position(uint32_t position)
+{
+    _parent->_journal.append(MotionJournal::JE_POSITION, position);
+    post(EV_POSITION, position);
+}
+
+void RKSC8Focuser::HCEvents::microsteps(ELS::Microsteps ms)
+{
+    uint32_t perStep = 64;
+    switch (ms)
+    {
+    case ELS::MS_X8:
+        perStep = 8;
+        break;
+    case ELS::MS_X16:
+        perStep = 16;
+        break;
+    case ELS::MS_X32:
+        perStep = 32;
+        break;
+    case ELS::MS_X64:
+        break;
+    }
+    _parent->_journal.append(MotionJournal::JE_MICROSTEPS, perStep);
+
+    post(EV_MICROSTEPS, ms);
+}
+
+void RKSC8Focuser::HCEvents::maxPos(uint32_t position)
+{
+    post(EV_MAX_POS, position);
+}
+
+void RKSC8Focuser::HCEvents::speed(ELS::FocusSpeed speed)
+{
+    post(EV_SPEED, speed);
+}
+
+void RKSC8Focuser::HCEvents::backlashEnabled(bool isEnabled)
+{
+    _parent->_journal.append(MotionJournal::JE_BACKLASH_ENABLED, isEnabled);
+    post(EV_BACKLASH_ENABLED, isEnabled);
+}
+
+void RKSC8Focuser::HCEvents::backlashSteps(uint32_t steps)
+{
+    _parent->_journal.append(MotionJournal::JE_BACKLASH_STEPS, steps);
+    post(EV_BACKLASH_STEPS, steps);
+}
+
+void RKSC8Focuser::HCEvents::linkLost()
+{
+    post(EV_LINK_LOST);
+}
+
+void RKSC8Focuser::HCEvents::framing(bool framed)
+{
+    post(EV_FRAMING, framed);
+}
+
+/* static */ void RKSC8Focuser::HCEvents::drainRedirect(int, void *obj)
+{
+    ((HCEvents *)(obj))->drain();
+}
+
+//
+// HCReader
+//
+
+RKSC8Focuser::HCReader::HCReader(int fd,
+                                 ELS::HostComms *comms,
+                                 CommandQueue *queue,
+                                 SerialReactor *reactor,
+                                 RKSC8Focuser *parent)
+    : _fd(fd),
+      _comms(comms),
+      _queue(queue),
+      _reactor(reactor),
+      _parent(parent),
+      _id(0),
+      _wantWrite(false),
+      _framer(this, LineFramer::g_defaultCapacity, g_bufSize)
+{
+}
+
+RKSC8Focuser::HCReader::~HCReader()
+{
+    shutdown();
+}
+
+bool RKSC8Focuser::HCReader::start()
+{
+    size_t learned = _parser.learn();
+    _parent->_logRing.post(LogRing::LL_DEBUG, LogRing::LC_COMMS,
+                           "Fast path handles %zu of %d reports",
+                           learned, (int)ResponseParser::RK_COUNT);
+
+    // Anything queued before now shows up as a pending wakeup
+    int fds[2] = {_fd, _queue->notifyFd()};
+    _id = _reactor->add(this, fds, 2);
+
+    return (_id != 0);
+}
+
+void RKSC8Focuser::HCReader::shutdown()
+{
+    _reactor->remove(_id);
+    _id = 0;
+}
+
+bool RKSC8Focuser::HCReader::ready(int fd, uint32_t events)
+{
+    bool lost = false;
+
+    if (fd == _queue->notifyFd())
+    {
+        _queue->clearNotify();
+        lost = !flushQueue();
+    }
+    else
+    {
+        if ((events & EPOLLOUT) && !flushQueue())
+        {
+            lost = true;
+        }
+
+        if (!lost && (events & (EPOLLIN | EPOLLHUP | EPOLLERR)))
+        {
+            ssize_t bytesRead = readPort();
+            if (bytesRead > 0)
+            {
+                _parent->_metrics.bytesRead.add(bytesRead);
+            }
+            if (bytesRead == 0)
+            {
+                _parent->_logRing.post(LogRing::LL_ERROR, LogRing::LC_COMMS,
+                                       "Serial port closed");
+                lost = true;
+            }
+            if ((bytesRead == -1) && (errno != EAGAIN) && (errno != EINTR))
+            {
+                _parent->_logRing.post(LogRing::LL_ERROR, LogRing::LC_COMMS,
+                                       "Serial read failed: errno %d", errno);
+                lost = true;
+            }
+        }
+    }
+
+    // Stop watching a dead port and have the main loop start
+    // reconnecting
+    if (lost)
+    {
+        _parent->_events->linkLost();
+    }
+
+    return !lost;
+}
+
+void RKSC8Focuser::HCReader::failed(int error)
+{
+    _parent->_logRing.post(LogRing::LL_ERROR, LogRing::LC_COMMS,
+                           "Serial reactor failed: errno %d", error);
+    _parent->_events->linkLost();
+}
+
+ssize_t RKSC8Focuser::HCReader::readPort()
+{
+    if (!_parent->_capture.isOpen())
+    {
+        return _framer.readFrom(_fd);
+    }
+
+    // Capturing costs a copy through a bounce buffer
+    char buffer[LineFramer::g_defaultCapacity];
+    ssize_t bytesRead = read(_fd, buffer, sizeof(buffer));
+    if (bytesRead > 0)
+    {
+        _parent->_capture.record(TrafficCapture::TD_RX, buffer, bytesRead);
+        _framer.push(buffer, bytesRead);
+    }
+
+    return bytesRead;
+}
+
+bool RKSC8Focuser::HCReader::flushQueue()
+{
+    if (!_queue->flush(_fd, &_parent->_capture))
+    {
+        _parent->_logRing.post(LogRing::LL_ERROR, LogRing::LC_COMMS,
+                               "Serial write failed: errno %d", errno);
+        return false;
+    }
+
+    // Wait for the port to drain before writing the rest
+    bool wantWrite = _queue->hasPending();
+    if (wantWrite != _wantWrite)
+    {
+        _reactor->modify(_id, _fd, wantWrite ? (EPOLLIN | EPOLLOUT) : EPOLLIN);
+        _wantWrite = wantWrite;
+    }
+
+    return true;
+}
+
+void RKSC8Focuser::HCReader::lineReceived(char *line, size_t len)
+{
+    _parent->_metrics.linesParsed.add();
+    _parent->_logRing.post(LogRing::LL_DEBUG, LogRing::LC_COMMS, "RX %s", line);
+
+    if (_parser.dispatch(line, len, _parent->_events.get()) || framingAck(line, len))
+    {
+        return;
+    }
+
+    if (_comms != 0)
+    {
+        _comms->processLine(line);
+    }
+}
+
+void RKSC8Focuser::HCReader::frameReceived(uint8_t type,
+                                           const uint8_t *payload,
+                                           size_t len)
+{
+    _parent->_metrics.linesParsed.add();
+
+    if (!BinaryFrame::dispatch(type, payload, len, _parent->_events.get()))
+    {
+        _parent->_logRing.post(LogRing::LL_DEBUG, LogRing::LC_COMMS,
+                               "Ignoring frame of type %u (%zu bytes)",
+                               (unsigned)type, len);
+    }
+}
+
+void RKSC8Focuser::HCReader::frameCorrupt()
+{
+    _parent->_metrics.linesDropped.add();
+
+    _parent->_logRing.post(LogRing::LL_WARN, LogRing::LC_COMMS,
+                           "Discarding corrupt frame");
+}
+
+bool RKSC8Focuser::HCReader::framingAck(const char *line, size_t len)
+{
+    // Compare the tail only; a text reader may see the end of
+    // some frames glued onto the front of the ack
+    static const size_t binaryLen = strlen(BinaryFrame::g_ackBinary);
+    static const size_t asciiLen = strlen(BinaryFrame::g_ackAscii);
+
+    bool framed = false;
+    if ((len >= binaryLen) &&
+        (memcmp(line + len - binaryLen, BinaryFrame::g_ackBinary, binaryLen) == 0))
+    {
+        framed = true;
+    }
+    else if ((len < asciiLen) ||
+             (memcmp(line + len - asciiLen, BinaryFrame::g_ackAscii, asciiLen) != 0))
+    {
+        return false;
+    }
+
+    _framer.setFramed(framed);
+    _parent->_events->framing(framed);
+
+    return true;
+}
+
+void RKSC8Focuser::HCReader::lineOverflow(size_t droppedBytes)
+{
+    _parent->_metrics.linesDropped.add();
+
+    _parent->_logRing.post(LogRing::LL_WARN, LogRing::LC_COMMS,
+                           "Discarding overlong line (%zu bytes buffered)",
+                           droppedBytes);
+}
+
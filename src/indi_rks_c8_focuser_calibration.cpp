@@ -0,0 +1,199 @@
+#include "indi_rks_c8_focuser.h"
+
+bool RKSC8Focuser::startCalibration()
+{
+    if (_comms == 0)
+    {
+        LOG_ERROR("Cannot calibrate while disconnected");
+        return false;
+    }
+    if (calibrating() || _plan.active() || (_moveState != MV_IDLE))
+    {
+        LOG_ERROR("Cannot calibrate while the focuser is moving");
+        return false;
+    }
+
+    LOG_INFO("Calibrating step rates for every speed and microstep setting");
+    _compAnchored = false;
+
+    _calSavedSpeed = _speed;
+    _calSavedMicrosteps = _microsteps;
+    _calCombo = 0;
+    calibrationApply(CAL_CONFIGURE, ELS::FS_NORMAL, ELS::MS_X8);
+
+    return true;
+}
+
+void RKSC8Focuser::calibrationApply(CalState state, ELS::FocusSpeed speed, ELS::Microsteps ms)
+{
+    _calState = state;
+    _calSpeed = speed;
+    _calMicrosteps = ms;
+
+    // The next step starts once both settings have been confirmed
+    _writer->beginBatch();
+    _writer->setSpeed(speed);
+    _writer->setMicrostep(ms);
+    _writer->endBatch();
+}
+
+void RKSC8Focuser::calibrationSettingsChanged()
+{
+    if (((_calState != CAL_CONFIGURE) && (_calState != CAL_RESTORE)) ||
+        (_speed != _calSpeed) || (_microsteps != _calMicrosteps) || _rebasePending)
+    {
+        return;
+    }
+
+    if (_calState == CAL_CONFIGURE)
+    {
+        // Move towards whichever end has more room
+        uint32_t inRoom = _position;
+        uint32_t outRoom = (_maxPos > _position) ? _maxPos - _position : 0;
+        _calDir = (outRoom >= inRoom) ? ELS::FD_FOCUS_OUTWARD : ELS::FD_FOCUS_INWARD;
+
+        double steps = stepRate() * CalibrateOptionsN[0].value;
+        uint32_t room = (outRoom >= inRoom) ? outRoom : inRoom;
+        _calSteps = (steps < room) ? (uint32_t)steps : room;
+
+        _calState = CAL_FORWARD;
+        calibrationMove(_calDir);
+        return;
+    }
+
+    // Settings restored; time how long the firmware's backlash
+    // take-up adds to a reversal
+    if (FocusBacklashS[0].s != ISS_ON)
+    {
+        LOG_INFO("Firmware backlash is off; skipping the reversal timing");
+        finishCalibration(true, 0);
+        return;
+    }
+
+    uint32_t inRoom = _position;
+    uint32_t outRoom = (_maxPos > _position) ? _maxPos - _position : 0;
+    _calDir = (outRoom >= inRoom) ? ELS::FD_FOCUS_OUTWARD : ELS::FD_FOCUS_INWARD;
+
+    double steps = stepRate() * CalibrateOptionsN[0].value;
+    uint32_t room = ((outRoom >= inRoom) ? outRoom : inRoom) / 2;
+    _calSteps = (steps < room) ? (uint32_t)steps : room;
+
+    _calState = CAL_PRIME;
+    calibrationMove(_calDir);
+}
+
+void RKSC8Focuser::calibrationMove(ELS::FocusDirection dir)
+{
+    uint32_t steps = _calSteps / unitFactor();
+    if (steps == 0)
+    {
+        finishCalibration(false, "no room to move");
+        return;
+    }
+
+    _comms->focusRel(dir, steps);
+    track(RequestTracker::CMD_FOCUS_REL);
+    requestMove(relativeTarget(_position, dir, steps * unitFactor()));
+
+    FocusAbsPosNP.s = IPS_BUSY;
+    publish(&FocusAbsPosNP);
+}
+
+void RKSC8Focuser::calibrationStep()
+{
+    ELS::FocusDirection back = (_calDir == ELS::FD_FOCUS_OUTWARD) ? ELS::FD_FOCUS_INWARD
+                                                                  : ELS::FD_FOCUS_OUTWARD;
+
+    switch (_calState)
+    {
+    case CAL_FORWARD:
+        _calForwardRate = _calTiming.rate();
+        _calState = CAL_BACK;
+        calibrationMove(back);
+        break;
+    case CAL_BACK:
+    {
+        int index = stepRateIndex(_calSpeed, _calMicrosteps);
+        StepRateN[index].value = (_calForwardRate + _calTiming.rate()) / 2;
+        LOGF_INFO("Calibrated %s: %.1f steps/s", StepRateN[index].label, StepRateN[index].value);
+
+        static const ELS::Microsteps g_calMicrosteps[4] = {
+            ELS::MS_X8, ELS::MS_X16, ELS::MS_X32, ELS::MS_X64};
+
+        if (++_calCombo < 8)
+        {
+            calibrationApply(CAL_CONFIGURE,
+                             (_calCombo < 4) ? ELS::FS_NORMAL : ELS::FS_X3,
+                             g_calMicrosteps[_calCombo % 4]);
+        }
+        else
+        {
+            calibrationApply(CAL_RESTORE, _calSavedSpeed, _calSavedMicrosteps);
+        }
+        break;
+    }
+    case CAL_PRIME:
+        _calState = CAL_SAME;
+        calibrationMove(_calDir);
+        break;
+    case CAL_SAME:
+        _calSameSecs = _calTiming.duration();
+        _calState = CAL_REVERSE;
+        calibrationMove(back);
+        break;
+    case CAL_REVERSE:
+    {
+        // The same distance with and without a reversal; the extra
+        // time is the controller taking up its own backlash setting,
+        // not a measure of the focuser's backlash
+        double extra = _calTiming.duration() - _calSameSecs;
+        TakeUpN[0].value = (extra > 0) ? extra : 0;
+        LOGF_INFO("The controller takes %.2f s to take up backlash on a reversal",
+                  TakeUpN[0].value);
+
+        _calState = CAL_RETURN;
+        calibrationMove(back);
+        break;
+    }
+    case CAL_RETURN:
+        finishCalibration(true, 0);
+        break;
+    default:
+        break;
+    }
+}
+
+void RKSC8Focuser::finishCalibration(bool success, const char *reason)
+{
+    CalState state = _calState;
+    _calState = CAL_IDLE;
+
+    if (!success)
+    {
+        LOGF_WARN("Calibration stopped: %s", reason);
+
+        // Put back the user's settings if a test changed them
+        if ((_comms != 0) && (state <= CAL_RESTORE) &&
+            ((_speed != _calSavedSpeed) || (_microsteps != _calSavedMicrosteps)))
+        {
+            _writer->beginBatch();
+            _writer->setSpeed(_calSavedSpeed);
+            _writer->setMicrostep(_calSavedMicrosteps);
+            _writer->endBatch();
+        }
+    }
+    else
+    {
+        LOG_INFO("Calibration complete");
+        saveConfig(true);
+    }
+
+    _motion.setProfile(stepRate(), MotionModelN[1].value);
+
+    StepRateNP.s = success ? IPS_OK : IPS_ALERT;
+    publish(&StepRateNP);
+    TakeUpNP.s = success ? IPS_OK : IPS_ALERT;
+    publish(&TakeUpNP);
+    CalibrateSP.s = success ? IPS_OK : IPS_ALERT;
+    publish(&CalibrateSP);
+}
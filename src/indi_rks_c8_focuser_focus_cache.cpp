@@ -0,0 +1,127 @@
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include "indi_rks_c8_focuser.h"
+
+bool RKSC8Focuser::ISSnoopDevice(XMLEle *root)
+{
+    const char *device = findXMLAttValu(root, "device");
+    const char *name = findXMLAttValu(root, "name");
+
+    // Filter wheel slot
+    if ((strcmp(device, SnoopT[0].text) == 0) && (strcmp(name, "FILTER_SLOT") == 0))
+    {
+        for (XMLEle *ep = nextXMLEle(root, 1); ep != nullptr; ep = nextXMLEle(root, 0))
+        {
+            if (strcmp(findXMLAttValu(ep, "name"), "FILTER_SLOT_VALUE") != 0)
+            {
+                continue;
+            }
+
+            int slot = atoi(pcdataXMLEle(ep));
+            if ((slot < 1) || (slot == _filterSlot))
+            {
+                continue;
+            }
+
+            _filterSlot = slot;
+
+            uint32_t predicted = 0;
+            if ((FocusCacheAutoS[0].s == ISS_ON) && isConnected() &&
+                focusCachePredict(&predicted))
+            {
+                if ((_moveState != MV_IDLE) || _plan.active() || calibrating())
+                {
+                    LOGF_WARN("Filter %d selected while moving; not moving to cached focus", slot);
+                }
+                else
+                {
+                    LOGF_INFO("Filter %d selected; moving to cached focus %u", slot, predicted);
+                    FocusAbsPosNP.s = MoveAbsFocuser(predicted);
+                    publish(&FocusAbsPosNP);
+                }
+            }
+            focusCacheChanged();
+        }
+    }
+
+    // Ambient temperature
+    if ((strcmp(device, SnoopT[1].text) == 0) && (strcmp(name, SnoopT[2].text) == 0))
+    {
+        for (XMLEle *ep = nextXMLEle(root, 1); ep != nullptr; ep = nextXMLEle(root, 0))
+        {
+            if (strcmp(findXMLAttValu(ep, "name"), SnoopT[3].text) == 0)
+            {
+                _ambientTemp = atof(pcdataXMLEle(ep));
+                focusCacheChanged();
+                tempCompCheck();
+            }
+        }
+    }
+
+    // Camera exposure; corrections wait until it ends
+    if ((strcmp(device, SnoopT[4].text) == 0) && (strcmp(name, "CCD_EXPOSURE") == 0))
+    {
+        bool exposing = (strcmp(findXMLAttValu(root, "state"), "Busy") == 0);
+        if (exposing != _exposing)
+        {
+            _exposing = exposing;
+            tempCompCheck();
+            publishTempComp();
+        }
+    }
+
+    return INDI::Focuser::ISSnoopDevice(root);
+}
+
+void RKSC8Focuser::snoopDevices()
+{
+    IDSnoopDevice(SnoopT[0].text, "FILTER_SLOT");
+    IDSnoopDevice(SnoopT[1].text, SnoopT[2].text);
+    IDSnoopDevice(SnoopT[4].text, "CCD_EXPOSURE");
+}
+
+void RKSC8Focuser::focusCacheChanged()
+{
+    uint32_t predicted = 0;
+    bool known = focusCachePredict(&predicted);
+
+    FocusCacheStateN[0].value = _filterSlot;
+    FocusCacheStateN[1].value = std::isnan(_ambientTemp) ? 0 : _ambientTemp;
+    FocusCacheStateN[2].value = predicted;
+    FocusCacheStateNP.s = known ? IPS_OK : IPS_IDLE;
+    publish(&FocusCacheStateNP);
+}
+
+bool RKSC8Focuser::focusCachePredict(uint32_t *position) const
+{
+    return _focusCache.predict(_filterSlot, _ambientTemp, position);
+}
+
+void RKSC8Focuser::focusCacheRecord(uint32_t position)
+{
+    if (!_focusCache.record(_filterSlot, _ambientTemp, position))
+    {
+        LOG_WARN("Focus cache is full");
+        return;
+    }
+
+    if (std::isnan(_ambientTemp))
+    {
+        LOGF_INFO("Cached focus %u for filter %d", position, _filterSlot);
+    }
+    else
+    {
+        LOGF_INFO("Cached focus %u for filter %d at %.1f C", position, _filterSlot, _ambientTemp);
+    }
+
+    if ((FocusCacheFileT[0].text[0] != 0) && !_focusCache.save(FocusCacheFileT[0].text))
+    {
+        LOGF_WARN("Unable to save focus cache to %s: %s", FocusCacheFileT[0].text, strerror(errno));
+    }
+
+    focusCacheChanged();
+    tempCompFit();
+}
@@ -0,0 +1,252 @@
+#include "libindi/connectionplugins/connectionserial.h"
+#include "libindi/eventloop.h"
+
+#include "indi_rks_c8_focuser.h"
+#include "MonotonicClock.hpp"
+
+// First reconnect delay; doubled on each failed attempt
+static const int g_reconnectBaseMs = 1000;
+
+void RKSC8Focuser::linkLost(const char *reason)
+{
+    if (_linkState != LINK_UP)
+    {
+        return;
+    }
+
+    LOGF_ERROR("Lost the link to the controller: %s", reason);
+
+    _linkState = LINK_RECONNECTING;
+    stopHeartbeat();
+    _writer->fail();
+
+    // Remember what to put back once reconnected
+    _linkSaved.speed = _speed;
+    _linkSaved.microsteps = _microsteps;
+    _linkSaved.motorEnabled = (EnableS[0].s == ISS_ON);
+    _linkSaved.backlashEnabled = (FocusBacklashS[0].s == ISS_ON);
+    _linkSaved.backlashSteps = (uint32_t)FocusBacklashN[0].value;
+    _linkSaved.devicePosition = _devicePosition;
+
+    if (planPending())
+    {
+        abortPlan("the link to the controller was lost");
+    }
+    if (calibrating())
+    {
+        finishCalibration(false, "the link to the controller was lost");
+    }
+    if (_moveState != MV_IDLE)
+    {
+        moveFailed();
+        FocusAbsPosNP.s = IPS_ALERT;
+        FocusRelPosNP.s = IPS_ALERT;
+        publish(&FocusAbsPosNP);
+        publish(&FocusRelPosNP);
+    }
+
+    // This may be running inside the event queue's drain, so the
+    // comms stack is torn down from a timer instead
+    _reconnectAttempt = 0;
+    _reconnectAtNs = monotonicNs();
+    _reconnectTimerId = IEAddTimer(0, reconnectTimerRedirect, this);
+    publishLink();
+}
+
+void RKSC8Focuser::reconnect()
+{
+    // Closing and reopening the port runs Handshake() again, which
+    // builds a fresh comms stack and sends its queries; the replies
+    // come back through reconnectDone()
+    stopComms();
+    serialConnection->Disconnect();
+
+    _reconnectAttempt++;
+    LOGF_INFO("Reconnecting (attempt %d)", _reconnectAttempt);
+
+    if (!serialConnection->Connect())
+    {
+        reconnectDone(false);
+    }
+}
+
+void RKSC8Focuser::reconnectDone(bool ok)
+{
+    if (ok)
+    {
+        LOGF_INFO("Reconnected after %d attempt%s",
+                  _reconnectAttempt, (_reconnectAttempt == 1) ? "" : "s");
+        _reconnects++;
+        _reconnectAttempt = 0;
+        replaySettings();
+        publishLink();
+        return;
+    }
+
+    // The handshake leaves the state alone when it fails
+    int maxMs = (int)(LinkOptionsN[2].value * 1000);
+    int delayMs = g_reconnectBaseMs;
+    for (int i = 1; (i < _reconnectAttempt) && (delayMs < maxMs); i++)
+    {
+        delayMs *= 2;
+    }
+    if (delayMs > maxMs)
+    {
+        delayMs = maxMs;
+    }
+
+    LOGF_WARN("Reconnect failed; retrying in %.0f s", delayMs / 1000.0);
+    _reconnectAtNs = monotonicNs() + (uint64_t)delayMs * 1000000ULL;
+    _reconnectTimerId = IEAddTimer(delayMs, reconnectTimerRedirect, this);
+    publishLink();
+}
+
+void RKSC8Focuser::replaySettings()
+{
+    // The handshake has just read back whatever the controller has
+    // now; put the settings from before the drop back over them
+    LOG_INFO("Restoring controller settings");
+
+    _writer->beginBatch();
+    _writer->setSpeed(_linkSaved.speed);
+    _writer->setMicrostep(_linkSaved.microsteps);
+    _writer->setBacklashSteps(_linkSaved.backlashSteps);
+    _comms->enableBacklash(_linkSaved.backlashEnabled && !driverBacklash());
+    track(RequestTracker::CMD_ENABLE_BACKLASH);
+    _comms->enableMotor(_linkSaved.motorEnabled);
+    track(RequestTracker::CMD_ENABLE_MOTOR);
+    _writer->endBatch();
+}
+
+void RKSC8Focuser::checkOffset(int check, bool matches, const char *what)
+{
+    _offsetChecks &= ~check;
+    if (matches)
+    {
+        return;
+    }
+
+    // The controller restarted or was changed while the link was
+    // down, so its counter no longer lines up with the offset
+    _offsetChecks = 0;
+    _offsetLost = true;
+    LOGF_WARN("The controller's %s changed while the link was down; "
+              "positions now follow its own counter", what);
+    setPosOffset(0);
+
+    FocusAbsPosNP.s = IPS_ALERT;
+    publish(&FocusAbsPosNP);
+}
+
+void RKSC8Focuser::eventsLost(bool motionLost)
+{
+    if (_comms == 0)
+    {
+        return;
+    }
+
+    LOGF_WARN("Dropped controller events (%llu so far); reading back its state",
+              (unsigned long long)_metrics.eventsDropped.get());
+
+    // There is no query for whether the motor is running, so a
+    // move that lost a motion report (possibly its stopped one) is
+    // aborted; the abort's own report ends it the usual way. Other
+    // state is simply read back
+    _writer->beginBatch();
+    if (motionLost && (_moveState != MV_IDLE))
+    {
+        _comms->focusAbort();
+        track(RequestTracker::CMD_FOCUS_ABORT);
+    }
+    _comms->getPos();
+    track(RequestTracker::CMD_GET_POS);
+    _comms->getMicrostep();
+    track(RequestTracker::CMD_GET_MICROSTEP);
+    _comms->getSpeed();
+    track(RequestTracker::CMD_GET_SPEED);
+    _comms->getMotorEnabled();
+    track(RequestTracker::CMD_GET_MOTOR_ENABLED);
+    _comms->getBacklashEnabled();
+    track(RequestTracker::CMD_GET_BACKLASH_ENABLED);
+    _comms->getBacklashSteps();
+    track(RequestTracker::CMD_GET_BACKLASH_STEPS);
+    _writer->endBatch();
+}
+
+void RKSC8Focuser::startHeartbeat()
+{
+    stopHeartbeat();
+
+    _heartbeatLines = _metrics.linesParsed.get();
+    _heartbeatMisses = 0;
+    if (LinkOptionsN[0].value > 0)
+    {
+        _heartbeatTimerId = IEAddTimer((int)(LinkOptionsN[0].value * 1000),
+                                       heartbeatTimerRedirect, this);
+    }
+}
+
+void RKSC8Focuser::stopHeartbeat()
+{
+    if (_heartbeatTimerId != -1)
+    {
+        IERmTimer(_heartbeatTimerId);
+        _heartbeatTimerId = -1;
+    }
+}
+
+void RKSC8Focuser::heartbeat()
+{
+    uint64_t lines = _metrics.linesParsed.get();
+    if (lines != _heartbeatLines)
+    {
+        _heartbeatLines = lines;
+        _heartbeatMisses = 0;
+    }
+    else if (++_heartbeatMisses > (int)LinkOptionsN[1].value)
+    {
+        linkLost("no reply to heartbeat");
+        return;
+    }
+
+    // A quiet period; ask for something so the next one isn't
+    if (_heartbeatMisses > 0)
+    {
+        _comms->getPos();
+        track(RequestTracker::CMD_GET_POS);
+    }
+
+    _heartbeatTimerId = IEAddTimer((int)(LinkOptionsN[0].value * 1000),
+                                   heartbeatTimerRedirect, this);
+}
+
+void RKSC8Focuser::publishLink()
+{
+    uint64_t nowNs = monotonicNs();
+
+    LinkStatusN[0].value = _reconnects;
+    LinkStatusN[1].value = _reconnectAttempt;
+    LinkStatusN[2].value = ((_linkState == LINK_RECONNECTING) && (_reconnectAtNs > nowNs))
+                               ? (_reconnectAtNs - nowNs) / 1e9
+                               : 0;
+    LinkStatusNP.s = (_linkState == LINK_RECONNECTING) ? IPS_ALERT
+                     : (_linkState == LINK_UP)         ? IPS_OK
+                                                       : IPS_IDLE;
+    publish(&LinkStatusNP);
+}
+
+/* static */ void RKSC8Focuser::heartbeatTimerRedirect(void *obj)
+{
+    RKSC8Focuser *focuser = (RKSC8Focuser *)obj;
+
+    focuser->_heartbeatTimerId = -1;
+    focuser->heartbeat();
+}
+
+/* static */ void RKSC8Focuser::reconnectTimerRedirect(void *obj)
+{
+    RKSC8Focuser *focuser = (RKSC8Focuser *)obj;
+
+    focuser->_reconnectTimerId = -1;
+    focuser->reconnect();
+}
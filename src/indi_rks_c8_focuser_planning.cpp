@@ -0,0 +1,317 @@
+#include "libindi/eventloop.h"
+
+#include "indi_rks_c8_focuser.h"
+#include "MonotonicClock.hpp"
+
+bool RKSC8Focuser::startSweep(const uint32_t *targets, size_t count)
+{
+    if (_comms == 0)
+    {
+        LOG_ERROR("Cannot start a focus sweep while disconnected");
+        return false;
+    }
+    if (_plan.active() || (_moveState != MV_IDLE))
+    {
+        LOG_ERROR("Cannot start a focus sweep while the focuser is moving");
+        return false;
+    }
+
+    int approachDir = (SweepApproachS[1].s == ISS_ON) ? -1 : 1;
+    uint32_t overshoot = (SweepOptionsN[1].value > 0) ? (uint32_t)SweepOptionsN[1].value
+                         : driverBacklash()           ? approachOvershoot(approachDir)
+                                                      : (uint32_t)FocusBacklashN[0].value;
+
+    _plan.begin(_position, _lastMoveDir, approachDir, overshoot, (uint32_t)FocusMaxPosN[0].value);
+    for (size_t i = 0; i < count; i++)
+    {
+        if (!_plan.approach(targets[i]))
+        {
+            LOGF_ERROR("Focus sweep has too many points (%u)", (unsigned)count);
+            _plan.clear();
+            return false;
+        }
+    }
+
+    _compAnchored = false;
+
+    LOGF_INFO("Focus sweep: %u points, %u moves",
+              (unsigned)_plan.pointCount(), (unsigned)_plan.stepCount());
+
+    _planType = PT_SWEEP;
+    _planTarget = targets[count - 1];
+    _planRetried = false;
+    _planWaiting = false;
+    SweepStatusN[0].value = 0;
+    SweepStatusN[1].value = _plan.pointCount();
+    SweepStatusN[2].value = _position;
+    SweepStatusNP.s = IPS_BUSY;
+    publish(&SweepStatusNP);
+
+    runPlan();
+
+    return true;
+}
+
+uint32_t RKSC8Focuser::approachOvershoot(int approachDir) const
+{
+    // Coming back onto the target takes up the slack of the
+    // approach direction
+    return (uint32_t)DriverBacklashN[(approachDir < 0) ? 0 : 1].value;
+}
+
+IPState RKSC8Focuser::planMove(uint32_t target)
+{
+    if (_comms == 0)
+    {
+        return IPS_ALERT;
+    }
+
+    // Speed and microsteps must not change under a running motor;
+    // stop it and plan from where it ends up
+    if (autoMotion() && ((_moveState == MV_REQUESTED) || (_moveState == MV_MOVING)))
+    {
+        if (!_planHeld)
+        {
+            _comms->focusAbort();
+            track(RequestTracker::CMD_FOCUS_ABORT);
+        }
+
+        _plan.clear();
+        _planConfiguring = false;
+        _planType = PT_MOVE;
+        _planTarget = target;
+        _planHeld = true;
+
+        return IPS_BUSY;
+    }
+
+    // Replan from where the focuser is now. A move already under
+    // way in the same direction is retargeted rather than finished
+    // first, so back-to-back moves merge into one
+    uint32_t from = (_moveState == MV_MOVING) ? _motion.predict(monotonicNs()) : _position;
+    uint32_t maxPos = (uint32_t)FocusMaxPosN[0].value;
+    int travelDir = (target > from) ? 1 : (target < from) ? -1 : _lastMoveDir;
+
+    // Without driver backlash the move just ends in its own direction
+    int approachDir = 0;
+    uint32_t overshoot = 0;
+    if (driverBacklash())
+    {
+        approachDir = (BacklashApproachS[1].s == ISS_ON) ? -1 : 1;
+        overshoot = approachOvershoot(approachDir);
+    }
+    else
+    {
+        approachDir = (travelDir < 0) ? -1 : 1;
+    }
+
+    _plan.begin(from, _lastMoveDir, approachDir, overshoot, maxPos);
+
+    uint8_t profile = MP_CURRENT;
+    if (autoMotion())
+    {
+        profile = MP_APPROACH;
+
+        // Slew most of a long move coarse and fast, stopping short of
+        // the target on the approach side
+        uint32_t distance = (target > from) ? target - from : from - target;
+        uint32_t approachLen = (uint32_t)AutoMotionN[1].value;
+        if ((distance > AutoMotionN[0].value) && (distance > approachLen))
+        {
+            int64_t slew = (int64_t)target - approachDir * (int64_t)approachLen;
+            slew = (slew < 0) ? 0 : (slew > maxPos) ? maxPos : slew;
+            _plan.add((uint32_t)slew, MotionPlan::SK_WAYPOINT, MP_SLEW);
+        }
+    }
+    if (!_plan.approach(target, MotionPlan::SK_POINT, profile))
+    {
+        LOGF_ERROR("Unable to plan a move to %u", target);
+        _plan.clear();
+        return IPS_ALERT;
+    }
+
+    if (_plan.stepCount() > 1)
+    {
+        LOGF_DEBUG("Approaching %u via %u", target, _plan.current().position);
+    }
+
+    _planType = PT_MOVE;
+    _planTarget = target;
+    _planRetried = false;
+    _planWaiting = false;
+    runPlan();
+
+    return _plan.active() ? IPS_BUSY : IPS_ALERT;
+}
+
+void RKSC8Focuser::runPlan()
+{
+    if (!_plan.active())
+    {
+        finishPlan();
+        return;
+    }
+
+    if (_planType == PT_SWEEP)
+    {
+        SweepStatusNP.s = IPS_BUSY;
+        publish(&SweepStatusNP);
+    }
+
+    // Resumes from settingsApplied() once the controller confirms
+    if (applyProfile(_plan.current().profile))
+    {
+        return;
+    }
+
+    bool running = (_moveState == MV_REQUESTED) || (_moveState == MV_MOVING);
+    _planRetarget = running ? RT_PENDING : RT_NONE;
+    if (sendAbsMove(_plan.current().position) != IPS_BUSY)
+    {
+        abortPlan("the link is down");
+        return;
+    }
+
+    FocusAbsPosNP.s = IPS_BUSY;
+    publish(&FocusAbsPosNP);
+}
+
+void RKSC8Focuser::planStepDone()
+{
+    if (_position != reachable(_plan.current().position))
+    {
+        // The move that was running when the step went out has
+        // stopped before the controller took the new target; the
+        // step's own move follows
+        if (_planRetarget == RT_PENDING)
+        {
+            return;
+        }
+
+        // The controller took the new target but still stopped
+        // short of it; reissue the step once
+        if ((_planRetarget == RT_ACKNOWLEDGED) && !_planRetried)
+        {
+            _planRetried = true;
+            runPlan();
+            return;
+        }
+    }
+
+    MotionPlan::StepKind kind = _plan.current().kind;
+    _plan.advance();
+    _planRetried = false;
+    _planRetarget = RT_NONE;
+
+    if ((kind == MotionPlan::SK_WAYPOINT) || (_planType == PT_MOVE))
+    {
+        runPlan();
+        return;
+    }
+
+    SweepStatusN[0].value = _plan.pointsDone();
+    SweepStatusN[2].value = _position;
+
+    if (!_plan.active())
+    {
+        finishPlan();
+        return;
+    }
+
+    // Park on the point; imaging software exposes on this event
+    _planWaiting = true;
+    SweepStatusNP.s = IPS_OK;
+    _metrics.publishes.add();
+    IDSetNumber(&SweepStatusNP, "Arrived at point %u of %u (position %u)",
+                (unsigned)_plan.pointsDone(), (unsigned)_plan.pointCount(), _position);
+
+    if (SweepOptionsN[0].value > 0)
+    {
+        _dwellTimerId = IEAddTimer((int)SweepOptionsN[0].value, dwellTimerRedirect, this);
+    }
+}
+
+bool RKSC8Focuser::applyProfile(uint8_t profile)
+{
+    if ((profile == MP_CURRENT) || (_comms == 0))
+    {
+        return false;
+    }
+
+    _profileSpeed = (profile == MP_SLEW) ? ELS::FS_X3 : ELS::FS_NORMAL;
+    _profileMicrosteps = (profile == MP_SLEW) ? ELS::MS_X8 : ELS::MS_X64;
+    if ((_speed == _profileSpeed) && (_microsteps == _profileMicrosteps) && !_rebasePending)
+    {
+        return false;
+    }
+
+    _planConfiguring = true;
+
+    _writer->beginBatch();
+    if (_speed != _profileSpeed)
+    {
+        _writer->setSpeed(_profileSpeed);
+    }
+    if (_microsteps != _profileMicrosteps)
+    {
+        _writer->setMicrostep(_profileMicrosteps);
+    }
+    _writer->endBatch();
+
+    return true;
+}
+
+void RKSC8Focuser::finishPlan()
+{
+    _plan.clear();
+    _planWaiting = false;
+    _planRetarget = RT_NONE;
+    _planConfiguring = false;
+
+    if (_planType == PT_SWEEP)
+    {
+        SweepStatusNP.s = IPS_OK;
+        _metrics.publishes.add();
+        IDSetNumber(&SweepStatusNP, "Focus sweep complete at position %u", _position);
+    }
+}
+
+void RKSC8Focuser::abortPlan(const char *reason)
+{
+    if (_dwellTimerId != -1)
+    {
+        IERmTimer(_dwellTimerId);
+        _dwellTimerId = -1;
+    }
+
+    if (_planType == PT_SWEEP)
+    {
+        LOGF_WARN("Focus sweep stopped after %u of %u points: %s",
+                  (unsigned)_plan.pointsDone(), (unsigned)_plan.pointCount(), reason);
+
+        SweepStatusNP.s = IPS_ALERT;
+        publish(&SweepStatusNP);
+    }
+    else
+    {
+        LOGF_WARN("Move to %u stopped: %s", _planTarget, reason);
+    }
+
+    _plan.clear();
+    _planWaiting = false;
+    _planRetarget = RT_NONE;
+    _planHeld = false;
+    _planConfiguring = false;
+}
+
+/* static */ void RKSC8Focuser::dwellTimerRedirect(void *obj)
+{
+    RKSC8Focuser *focuser = (RKSC8Focuser *)obj;
+
+    focuser->_dwellTimerId = -1;
+    if (focuser->_plan.active() && focuser->_planWaiting)
+    {
+        focuser->_planWaiting = false;
+        focuser->runPlan();
+    }
+}
@@ -0,0 +1,124 @@
+#include <cmath>
+
+#include "indi_rks_c8_focuser.h"
+#include "MonotonicClock.hpp"
+
+void RKSC8Focuser::tempCompFit()
+{
+    if (TempCompModelS[2].s == ISS_ON)
+    {
+        _tempModel.setCoefficient(TempCompSettingsN[TC_COEFFICIENT].value);
+        publishTempComp();
+        return;
+    }
+
+    // Fit from the focus cache; entries without a temperature say
+    // nothing about drift
+    TempModel::Sample samples[FocusCache::g_maxEntries];
+    size_t count = 0;
+    for (size_t i = 0; i < _focusCache.size(); i++)
+    {
+        int filter = 0;
+        double tempC = NAN;
+        uint32_t position = 0;
+        uint16_t weight = 0;
+        _focusCache.entry(i, &filter, &tempC, &position, &weight);
+        if (std::isnan(tempC))
+        {
+            continue;
+        }
+
+        samples[count].filter = filter;
+        samples[count].tempC = tempC;
+        samples[count].position = position;
+        samples[count].weight = weight;
+        count++;
+    }
+
+    TempModel::Mode mode = (TempCompModelS[1].s == ISS_ON) ? TempModel::TM_PIECEWISE
+                                                           : TempModel::TM_LINEAR;
+    if (_tempModel.fit(samples, count, mode, TempCompSettingsN[TC_SEGMENT].value))
+    {
+        LOGF_DEBUG("Temperature model: %.1f steps/C, %u segments",
+                   _tempModel.coefficient(), (unsigned)_tempModel.segments());
+    }
+
+    publishTempComp();
+}
+
+void RKSC8Focuser::tempCompAnchor()
+{
+    if (std::isnan(_ambientTemp))
+    {
+        _compAnchored = false;
+        return;
+    }
+
+    _compAnchored = true;
+    _compRefTemp = _ambientTemp;
+    _compRefPos = _position;
+    TempCompStatusN[3].value = 0;
+}
+
+void RKSC8Focuser::tempCompCheck()
+{
+    if (!tempCompEnabled() || (_comms == 0) || std::isnan(_ambientTemp) ||
+        (moveIPState() != IPS_OK) || calibrating())
+    {
+        return;
+    }
+
+    if (!_compAnchored)
+    {
+        tempCompAnchor();
+        publishTempComp();
+        return;
+    }
+
+    if (!_tempModel.valid())
+    {
+        return;
+    }
+
+    double target = _compRefPos + _tempModel.offset(_compRefTemp, _ambientTemp);
+    double error = target - _position;
+    TempCompStatusN[3].value = error;
+    publishTempComp();
+
+    // Small errors are left to accumulate, nothing moves during an
+    // exposure, and corrections are spaced out by the interval
+    if ((fabs(error) < TempCompSettingsN[TC_MIN_STEP].value) || _exposing)
+    {
+        return;
+    }
+
+    uint64_t nowNs = monotonicNs();
+    if ((_compLastNs != 0) &&
+        (nowNs - _compLastNs < (uint64_t)(TempCompSettingsN[TC_INTERVAL].value * 1e9)))
+    {
+        return;
+    }
+
+    uint32_t steps = (uint32_t)fmin(fabs(error), TempCompSettingsN[TC_MAX_STEP].value);
+    LOGF_INFO("Temperature %.2f C: correcting focus by %s%u",
+              _ambientTemp, (error < 0) ? "-" : "+", steps);
+
+    _compLastNs = nowNs;
+    _compCorrecting = true;
+    FocusAbsPosNP.s = MoveRelFocuser((error < 0) ? FOCUS_INWARD : FOCUS_OUTWARD, steps);
+    _compCorrecting = false;
+    publish(&FocusAbsPosNP);
+}
+
+void RKSC8Focuser::publishTempComp()
+{
+    TempCompStatusN[0].value = _tempModel.coefficient();
+    TempCompStatusN[1].value = _tempModel.segments();
+    TempCompStatusN[2].value = _compAnchored ? _compRefTemp : 0;
+
+    TempCompStatusNP.s = !tempCompEnabled()     ? IPS_IDLE
+                         : !_tempModel.valid()  ? IPS_ALERT
+                         : _exposing            ? IPS_BUSY
+                                                : IPS_OK;
+    publish(&TempCompStatusNP);
+}
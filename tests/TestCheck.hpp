@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdio>
+
+// Minimal checks for the behaviour tests. A failed CHECK is reported
+// and the test carries on, so one run lists every broken expectation;
+// main() returns TestCheck::result().
+namespace TestCheck
+{
+    inline int &failures()
+    {
+        static int count = 0;
+        return count;
+    }
+
+    inline int result()
+    {
+        if (failures() != 0)
+        {
+            fprintf(stderr, "%d check(s) failed\n", failures());
+            return 1;
+        }
+
+        return 0;
+    }
+}
+
+#define CHECK(expr)                                                        \
+    do                                                                     \
+    {                                                                      \
+        if (!(expr))                                                       \
+        {                                                                  \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n",                   \
+                    __FILE__, __LINE__, #expr);                            \
+            TestCheck::failures()++;                                       \
+        }                                                                  \
+    } while (0)
@@ -0,0 +1,145 @@
+// Behaviour tests for BinaryFrame: varint limits, the CRC, frame
+// layout and dispatch of value reports
+
+#include <cstring>
+
+#include "BinaryFrame.hpp"
+#include "HostCommsListener.hpp"
+#include "TestCheck.hpp"
+
+class Reports : public ELS::HostCommsListener
+{
+public:
+    Reports()
+        : calls(0),
+          last(0)
+    {
+    }
+
+    virtual void movingRel(ELS::FocusDirection, uint32_t) override {}
+    virtual void movingAbs(uint32_t, uint32_t) override {}
+    virtual void stopped(uint32_t position) override { got(position); }
+    virtual void motorEnabled(bool) override {}
+    virtual void zeroed() override {}
+    virtual void position(uint32_t position) override { got(position); }
+    virtual void microsteps(ELS::Microsteps) override {}
+    virtual void maxPos(uint32_t position) override { got(position); }
+    virtual void speed(ELS::FocusSpeed) override {}
+    virtual void backlashEnabled(bool) override {}
+    virtual void backlashSteps(uint32_t steps) override { got(steps); }
+
+    int calls;
+    uint32_t last;
+
+private:
+    void got(uint32_t value)
+    {
+        calls++;
+        last = value;
+    }
+};
+
+static void testVarint()
+{
+    uint8_t buffer[BinaryFrame::g_maxVarint];
+    uint32_t value = 0;
+
+    // Size steps at every 7 bits
+    const uint32_t edges[] = {0u, 127u, 128u, 16383u, 16384u, 2097151u, 2097152u,
+                              268435455u, 268435456u, 4294967295u};
+    const size_t sizes[] = {1, 1, 2, 2, 3, 3, 4, 4, 5, 5};
+    for (size_t i = 0; i < sizeof(edges) / sizeof(edges[0]); i++)
+    {
+        size_t len = BinaryFrame::putVarint(edges[i], buffer);
+        CHECK(len == sizes[i]);
+        CHECK(BinaryFrame::getVarint(buffer, len, &value));
+        CHECK(value == edges[i]);
+
+        // The payload must be exactly one varint
+        if (len > 1)
+        {
+            CHECK(!BinaryFrame::getVarint(buffer, len - 1, &value));
+        }
+    }
+
+    const uint8_t trailing[] = {0x05, 0x00};
+    CHECK(!BinaryFrame::getVarint(trailing, 2, &value));
+    CHECK(!BinaryFrame::getVarint(trailing, 0, &value));
+
+    // Past 32 bits, in value or in length
+    const uint8_t tooBig[] = {0xff, 0xff, 0xff, 0xff, 0x10};
+    CHECK(!BinaryFrame::getVarint(tooBig, 5, &value));
+    const uint8_t tooLong[] = {0x80, 0x80, 0x80, 0x80, 0x80, 0x00};
+    CHECK(!BinaryFrame::getVarint(tooLong, 6, &value));
+}
+
+static void testCrc()
+{
+    // The CRC-16/CCITT-FALSE check value
+    const char *check = "123456789";
+    CHECK(BinaryFrame::crc16((const uint8_t *)check, 9) == 0x29b1);
+    CHECK(BinaryFrame::crc16((const uint8_t *)check, 0) == 0xffff);
+
+    // and it can be run in pieces
+    uint16_t crc = BinaryFrame::crc16((const uint8_t *)check, 4);
+    CHECK(BinaryFrame::crc16((const uint8_t *)check + 4, 5, crc) == 0x29b1);
+}
+
+static void testEncode()
+{
+    uint8_t frame[BinaryFrame::g_maxFrame];
+
+    // Sync, length, type, one byte varint, CRC over length to payload
+    size_t len = BinaryFrame::encodeValue(BinaryFrame::FT_POSITION, 5, frame, sizeof(frame));
+    CHECK(len == 6);
+    CHECK(frame[0] == BinaryFrame::g_sync);
+    CHECK(frame[1] == 2);
+    CHECK(frame[2] == BinaryFrame::FT_POSITION);
+    CHECK(frame[3] == 5);
+    uint16_t crc = BinaryFrame::crc16(frame + 1, 3);
+    CHECK(frame[4] == (crc >> 8));
+    CHECK(frame[5] == (crc & 0xff));
+
+    // A position report is 6 to 10 bytes
+    CHECK(BinaryFrame::encodeValue(BinaryFrame::FT_POSITION, 4294967295u,
+                                   frame, sizeof(frame)) == 10);
+
+    // Too little room, or more payload than the length byte allows
+    CHECK(BinaryFrame::encodeValue(BinaryFrame::FT_POSITION, 5, frame, 5) == 0);
+    uint8_t payload[BinaryFrame::g_maxBody];
+    memset(payload, 'x', sizeof(payload));
+    CHECK(BinaryFrame::encode(BinaryFrame::FT_LINE, payload, BinaryFrame::g_maxBody - 1,
+                              frame, sizeof(frame)) == BinaryFrame::g_maxFrame);
+    CHECK(BinaryFrame::encode(BinaryFrame::FT_LINE, payload, BinaryFrame::g_maxBody,
+                              frame, sizeof(frame)) == 0);
+}
+
+static void testDispatch()
+{
+    Reports reports;
+    uint8_t varint[BinaryFrame::g_maxVarint];
+    size_t len = BinaryFrame::putVarint(70000, varint);
+
+    CHECK(BinaryFrame::dispatch(BinaryFrame::FT_STOPPED, varint, len, &reports));
+    CHECK(reports.calls == 1);
+    CHECK(reports.last == 70000);
+    CHECK(BinaryFrame::dispatch(BinaryFrame::FT_BACKLASH_STEPS, varint, len, &reports));
+    CHECK(reports.calls == 2);
+
+    // Lines are left to the caller; unknown types and bad payloads
+    // are refused
+    CHECK(!BinaryFrame::dispatch(BinaryFrame::FT_LINE, varint, len, &reports));
+    CHECK(!BinaryFrame::dispatch(99, varint, len, &reports));
+    CHECK(!BinaryFrame::dispatch(BinaryFrame::FT_POSITION, varint, len - 1, &reports));
+    CHECK(reports.calls == 2);
+}
+
+int main()
+{
+    testVarint();
+    testCrc();
+    testEncode();
+    testDispatch();
+
+    return TestCheck::result();
+}
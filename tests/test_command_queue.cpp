@@ -0,0 +1,242 @@
+// Behaviour tests for CommandQueue: batching, keyed supersede
+// ordering, partial writes, backpressure and traffic capture
+
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "CommandQueue.hpp"
+#include "TestCheck.hpp"
+#include "TrafficCapture.hpp"
+
+enum
+{
+    KEY_ABS = 1,
+    KEY_MICROSTEP
+};
+
+// Non-blocking pipe standing in for the serial port
+class Port
+{
+public:
+    Port()
+    {
+        CHECK(pipe2(fds, O_NONBLOCK) == 0);
+    }
+
+    ~Port()
+    {
+        close(fds[0]);
+        close(fds[1]);
+    }
+
+    std::string drain()
+    {
+        std::string out;
+        char buffer[4096];
+        ssize_t len;
+        while ((len = read(fds[0], buffer, sizeof(buffer))) > 0)
+        {
+            out.append(buffer, len);
+        }
+        return out;
+    }
+
+    int fds[2];
+};
+
+static void testBatch()
+{
+    Port port;
+    CommandQueue queue;
+    CHECK(queue.open());
+
+    queue.hold();
+    CHECK(queue.push("GP"));
+    CHECK(queue.push("GM"));
+    CHECK(queue.hasPending());
+
+    // Nothing goes out while held
+    CHECK(queue.flush(port.fds[1]));
+    CHECK(port.drain().empty());
+
+    queue.release();
+    CHECK(queue.flush(port.fds[1]));
+    CHECK(port.drain() == "GP\r\nGM\r\n");
+    CHECK(!queue.hasPending());
+    CHECK(queue.waitEmpty(0));
+    CHECK(queue.stats().writeCalls == 1);
+    CHECK(queue.stats().linesWritten == 2);
+}
+
+static void testSupersede()
+{
+    Port port;
+    CommandQueue queue;
+
+    // The last line queued is replaced in place
+    bool superseded = true;
+    CHECK(queue.push("ABS 100", KEY_ABS, 0, &superseded));
+    CHECK(!superseded);
+    CHECK(queue.push("ABS 200", KEY_ABS, 0, &superseded));
+    CHECK(superseded);
+    CHECK(queue.flush(port.fds[1]));
+    CHECK(port.drain() == "ABS 200\r\n");
+
+    // A command pushed in between keeps its place ahead of the
+    // replacement
+    CHECK(queue.push("ABS 100", KEY_ABS));
+    CHECK(queue.push("ABORT"));
+    CHECK(queue.push("ABS 200", KEY_ABS, 0, &superseded));
+    CHECK(superseded);
+    CHECK(queue.flush(port.fds[1]));
+    CHECK(port.drain() == "ABORT\r\nABS 200\r\n");
+
+    // A move queued between two settings doesn't run at the later one
+    CHECK(queue.push("MS 8", KEY_MICROSTEP));
+    CHECK(queue.push("ABS 300", KEY_ABS));
+    CHECK(queue.push("MS 64", KEY_MICROSTEP));
+    CHECK(queue.flush(port.fds[1]));
+    CHECK(port.drain() == "ABS 300\r\nMS 64\r\n");
+
+    // Different keys don't interact
+    CHECK(queue.push("ABS 400", KEY_ABS));
+    CHECK(queue.push("MS 16", KEY_MICROSTEP));
+    CHECK(queue.flush(port.fds[1]));
+    CHECK(port.drain() == "ABS 400\r\nMS 16\r\n");
+
+    CHECK(queue.stats().superseded == 3);
+    CHECK(queue.stats().linesQueued == 7);
+    CHECK(queue.stats().linesWritten == 7);
+}
+
+static std::string numbered(int i, char fill)
+{
+    std::string line = std::to_string(100 + i);
+    line.resize(120, fill);
+    return line;
+}
+
+static void testPartialWrite()
+{
+    Port port;
+    CommandQueue queue;
+
+    // More than a one page pipe takes in one write; every line has
+    // its own key
+    int size = fcntl(port.fds[1], F_SETPIPE_SZ, 4096);
+    CHECK(size == 4096);
+    std::string expected;
+    for (int i = 0; i < 40; i++)
+    {
+        CHECK(queue.push(numbered(i, '.').c_str(), (uint8_t)(i + 1)));
+    }
+    CHECK(queue.flush(port.fds[1]));
+    CHECK(queue.stats().partialWrites == 1);
+    CHECK(queue.hasPending());
+
+    std::string out = port.drain();
+    size_t head = out.size() / 122;
+    CHECK((out.size() % 122) != 0);
+    CHECK(head < 38);
+
+    // The partly written line can't be replaced, so its replacement
+    // follows everything queued; the next one is dropped and its
+    // replacement queued last
+    CHECK(queue.push(numbered(head, '!').c_str(), (uint8_t)(head + 1)));
+    CHECK(queue.push(numbered(head + 1, '?').c_str(), (uint8_t)(head + 2)));
+    CHECK(queue.stats().superseded == 1);
+
+    for (int i = 0; i < 40; i++)
+    {
+        if (i != (int)head + 1)
+        {
+            expected += numbered(i, '.') + "\r\n";
+        }
+    }
+    expected += numbered(head, '!') + "\r\n";
+    expected += numbered(head + 1, '?') + "\r\n";
+
+    while (queue.hasPending())
+    {
+        CHECK(queue.flush(port.fds[1]));
+        out += port.drain();
+    }
+    CHECK(out == expected);
+}
+
+static void testLimits()
+{
+    Port port;
+    CommandQueue queue;
+
+    std::string longLine(CommandQueue::g_maxLineLen + 1, 'x');
+    CHECK(!queue.push(longLine.c_str()));
+
+    for (int i = 0; i < 63; i++)
+    {
+        CHECK(queue.push("GP", 0, 0));
+    }
+    CHECK(queue.push("ABS 1", KEY_ABS, 0));
+    CHECK(!queue.push("GP", 0, 0));
+    CHECK(queue.stats().rejected == 2);
+    CHECK(!queue.waitEmpty(0));
+
+    // Replacing the last line needs no space
+    CHECK(queue.push("ABS 2", KEY_ABS, 0));
+
+    CHECK(queue.flush(port.fds[1]));
+    std::string out = port.drain();
+    CHECK(out.size() == 63 * 4 + 7);
+    CHECK(out.compare(out.size() - 7, 7, "ABS 2\r\n") == 0);
+    CHECK(queue.push("GP", 0, 0));
+}
+
+static void testCapture()
+{
+    char path[] = "/tmp/rks_c8_capture_XXXXXX";
+    int fd = mkstemp(path);
+    CHECK(fd >= 0);
+    close(fd);
+
+    Port port;
+    CommandQueue queue;
+    TrafficCapture capture;
+
+    // Nothing is recorded while the capture isn't running
+    CHECK(queue.push("GP"));
+    CHECK(queue.flush(port.fds[1], &capture));
+    CHECK(port.drain() == "GP\r\n");
+
+    // Only what reaches the fd is recorded, so a superseded line never
+    // appears
+    CHECK(capture.open(path));
+    CHECK(queue.push("SS 1", KEY_MICROSTEP));
+    CHECK(queue.push("SS 0", KEY_MICROSTEP));
+    CHECK(queue.push("GS"));
+    CHECK(queue.flush(port.fds[1], &capture));
+    CHECK(port.drain() == "SS 0\r\nGS\r\n");
+    capture.close();
+
+    std::vector<TrafficCapture::Chunk> chunks;
+    CHECK(TrafficCapture::load(path, &chunks));
+    CHECK(chunks.size() == 1);
+    CHECK(chunks[0].direction == TrafficCapture::TD_TX);
+    CHECK(chunks[0].data == "SS 0\r\nGS\r\n");
+
+    unlink(path);
+}
+
+int main()
+{
+    testBatch();
+    testSupersede();
+    testPartialWrite();
+    testLimits();
+    testCapture();
+
+    return TestCheck::result();
+}
@@ -0,0 +1,147 @@
+// Behaviour tests for FocusCache: binning, weighted merging,
+// interpolation limits, re-binning and the saved table
+
+#include <cmath>
+#include <cstdio>
+#include <unistd.h>
+
+#include "FocusCache.hpp"
+#include "TestCheck.hpp"
+
+static void testRecord()
+{
+    FocusCache cache;
+    uint32_t position = 0;
+
+    CHECK(!cache.predict(1, 10.0, &position));
+
+    // 10.0 and 11.5 share the 2 degree bin [10, 12)
+    CHECK(cache.record(1, 10.0, 5000));
+    CHECK(cache.record(1, 11.5, 5100));
+    CHECK(cache.size() == 1);
+    CHECK(cache.predict(1, 11.9, &position));
+    CHECK(position == 5050);
+
+    // Older results stop counting for more than g_maxWeight
+    for (int i = 0; i < 10; i++)
+    {
+        CHECK(cache.record(1, 10.0, 6000));
+    }
+    CHECK(cache.predict(1, 10.0, &position));
+    CHECK((position > 5900) && (position < 6000));
+
+    int filter = 0;
+    double tempC = 0;
+    uint16_t samples = 0;
+    cache.entry(0, &filter, &tempC, &position, &samples);
+    CHECK(filter == 1);
+    CHECK(tempC == 11.0);
+    CHECK(samples == FocusCache::g_maxWeight);
+
+    // No temperature is a bin of its own, and only ever matches itself
+    CHECK(cache.record(1, NAN, 4000));
+    CHECK(cache.predict(1, NAN, &position));
+    CHECK(position == 4000);
+    CHECK(cache.predict(1, 10.0, &position));
+    CHECK(position != 4000);
+    CHECK(!cache.predict(2, NAN, &position));
+}
+
+static void testPredict()
+{
+    FocusCache cache;
+    uint32_t position = 0;
+
+    CHECK(cache.record(1, 0.5, 1000));
+    CHECK(cache.record(1, 8.5, 2000));
+    CHECK(cache.record(2, 4.5, 9000));
+
+    // Between bins centred on 1 and 9
+    CHECK(cache.predict(1, 5.0, &position));
+    CHECK(position == 1500);
+    CHECK(cache.predict(1, 3.0, &position));
+    CHECK(position == 1250);
+
+    // One side only: the next bin along stands in
+    CHECK(cache.predict(1, 10.5, &position));
+    CHECK(position == 2000);
+    CHECK(cache.predict(1, -1.0, &position));
+    CHECK(position == 1000);
+
+    // but nothing further away
+    CHECK(!cache.predict(1, 12.5, &position));
+    CHECK(!cache.predict(1, -3.0, &position));
+    CHECK(!cache.predict(2, 20.0, &position));
+
+    // Other filters never contribute
+    CHECK(!cache.predict(3, 4.5, &position));
+}
+
+static void testBinWidth()
+{
+    FocusCache cache;
+    uint32_t position = 0;
+
+    CHECK(cache.record(1, 0.5, 1000));
+    CHECK(cache.record(1, 2.5, 2000));
+    CHECK(cache.size() == 2);
+
+    // Both centres fall in [0, 4), so the entries merge
+    cache.setBinWidth(4.0);
+    CHECK(cache.binWidth() == 4.0);
+    CHECK(cache.size() == 1);
+    CHECK(cache.predict(1, 3.0, &position));
+    CHECK(position == 1500);
+
+    // Nonsense widths are ignored
+    cache.setBinWidth(0);
+    CHECK(cache.binWidth() == 4.0);
+}
+
+static void testSaveLoad()
+{
+    char path[] = "/tmp/rks_c8_focus_cache_XXXXXX";
+    int fd = mkstemp(path);
+    CHECK(fd >= 0);
+    close(fd);
+
+    FocusCache cache;
+    CHECK(cache.record(1, 10.0, 5000));
+    CHECK(cache.record(1, 10.0, 5000));
+    CHECK(cache.record(2, NAN, 7000));
+    CHECK(cache.save(path));
+
+    // Loaded at a different width, the entry keeps its centre
+    FocusCache loaded;
+    loaded.setBinWidth(1.0);
+    CHECK(loaded.record(3, 0, 1));
+    CHECK(loaded.load(path));
+    CHECK(loaded.size() == 2);
+
+    uint32_t position = 0;
+    CHECK(loaded.predict(1, 11.2, &position));
+    CHECK(position == 5000);
+    CHECK(!loaded.predict(1, 9.2, &position));
+    CHECK(loaded.predict(2, NAN, &position));
+    CHECK(position == 7000);
+    CHECK(!loaded.predict(3, 0, &position));
+
+    int filter = 0;
+    double tempC = 0;
+    uint16_t samples = 0;
+    loaded.entry(0, &filter, &tempC, &position, &samples);
+    CHECK(samples == 2);
+
+    unlink(path);
+    CHECK(!loaded.load(path));
+}
+
+int main()
+{
+    testRecord();
+    testPredict();
+    testBinWidth();
+    testSaveLoad();
+
+    return TestCheck::result();
+}
@@ -0,0 +1,309 @@
+// Behaviour tests for LineFramer: delimiters, lines that wrap around
+// the end of the ring, recovery from overlong input, and framed mode
+
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "BinaryFrame.hpp"
+#include "LineFramer.hpp"
+#include "TestCheck.hpp"
+
+class Lines : public LineFramer::Listener
+{
+public:
+    Lines()
+        : framer(0),
+          corrupt(0)
+    {
+    }
+
+    virtual void lineReceived(char *line, size_t len) override
+    {
+        CHECK(strlen(line) == len);
+        lines.push_back(std::string(line, len));
+
+        // Acts on framing acks the way the driver does
+        if (framer != 0)
+        {
+            if (lines.back() == BinaryFrame::g_ackBinary)
+            {
+                framer->setFramed(true);
+            }
+            if (lines.back() == BinaryFrame::g_ackAscii)
+            {
+                framer->setFramed(false);
+            }
+        }
+    }
+
+    virtual void lineOverflow(size_t droppedBytes) override
+    {
+        overflows.push_back(droppedBytes);
+    }
+
+    virtual void frameReceived(uint8_t type, const uint8_t *payload, size_t len) override
+    {
+        uint32_t value = 0;
+        CHECK(BinaryFrame::getVarint(payload, len, &value));
+        frames.push_back(std::make_pair(type, value));
+    }
+
+    virtual void frameCorrupt() override
+    {
+        corrupt++;
+    }
+
+    LineFramer *framer;
+    std::vector<std::string> lines;
+    std::vector<size_t> overflows;
+    std::vector<std::pair<uint8_t, uint32_t>> frames;
+    int corrupt;
+};
+
+static std::string valueFrame(BinaryFrame::Type type, uint32_t value)
+{
+    uint8_t buffer[BinaryFrame::g_maxFrame];
+    size_t len = BinaryFrame::encodeValue(type, value, buffer, sizeof(buffer));
+    CHECK(len > 0);
+    return std::string((const char *)buffer, len);
+}
+
+static std::string lineFrame(const std::string &line)
+{
+    uint8_t buffer[BinaryFrame::g_maxFrame];
+    size_t len = BinaryFrame::encode(BinaryFrame::FT_LINE,
+                                     (const uint8_t *)line.data(),
+                                     line.size(),
+                                     buffer,
+                                     sizeof(buffer));
+    CHECK(len > 0);
+    return std::string((const char *)buffer, len);
+}
+
+static void testEndings()
+{
+    Lines sink;
+    LineFramer framer(&sink);
+
+    framer.push("A\r\nBB\n\r\nCCC", 11);
+    CHECK(sink.lines.size() == 3);
+    CHECK(sink.lines[0] == "A");
+    CHECK(sink.lines[1] == "BB");
+    CHECK(sink.lines[2] == "");
+    CHECK(framer.pending() == 3);
+
+    // The rest of a partial line completes it
+    framer.push("\n", 1);
+    CHECK(sink.lines.size() == 4);
+    CHECK(sink.lines[3] == "CCC");
+    CHECK(framer.pending() == 0);
+    CHECK(framer.lineCount() == 4);
+}
+
+static void testWraparound()
+{
+    Lines sink;
+    LineFramer framer(&sink, 0, 40);
+    size_t capacity = framer.capacity();
+
+    // Line lengths that don't divide the ring, fed one byte at a time
+    // so that lines straddle the end of the ring on every lap
+    std::vector<std::string> sent;
+    size_t total = 0;
+    for (int i = 0; total < 3 * capacity; i++)
+    {
+        std::string line = "P " + std::to_string(i * 7919);
+        line.append(i % 13, 'x');
+        sent.push_back(line);
+        line += (i % 2) ? "\r\n" : "\n";
+        for (size_t b = 0; b < line.size(); b++)
+        {
+            framer.push(&line[b], 1);
+        }
+        total += line.size();
+    }
+
+    CHECK(sink.lines == sent);
+    CHECK(sink.overflows.empty());
+
+    // Large pushes that wrap in one go
+    sink.lines.clear();
+    std::string burst;
+    for (const std::string &line : sent)
+    {
+        burst += line + "\n";
+    }
+    framer.push(burst.data(), burst.size());
+    CHECK(sink.lines == sent);
+}
+
+static void testOverflow()
+{
+    Lines sink;
+    LineFramer framer(&sink, 0, 16);
+
+    // A partial line past the limit is dropped up to the next
+    // delimiter, however many reads it takes to arrive
+    std::string junk(40, 'j');
+    framer.push(junk.data(), junk.size());
+    CHECK(sink.overflows.size() == 1);
+    CHECK(sink.overflows[0] == 40);
+    framer.push(junk.data(), junk.size());
+    CHECK(sink.overflows.size() == 1);
+    framer.push("jj\nOK\n", 6);
+    CHECK(sink.lines.size() == 1);
+    CHECK(sink.lines[0] == "OK");
+
+    // An overlong line that arrives complete is reported the same way
+    std::string whole(20, 'w');
+    whole += "\nNEXT\n";
+    framer.push(whole.data(), whole.size());
+    CHECK(sink.overflows.size() == 2);
+    CHECK(sink.overflows[1] == 20);
+    CHECK(sink.lines.size() == 2);
+    CHECK(sink.lines[1] == "NEXT");
+
+    // Exactly the limit still fits
+    std::string limit(16, 'l');
+    limit += "\r\n";
+    framer.push(limit.data(), limit.size());
+    CHECK(sink.lines.size() == 3);
+    CHECK(sink.lines[2] == std::string(16, 'l'));
+    CHECK(framer.overflowCount() == 2);
+
+    // reset() throws away a partial line
+    framer.push("stale", 5);
+    framer.reset();
+    framer.push("fresh\n", 6);
+    CHECK(sink.lines.back() == "fresh");
+}
+
+static void testReadFrom()
+{
+    int fds[2];
+    CHECK(pipe(fds) == 0);
+
+    Lines sink;
+    LineFramer framer(&sink);
+
+    const char *input = "P 1\nP 2\nP";
+    CHECK(write(fds[1], input, strlen(input)) == (ssize_t)strlen(input));
+    CHECK(framer.readFrom(fds[0]) == (ssize_t)strlen(input));
+    CHECK(sink.lines.size() == 2);
+
+    CHECK(write(fds[1], " 3\n", 3) == 3);
+    close(fds[1]);
+    CHECK(framer.readFrom(fds[0]) == 3);
+    CHECK(sink.lines.size() == 3);
+    CHECK(sink.lines[2] == "P 3");
+
+    // EOF
+    CHECK(framer.readFrom(fds[0]) == 0);
+    close(fds[0]);
+}
+
+static void testFramed()
+{
+    Lines sink;
+    LineFramer framer(&sink, 0, 64);
+    sink.framer = &framer;
+
+    // Text up to the ack, frames from the next byte on, including
+    // ones in the same read
+    std::string input = "P 1\n";
+    input += BinaryFrame::g_ackBinary;
+    input += "\r\n";
+    input += valueFrame(BinaryFrame::FT_POSITION, 300);
+    input += lineFrame("MS 64");
+    framer.push(input.data(), input.size());
+    CHECK(framer.framed());
+    CHECK(sink.lines.size() == 3);
+    CHECK(sink.lines[2] == "MS 64");
+    CHECK(sink.frames.size() == 1);
+    CHECK(sink.frames[0].first == BinaryFrame::FT_POSITION);
+    CHECK(sink.frames[0].second == 300);
+
+    // Split anywhere, including inside the length and CRC
+    std::string frame = valueFrame(BinaryFrame::FT_STOPPED, 4000000000u);
+    for (size_t b = 0; b < frame.size(); b++)
+    {
+        framer.push(&frame[b], 1);
+    }
+    CHECK(sink.frames.size() == 2);
+    CHECK(sink.frames[1].second == 4000000000u);
+    CHECK(framer.frameCount() == 3);
+
+    // A bad CRC is reported and the framer resyncs on the next frame;
+    // so is noise between frames
+    frame = valueFrame(BinaryFrame::FT_MAX_POS, 12345);
+    frame[frame.size() - 1] ^= 0x01;
+    input = frame + "noise" + valueFrame(BinaryFrame::FT_MAX_POS, 54321);
+    framer.push(input.data(), input.size());
+    CHECK(sink.corrupt == 1);
+    CHECK(sink.frames.size() == 3);
+    CHECK(sink.frames[2].second == 54321);
+
+    // A length of zero can't be a frame
+    input = std::string("\xa5\x00", 2) + valueFrame(BinaryFrame::FT_POSITION, 7);
+    framer.push(input.data(), input.size());
+    CHECK(sink.corrupt == 2);
+    CHECK(sink.frames.back().second == 7);
+    CHECK(framer.corruptCount() == 2);
+}
+
+static void testFramedAck()
+{
+    Lines sink;
+    LineFramer framer(&sink, 0, 64);
+    sink.framer = &framer;
+    framer.setFramed(true);
+
+    // A stray mark is noise once a frame starts
+    std::string input = "#x" + valueFrame(BinaryFrame::FT_POSITION, 1);
+    framer.push(input.data(), input.size());
+    CHECK(sink.frames.size() == 1);
+    CHECK(sink.lines.empty());
+
+    // The ack comes back as plain text between frames, in pieces,
+    // and text follows it
+    input = valueFrame(BinaryFrame::FT_POSITION, 2);
+    input += BinaryFrame::g_ackAscii;
+    input += "\r\nP 3\n";
+    framer.push(input.data(), 10);
+    framer.push(input.data() + 10, input.size() - 10);
+    CHECK(!framer.framed());
+    CHECK(sink.frames.size() == 2);
+    CHECK(sink.lines.size() == 2);
+    CHECK(sink.lines[0] == BinaryFrame::g_ackAscii);
+    CHECK(sink.lines[1] == "P 3");
+
+    // A framed ack works too
+    framer.setFramed(true);
+    input = lineFrame(BinaryFrame::g_ackAscii) + "P 4\n";
+    framer.push(input.data(), input.size());
+    CHECK(!framer.framed());
+    CHECK(sink.lines.back() == "P 4");
+
+    // A mark with no line end in sight is dropped
+    framer.setFramed(true);
+    std::string junk = "#" + std::string(100, 'j');
+    framer.push(junk.data(), junk.size());
+    input = valueFrame(BinaryFrame::FT_POSITION, 5);
+    framer.push(input.data(), input.size());
+    CHECK(sink.frames.back().second == 5);
+    CHECK(sink.lines.size() == 4);
+}
+
+int main()
+{
+    testEndings();
+    testWraparound();
+    testOverflow();
+    testReadFrom();
+    testFramed();
+    testFramedAck();
+
+    return TestCheck::result();
+}
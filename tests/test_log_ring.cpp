@@ -0,0 +1,157 @@
+// Behaviour tests for LogRing: deferred formatting, string handling,
+// truncation, level gating and overflow counting
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "LogRing.hpp"
+#include "TestCheck.hpp"
+
+// Keeps everything drained from the ring
+class Collector : public LogRing::Sink
+{
+public:
+    virtual void logRecord(LogRing::Level level, LogRing::Category category, const char *msg) override
+    {
+        levels.push_back(level);
+        categories.push_back(category);
+        messages.push_back(msg);
+    }
+
+    std::vector<LogRing::Level> levels;
+    std::vector<LogRing::Category> categories;
+    std::vector<std::string> messages;
+};
+
+static void testFormat()
+{
+    LogRing ring;
+    CHECK(ring.open());
+
+    size_t lines = 12;
+    unsigned long long bytes = 1234567890123ULL;
+    ring.post(LogRing::LL_INFO, LogRing::LC_COMMS, "%zu lines, %llu bytes", lines, bytes);
+    ring.post(LogRing::LL_WARN, LogRing::LC_MOTION, "rate %.1f steps/s, %d%%", 123.45, -7);
+
+    // The caller's buffer can change as soon as post() returns
+    char name[16];
+    strcpy(name, "GP");
+    ring.post(LogRing::LL_INFO, LogRing::LC_COMMS, "No reply to %s after %u ms", name, 250u);
+    strcpy(name, "XX");
+
+    // A width applies to the copied text too
+    ring.post(LogRing::LL_INFO, LogRing::LC_COMMS, "[%4s]", "ab");
+
+    Collector sink;
+    ring.drain(&sink);
+    CHECK(sink.messages.size() == 4);
+    CHECK(sink.messages[0] == "12 lines, 1234567890123 bytes");
+    CHECK(sink.messages[1] == "rate 123.5 steps/s, -7%");
+    CHECK(sink.messages[2] == "No reply to GP after 250 ms");
+    CHECK(sink.messages[3] == "[  ab]");
+    CHECK(sink.levels[1] == LogRing::LL_WARN);
+    CHECK(sink.categories[1] == LogRing::LC_MOTION);
+}
+
+static void testStrings()
+{
+    LogRing ring;
+    CHECK(ring.open());
+
+    // Only the first string is copied; later ones are elided
+    ring.post(LogRing::LL_INFO, LogRing::LC_COMMS, "%s then %s", "first", "second");
+
+    // and a long one is cut to fit the record
+    std::string longText(100, 'x');
+    ring.post(LogRing::LL_INFO, LogRing::LC_COMMS, "%s", longText.c_str());
+
+    ring.post(LogRing::LL_INFO, LogRing::LC_COMMS, "%s", (const char *)0);
+
+    // Missing arguments render as nothing rather than garbage
+    ring.post(LogRing::LL_INFO, LogRing::LC_COMMS, "%d and %d", 1);
+
+    Collector sink;
+    ring.drain(&sink);
+    CHECK(sink.messages.size() == 4);
+    CHECK(sink.messages[0] == "first then ...");
+    CHECK(sink.messages[1] == std::string(LogRing::g_maxText - 1, 'x'));
+    CHECK(sink.messages[2] == "(null)");
+    CHECK(sink.messages[3] == "1 and ");
+}
+
+static void testTruncation()
+{
+    LogRing ring;
+    CHECK(ring.open());
+
+    // Formatted messages are cut at 512 bytes, terminator included.
+    // The format only has to outlive the drain
+    std::string fmt = std::string(500, 'a') + "%s and more";
+    ring.post(LogRing::LL_INFO, LogRing::LC_COMMS, fmt.c_str(), "XYZ");
+
+    Collector sink;
+    ring.drain(&sink);
+    CHECK(sink.messages.size() == 1);
+    CHECK(sink.messages[0] == std::string(500, 'a') + "XYZ and mor");
+}
+
+static void testLevels()
+{
+    LogRing ring;
+    CHECK(ring.open());
+
+    // INFO by default, set per category
+    CHECK(ring.level(LogRing::LC_POSITION) == LogRing::LL_INFO);
+    CHECK(ring.enabled(LogRing::LC_POSITION, LogRing::LL_INFO));
+    CHECK(!ring.enabled(LogRing::LC_POSITION, LogRing::LL_DEBUG));
+
+    ring.setLevel(LogRing::LC_POSITION, LogRing::LL_OFF);
+    ring.setLevel(LogRing::LC_MOTION, LogRing::LL_DEBUG);
+    ring.post(LogRing::LL_ERROR, LogRing::LC_POSITION, "position %u", 1u);
+    ring.post(LogRing::LL_DEBUG, LogRing::LC_MOTION, "motion %u", 2u);
+    ring.post(LogRing::LL_DEBUG, LogRing::LC_COMMS, "comms %u", 3u);
+    ring.post(LogRing::LL_WARN, LogRing::LC_COMMS, "comms %u", 4u);
+
+    Collector sink;
+    ring.drain(&sink);
+    CHECK(sink.messages.size() == 2);
+    CHECK(sink.messages[0] == "motion 2");
+    CHECK(sink.messages[1] == "comms 4");
+}
+
+static void testDropped()
+{
+    LogRing ring;
+    CHECK(ring.open());
+
+    // Records that don't fit are counted, not queued
+    for (unsigned i = 0; i < 300; i++)
+    {
+        ring.post(LogRing::LL_INFO, LogRing::LC_COMMS, "record %u", i);
+    }
+    CHECK(ring.dropped() == 300 - 256);
+
+    Collector sink;
+    ring.drain(&sink);
+    CHECK(sink.messages.size() == 256);
+    CHECK(sink.messages.back() == "record 255");
+
+    // Gated records aren't drops
+    ring.post(LogRing::LL_DEBUG, LogRing::LC_COMMS, "record %u", 0u);
+    ring.post(LogRing::LL_INFO, LogRing::LC_COMMS, "record %u", 1u);
+    CHECK(ring.dropped() == 300 - 256);
+    ring.drain(&sink);
+    CHECK(sink.messages.size() == 257);
+}
+
+int main()
+{
+    testFormat();
+    testStrings();
+    testTruncation();
+    testLevels();
+    testDropped();
+
+    return TestCheck::result();
+}
@@ -0,0 +1,169 @@
+// Behaviour tests for MotionJournal: allocation, reopening, ring
+// wraparound and read-only access
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+#include "MotionJournal.hpp"
+#include "TestCheck.hpp"
+
+static std::string tempPath()
+{
+    char path[] = "/tmp/rks_c8_journal_XXXXXX";
+    int fd = mkstemp(path);
+    CHECK(fd >= 0);
+    close(fd);
+    return path;
+}
+
+static void testOpen()
+{
+    std::string path = tempPath();
+    MotionJournal journal;
+
+    CHECK(!journal.isOpen());
+    journal.append(MotionJournal::JE_POSITION, 1);
+    CHECK(!journal.open(path.c_str(), 0));
+    CHECK(!journal.open("/nonexistent/journal.bin", 16));
+
+    // Sized and allocated up front, not left sparse
+    CHECK(journal.open(path.c_str(), 16));
+    struct stat st;
+    CHECK(stat(path.c_str(), &st) == 0);
+    size_t size = sizeof(MotionJournal::Header) + 16 * sizeof(MotionJournal::Record);
+    CHECK((size_t)st.st_size == size);
+    CHECK((size_t)st.st_blocks * 512 >= size);
+
+    // Opening is journaled
+    CHECK(journal.first() == 0);
+    CHECK(journal.end() == 1);
+    MotionJournal::Record rec;
+    CHECK(journal.read(0, &rec));
+    CHECK(rec.type == MotionJournal::JE_OPEN);
+    CHECK(rec.timeNs > 0);
+
+    journal.append(MotionJournal::JE_MOVING_ABS, 100, 200);
+    int64_t offset = -5000000000LL;
+    journal.append(MotionJournal::JE_OFFSET, (uint32_t)offset, (uint32_t)((uint64_t)offset >> 32));
+    journal.close();
+    CHECK(!journal.isOpen());
+
+    // The same layout keeps its records
+    CHECK(journal.open(path.c_str(), 16));
+    CHECK(journal.end() == 4);
+    CHECK(journal.read(1, &rec));
+    CHECK(rec.type == MotionJournal::JE_MOVING_ABS);
+    CHECK((rec.a == 100) && (rec.b == 200));
+    CHECK(journal.read(2, &rec));
+    CHECK((int64_t)(((uint64_t)rec.b << 32) | rec.a) == offset);
+    CHECK(!journal.read(4, &rec));
+    journal.close();
+
+    // A different one starts over
+    CHECK(journal.open(path.c_str(), 32));
+    CHECK(journal.end() == 1);
+    journal.close();
+
+    unlink(path.c_str());
+}
+
+static void testWrap()
+{
+    std::string path = tempPath();
+    MotionJournal journal;
+    CHECK(journal.open(path.c_str(), 8));
+
+    for (uint32_t i = 0; i < 20; i++)
+    {
+        journal.append(MotionJournal::JE_POSITION, i);
+    }
+
+    // 21 records through an 8 slot ring
+    CHECK(journal.end() == 21);
+    CHECK(journal.first() == 13);
+
+    MotionJournal::Record rec;
+    CHECK(!journal.read(12, &rec));
+    for (uint64_t i = journal.first(); i < journal.end(); i++)
+    {
+        CHECK(journal.read(i, &rec));
+        CHECK(rec.type == MotionJournal::JE_POSITION);
+        CHECK(rec.a == i - 1);
+        CHECK(rec.seq == (uint32_t)(i + 1));
+    }
+
+    // Readers see the writer's records through their own mapping
+    MotionJournal reader;
+    CHECK(reader.openReadOnly(path.c_str()));
+    journal.append(MotionJournal::JE_STOPPED, 99);
+    CHECK(reader.end() == 22);
+    CHECK(reader.read(21, &rec));
+    CHECK(rec.type == MotionJournal::JE_STOPPED);
+
+    // and can't write
+    reader.append(MotionJournal::JE_ZEROED);
+    CHECK(journal.end() == 22);
+
+    reader.close();
+    journal.close();
+    unlink(path.c_str());
+
+    CHECK(!reader.openReadOnly(path.c_str()));
+}
+
+static void testWriters()
+{
+    std::string path = tempPath();
+    MotionJournal journal;
+    CHECK(journal.open(path.c_str(), 4096));
+
+    // The reader thread and the main loop both append
+    std::thread other([&journal]() {
+        for (uint32_t i = 0; i < 1000; i++)
+        {
+            journal.append(MotionJournal::JE_POSITION, i);
+        }
+    });
+    for (uint32_t i = 0; i < 1000; i++)
+    {
+        journal.append(MotionJournal::JE_OFFSET, i);
+    }
+    other.join();
+
+    CHECK(journal.end() == 2001);
+    uint32_t nextPosition = 0;
+    uint32_t nextOffset = 0;
+    MotionJournal::Record rec;
+    for (uint64_t i = 1; i < journal.end(); i++)
+    {
+        CHECK(journal.read(i, &rec));
+        uint32_t &next = (rec.type == MotionJournal::JE_POSITION) ? nextPosition : nextOffset;
+        CHECK(rec.a == next);
+        next++;
+    }
+    CHECK((nextPosition == 1000) && (nextOffset == 1000));
+
+    journal.close();
+    unlink(path.c_str());
+}
+
+static void testNames()
+{
+    CHECK(strcmp(MotionJournal::eventName(MotionJournal::JE_OPEN), "open") == 0);
+    CHECK(strcmp(MotionJournal::eventName(MotionJournal::JE_OFFSET), "offset") == 0);
+    CHECK(strcmp(MotionJournal::eventName(0), "unknown") == 0);
+}
+
+int main()
+{
+    testOpen();
+    testWrap();
+    testWriters();
+    testNames();
+
+    return TestCheck::result();
+}
@@ -0,0 +1,126 @@
+// Behaviour tests for MotionModel: constant rate and trapezoidal
+// profiles, dead travel, and correction from position reports
+
+#include <cmath>
+
+#include "MotionModel.hpp"
+#include "TestCheck.hpp"
+
+static const uint64_t g_s = 1000000000ULL;
+
+static bool near(double a, double b, double tolerance)
+{
+    return fabs(a - b) <= tolerance;
+}
+
+static void testConstantRate()
+{
+    MotionModel model;
+    model.setProfile(1000.0, 0.0);
+
+    CHECK(!model.moving());
+    CHECK(model.remaining(0) == 0.0);
+    CHECK(near(model.duration(5000), 5.0, 1e-9));
+
+    // Outward
+    model.start(10000, 15000, 10 * g_s);
+    CHECK(model.moving());
+    CHECK(model.target() == 15000);
+    CHECK(model.predict(10 * g_s) == 10000);
+    CHECK(model.predict(12 * g_s) == 12000);
+    CHECK(near(model.remaining(12 * g_s), 3.0, 1e-9));
+
+    // Overdue moves sit at the target rather than overshooting
+    CHECK(model.predict(30 * g_s) == 15000);
+    CHECK(model.remaining(30 * g_s) == 0.0);
+
+    model.stop(14321);
+    CHECK(!model.moving());
+    CHECK(model.predict(40 * g_s) == 14321);
+
+    // Inward
+    model.start(5000, 1000, 0);
+    CHECK(model.predict(g_s) == 4000);
+    CHECK(model.predict(g_s / 2) == 4500);
+}
+
+static void testTrapezoid()
+{
+    MotionModel model;
+    model.setProfile(1000.0, 2000.0);
+
+    // 0.5 s to reach 1000 steps/s over 250 steps each way, so
+    // 10000 steps is 0.5 + 9.5 + 0.5 s
+    CHECK(near(model.duration(10000), 10.5, 1e-9));
+
+    model.start(0, 10000, 0);
+    CHECK(model.predict(g_s / 2) == 250);
+    CHECK(model.predict(g_s) == 750);
+    CHECK(model.predict(10 * g_s) == 9750);
+    CHECK(near(model.remaining(10 * g_s), 0.5, 1e-9));
+
+    // Too short to reach the step rate: 400 steps accelerate for
+    // sqrt(2 * 200 / 2000) s and decelerate for as long
+    double half = sqrt(0.2);
+    CHECK(near(model.duration(400), 2.0 * half, 1e-9));
+    model.start(0, 400, 0);
+    CHECK(near(model.predict((uint64_t)(half * g_s)), 200, 1));
+
+    // Changing the profile mid-move replans it
+    model.start(0, 10000, 0);
+    model.setProfile(500.0, 0.0);
+    CHECK(near(model.remaining(0), 20.0, 1e-9));
+}
+
+static void testDeadTravel()
+{
+    MotionModel model;
+    model.setProfile(1000.0, 0.0);
+
+    CHECK(near(model.duration(1000, 500), 1.5, 1e-9));
+
+    // The position doesn't change while backlash is taken up
+    model.start(2000, 3000, 0, 500);
+    CHECK(model.predict(g_s / 4) == 2000);
+    CHECK(model.predict(g_s / 2) == 2000);
+    CHECK(model.predict(g_s) == 2500);
+    CHECK(model.predict(2 * g_s) == 3000);
+}
+
+static void testCorrection()
+{
+    const uint64_t t0 = 100 * g_s;
+    MotionModel model;
+    model.setProfile(1000.0, 0.0);
+    model.start(0, 10000, t0);
+
+    // A report at the starting position says nothing
+    model.correct(0, t0 + 3 * g_s);
+    CHECK(model.predict(t0 + 3 * g_s) == 3000);
+
+    // Running slow: the profile is shifted to pass through the report
+    model.correct(2000, t0 + 3 * g_s);
+    CHECK(model.predict(t0 + 3 * g_s) == 2000);
+    CHECK(model.predict(t0 + 4 * g_s) == 3000);
+    CHECK(near(model.remaining(t0 + 3 * g_s), 8.0, 1e-9));
+
+    // Running fast
+    model.correct(6000, t0 + 5 * g_s);
+    CHECK(model.predict(t0 + 5 * g_s) == 6000);
+    CHECK(near(model.remaining(t0 + 5 * g_s), 4.0, 1e-9));
+
+    // A report past the target doesn't push the prediction beyond it
+    model.correct(12000, t0 + 6 * g_s);
+    CHECK(model.predict(t0 + 6 * g_s) == 10000);
+    CHECK(model.remaining(t0 + 6 * g_s) == 0.0);
+}
+
+int main()
+{
+    testConstantRate();
+    testTrapezoid();
+    testDeadTravel();
+    testCorrection();
+
+    return TestCheck::result();
+}
@@ -0,0 +1,130 @@
+// Behaviour tests for MotionPlan: approach direction, overshoot
+// waypoints, clamping and step bookkeeping
+
+#include "MotionPlan.hpp"
+#include "TestCheck.hpp"
+
+static bool stepIs(const MotionPlan &plan, uint32_t position, MotionPlan::StepKind kind)
+{
+    return plan.active() &&
+           (plan.current().position == position) &&
+           (plan.current().kind == kind);
+}
+
+static void testOutwardApproach()
+{
+    MotionPlan plan;
+    plan.begin(1000, -1, 1, 200, 50000);
+
+    // Already below the target, so reached directly
+    CHECK(plan.approach(2000));
+    // Going back down needs an overshoot below the target
+    CHECK(plan.approach(1500));
+    // and continuing upwards doesn't
+    CHECK(plan.approach(1800));
+
+    CHECK(plan.stepCount() == 4);
+    CHECK(plan.pointCount() == 3);
+
+    CHECK(stepIs(plan, 2000, MotionPlan::SK_POINT));
+    plan.advance();
+    CHECK(stepIs(plan, 1300, MotionPlan::SK_WAYPOINT));
+    plan.advance();
+    CHECK(plan.pointsDone() == 1);
+    CHECK(stepIs(plan, 1500, MotionPlan::SK_POINT));
+    plan.advance();
+    CHECK(stepIs(plan, 1800, MotionPlan::SK_POINT));
+    plan.advance();
+    CHECK(!plan.active());
+    CHECK(plan.pointsDone() == 3);
+
+    // Advancing a finished plan does nothing
+    plan.advance();
+    CHECK(plan.pointsDone() == 3);
+}
+
+static void testInwardApproach()
+{
+    MotionPlan plan;
+    plan.begin(1000, 1, -1, 300, 5000);
+
+    CHECK(plan.approach(2000, MotionPlan::SK_POINT, 2));
+    CHECK(plan.approach(4900));
+    CHECK(plan.stepCount() == 4);
+
+    // The overshoot is clamped to the travel limit
+    CHECK(stepIs(plan, 2300, MotionPlan::SK_WAYPOINT));
+    CHECK(plan.current().profile == 2);
+    plan.advance();
+    CHECK(stepIs(plan, 2000, MotionPlan::SK_POINT));
+    plan.advance();
+    CHECK(stepIs(plan, 5000, MotionPlan::SK_WAYPOINT));
+    plan.advance();
+    CHECK(stepIs(plan, 4900, MotionPlan::SK_POINT));
+    CHECK(plan.current().profile == 0);
+}
+
+static void testEdges()
+{
+    MotionPlan plan;
+
+    // Targets past the end are clamped
+    plan.begin(100, 1, 1, 50, 1000);
+    CHECK(plan.approach(2000));
+    CHECK(stepIs(plan, 1000, MotionPlan::SK_POINT));
+
+    // Staying put keeps the last direction: the previous move went
+    // inward, so the point has to be approached again
+    plan.begin(500, -1, 1, 50, 1000);
+    CHECK(plan.approach(500));
+    CHECK(plan.stepCount() == 2);
+    CHECK(stepIs(plan, 450, MotionPlan::SK_WAYPOINT));
+
+    // An overshoot that would go below zero stops at zero, and none
+    // is needed at zero itself
+    plan.begin(500, 1, 1, 200, 1000);
+    CHECK(plan.approach(100));
+    CHECK(stepIs(plan, 0, MotionPlan::SK_WAYPOINT));
+    plan.begin(500, 1, 1, 200, 1000);
+    CHECK(plan.approach(0));
+    CHECK(plan.stepCount() == 1);
+
+    // No overshoot configured: every target is reached directly
+    plan.begin(500, 1, 1, 0, 1000);
+    CHECK(plan.approach(100));
+    CHECK(plan.stepCount() == 1);
+
+    // Full
+    plan.begin(0, 1, 1, 0, 1000000);
+    size_t added = 0;
+    while (plan.add(added + 1, MotionPlan::SK_POINT))
+    {
+        added++;
+    }
+    CHECK(added == MotionPlan::g_maxSteps);
+
+    // An approach that needs an overshoot adds both steps or neither
+    plan.begin(0, 1, 1, 10, 1000000);
+    for (size_t i = 0; i < MotionPlan::g_maxSteps - 1; i++)
+    {
+        CHECK(plan.add(1000 + i, MotionPlan::SK_POINT));
+    }
+    CHECK(!plan.approach(500));
+    CHECK(plan.stepCount() == MotionPlan::g_maxSteps - 1);
+    CHECK(plan.approach(5000));
+    CHECK(plan.stepCount() == MotionPlan::g_maxSteps);
+
+    plan.clear();
+    CHECK(!plan.active());
+    CHECK(plan.stepCount() == 0);
+    CHECK(plan.pointCount() == 0);
+}
+
+int main()
+{
+    testOutwardApproach();
+    testInwardApproach();
+    testEdges();
+
+    return TestCheck::result();
+}
@@ -0,0 +1,89 @@
+// Behaviour tests for MoveTiming: cruise rate from position reports
+// and the fallback for short moves
+
+#include <cmath>
+
+#include "MoveTiming.hpp"
+#include "TestCheck.hpp"
+
+static const uint64_t g_ms = 1000000ULL;
+
+static void testCruiseRate()
+{
+    MoveTiming timing;
+    CHECK(!timing.running());
+    CHECK(!timing.complete());
+
+    // 200 ms of latency and dead travel, then 2000 steps/s
+    timing.start(1000, 0);
+    CHECK(timing.running());
+    timing.sample(1000, 100 * g_ms);
+    timing.sample(1000, 200 * g_ms);
+    timing.sample(1100, 250 * g_ms);
+    timing.sample(1600, 500 * g_ms);
+    timing.sample(2100, 750 * g_ms);
+    timing.stop(2200, 850 * g_ms);
+
+    CHECK(!timing.running());
+    CHECK(timing.complete());
+    CHECK(timing.distance() == 1200);
+    CHECK(fabs(timing.duration() - 0.85) < 1e-9);
+    CHECK(fabs(timing.rate() - 2000.0) < 1e-6);
+
+    // Inward moves give the same rate
+    timing.start(5000, 0);
+    timing.sample(4900, 100 * g_ms);
+    timing.sample(4400, 600 * g_ms);
+    timing.stop(4300, 700 * g_ms);
+    CHECK(timing.distance() == 700);
+    CHECK(fabs(timing.rate() - 1000.0) < 1e-6);
+}
+
+static void testShortMove()
+{
+    MoveTiming timing;
+
+    // One report isn't enough for a slope
+    timing.start(0, 0);
+    timing.sample(50, 20 * g_ms);
+    timing.stop(100, 100 * g_ms);
+    CHECK(fabs(timing.rate() - 1000.0) < 1e-6);
+
+    // Nor is a repeated one
+    timing.start(0, 0);
+    timing.sample(50, 20 * g_ms);
+    timing.sample(50, 40 * g_ms);
+    timing.stop(200, 400 * g_ms);
+    CHECK(fabs(timing.rate() - 500.0) < 1e-6);
+
+    // A move that went nowhere
+    timing.start(300, 0);
+    timing.stop(300, 0);
+    CHECK(timing.rate() == 0.0);
+}
+
+static void testIdle()
+{
+    MoveTiming timing;
+
+    // Reports and stops outside a timed move are ignored
+    timing.sample(10, 0);
+    timing.stop(10, 0);
+    CHECK(!timing.complete());
+
+    timing.start(0, 0);
+    timing.stop(1000, g_ms * 1000);
+    timing.sample(5000, g_ms * 2000);
+    timing.stop(5000, g_ms * 2000);
+    CHECK(timing.distance() == 1000);
+    CHECK(fabs(timing.rate() - 1000.0) < 1e-6);
+}
+
+int main()
+{
+    testCruiseRate();
+    testShortMove();
+    testIdle();
+
+    return TestCheck::result();
+}
@@ -0,0 +1,109 @@
+// Behaviour tests for RequestTracker: reply correlation, telemetry
+// that must not produce round trip samples, and deadlines
+
+#include "RequestTracker.hpp"
+#include "TestCheck.hpp"
+
+static const uint64_t g_ms = 1000000ULL;
+
+static void testCorrelation()
+{
+    RequestTracker tracker;
+    RequestTracker::Command cmd = RequestTracker::CMD_COUNT;
+    uint64_t latencyUs = 0;
+
+    // A reply nobody asked for
+    CHECK(!tracker.completed(RequestTracker::RP_SPEED, 0));
+
+    // Set and get share a reply; the oldest is completed first
+    CHECK(tracker.issued(RequestTracker::CMD_SET_SPEED, 10 * g_ms));
+    CHECK(tracker.issued(RequestTracker::CMD_GET_SPEED, 20 * g_ms));
+    CHECK(tracker.issued(RequestTracker::CMD_FOCUS_ABS, 30 * g_ms));
+    CHECK(tracker.pending() == 3);
+
+    CHECK(tracker.completed(RequestTracker::RP_SPEED, 35 * g_ms, &cmd, &latencyUs));
+    CHECK(cmd == RequestTracker::CMD_SET_SPEED);
+    CHECK(latencyUs == 25000);
+    CHECK(tracker.completed(RequestTracker::RP_MOVING_ABS, 40 * g_ms, &cmd, &latencyUs));
+    CHECK(cmd == RequestTracker::CMD_FOCUS_ABS);
+    CHECK(latencyUs == 10000);
+    CHECK(tracker.pending(RequestTracker::CMD_GET_SPEED));
+    CHECK(!tracker.pending(RequestTracker::CMD_SET_SPEED));
+
+    CHECK(tracker.histogram(RequestTracker::CMD_SET_SPEED).count() == 1);
+    CHECK(tracker.histogram(RequestTracker::CMD_FOCUS_ABS).count() == 1);
+    CHECK(tracker.histogram(RequestTracker::CMD_GET_SPEED).count() == 0);
+
+    tracker.clear();
+    CHECK(tracker.pending() == 0);
+}
+
+static void testTelemetry()
+{
+    RequestTracker tracker;
+    RequestTracker::Command cmd = RequestTracker::CMD_COUNT;
+    uint64_t latencyUs = 12345;
+
+    // Position reports stream during a move whether or not anyone
+    // asked; they only count as a reply when something is waiting
+    CHECK(!tracker.completed(RequestTracker::RP_POSITION, 0));
+    CHECK(tracker.issued(RequestTracker::CMD_GET_POS, 0));
+    CHECK(tracker.completed(RequestTracker::RP_POSITION, 5 * g_ms, &cmd, &latencyUs));
+    CHECK(cmd == RequestTracker::CMD_GET_POS);
+    CHECK(latencyUs == 12345);
+    CHECK(tracker.histogram(RequestTracker::CMD_GET_POS).count() == 0);
+
+    // A move ending on its own says nothing about a move command
+    CHECK(tracker.issued(RequestTracker::CMD_FOCUS_REL, 0));
+    CHECK(!tracker.completed(RequestTracker::RP_STOPPED, 1 * g_ms));
+    CHECK(tracker.pending(RequestTracker::CMD_FOCUS_REL));
+
+    // but does satisfy an abort
+    CHECK(tracker.issued(RequestTracker::CMD_FOCUS_ABORT, 2 * g_ms));
+    CHECK(tracker.completed(RequestTracker::RP_STOPPED, 3 * g_ms, &cmd));
+    CHECK(cmd == RequestTracker::CMD_FOCUS_ABORT);
+    CHECK(tracker.histogram(RequestTracker::CMD_FOCUS_ABORT).count() == 0);
+
+    CHECK(RequestTracker::isTelemetry(RequestTracker::RP_POSITION));
+    CHECK(RequestTracker::isTelemetry(RequestTracker::RP_STOPPED));
+    CHECK(!RequestTracker::isTelemetry(RequestTracker::RP_MOVING_ABS));
+}
+
+static void testExpiry()
+{
+    RequestTracker tracker;
+    RequestTracker::Command expired[4];
+
+    CHECK(tracker.issued(RequestTracker::CMD_ZERO, 0, 100));
+    CHECK(tracker.issued(RequestTracker::CMD_GET_MAX_POS, 0, 500));
+    CHECK(tracker.issued(RequestTracker::CMD_ENABLE_MOTOR, 50 * g_ms, 100));
+
+    CHECK(tracker.expire(99 * g_ms, expired, 4) == 0);
+    CHECK(tracker.expire(150 * g_ms, expired, 4) == 2);
+    CHECK(expired[0] == RequestTracker::CMD_ZERO);
+    CHECK(expired[1] == RequestTracker::CMD_ENABLE_MOTOR);
+    CHECK(tracker.pending() == 1);
+
+    // Expired requests can't be completed late
+    CHECK(!tracker.completed(RequestTracker::RP_ZEROED, 200 * g_ms));
+    CHECK(tracker.completed(RequestTracker::RP_MAX_POS, 200 * g_ms));
+
+    // Bounded; extra commands are sent untracked
+    int tracked = 0;
+    while (tracker.issued(RequestTracker::CMD_GET_POS, 0))
+    {
+        tracked++;
+    }
+    CHECK(tracked == 32);
+    CHECK(tracker.expire(g_ms * 10000, expired, 4) == 4);
+    CHECK(tracker.pending() == 28);
+}
+
+int main()
+{
+    testCorrelation();
+    testTelemetry();
+    testExpiry();
+
+    return TestCheck::result();
+}
@@ -0,0 +1,211 @@
+// Behaviour tests for ResponseParser: patterns learned from the ELS
+// wire format agree with HostComms, and malformed numbers fall back
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "FocuserComms.hpp"
+#include "FocuserCommsListener.hpp"
+#include "HostComms.hpp"
+#include "HostCommsListener.hpp"
+#include "ResponseParser.hpp"
+#include "TestCheck.hpp"
+
+// Keeps the last line written, without its line ending
+class LineWriter : public ELS::CommsWriter
+{
+public:
+    virtual bool writeLine(const char *text) override
+    {
+        line = text;
+        while (!line.empty() && ((line.back() == '\r') || (line.back() == '\n')))
+        {
+            line.pop_back();
+        }
+        return true;
+    }
+
+    virtual void close() override {}
+
+    std::string line;
+};
+
+class NullFocuserListener : public ELS::FocuserCommsListener
+{
+public:
+    virtual void focusRel(ELS::FocusDirection, uint32_t) override {}
+    virtual void focusAbs(uint32_t) override {}
+    virtual void focusAbort() override {}
+    virtual void enableMotor(bool) override {}
+    virtual void zero() override {}
+    virtual void setMicrostep(ELS::Microsteps) override {}
+    virtual void setSpeed(ELS::FocusSpeed) override {}
+    virtual void enableBacklash(bool) override {}
+    virtual void setBacklashSteps(uint32_t) override {}
+    virtual void getMotorEnabled() override {}
+    virtual void getPos() override {}
+    virtual void getMaxPos() override {}
+    virtual void getMicrostep() override {}
+    virtual void getSpeed() override {}
+    virtual void getBacklashEnabled() override {}
+    virtual void getBacklashSteps() override {}
+};
+
+// Records the report delivered, as the parser's kind
+class Reports : public ELS::HostCommsListener
+{
+public:
+    Reports()
+    {
+        clear();
+    }
+
+    void clear()
+    {
+        calls = 0;
+        kind = ResponseParser::RK_COUNT;
+        value = 0;
+    }
+
+    virtual void movingRel(ELS::FocusDirection, uint32_t) override { calls++; }
+    virtual void movingAbs(uint32_t, uint32_t) override { calls++; }
+    virtual void stopped(uint32_t position) override { got(ResponseParser::RK_STOPPED, position); }
+    virtual void motorEnabled(bool) override { calls++; }
+    virtual void zeroed() override { calls++; }
+    virtual void position(uint32_t position) override { got(ResponseParser::RK_POSITION, position); }
+    virtual void microsteps(ELS::Microsteps) override { calls++; }
+    virtual void maxPos(uint32_t position) override { got(ResponseParser::RK_MAX_POS, position); }
+    virtual void speed(ELS::FocusSpeed) override { calls++; }
+    virtual void backlashEnabled(bool) override { calls++; }
+    virtual void backlashSteps(uint32_t steps) override { got(ResponseParser::RK_BACKLASH_STEPS, steps); }
+
+    int calls;
+    ResponseParser::Kind kind;
+    uint32_t value;
+
+private:
+    void got(ResponseParser::Kind k, uint32_t v)
+    {
+        calls++;
+        kind = k;
+        value = v;
+    }
+};
+
+static std::string render(ResponseParser::Kind kind, uint32_t value)
+{
+    LineWriter writer;
+    NullFocuserListener listener;
+    ELS::FocuserComms comms(&writer, &listener);
+
+    switch (kind)
+    {
+    case ResponseParser::RK_POSITION:
+        comms.position(value);
+        break;
+    case ResponseParser::RK_STOPPED:
+        comms.stopped(value);
+        break;
+    case ResponseParser::RK_MAX_POS:
+        comms.maxPos(value);
+        break;
+    default:
+        comms.backlashSteps(value);
+        break;
+    }
+
+    return writer.line;
+}
+
+static void testAgreesWithHostComms()
+{
+    ResponseParser parser;
+    CHECK(parser.learn() == ResponseParser::RK_COUNT);
+
+    LineWriter hostWriter;
+    Reports slow;
+    ELS::HostComms host(&hostWriter, &slow);
+    Reports fast;
+
+    const uint32_t values[] = {0u, 1u, 9u, 10u, 65535u, 1000000u, 4294967294u, 4294967295u};
+    for (int k = 0; k < ResponseParser::RK_COUNT; k++)
+    {
+        CHECK(parser.learned((ResponseParser::Kind)k));
+
+        for (uint32_t value : values)
+        {
+            std::string line = render((ResponseParser::Kind)k, value);
+
+            fast.clear();
+            CHECK(parser.dispatch(line.data(), line.size(), &fast));
+
+            std::vector<char> copy(line.begin(), line.end());
+            copy.push_back(0);
+            slow.clear();
+            host.processLine(copy.data());
+
+            CHECK(fast.calls == 1);
+            CHECK(slow.calls == 1);
+            CHECK(fast.kind == (ResponseParser::Kind)k);
+            CHECK(fast.kind == slow.kind);
+            CHECK(fast.value == value);
+            CHECK(fast.value == slow.value);
+        }
+    }
+}
+
+static void testRejects()
+{
+    ResponseParser parser;
+    CHECK(parser.learn() == ResponseParser::RK_COUNT);
+
+    ResponseParser::Kind kind;
+    uint32_t value = 0;
+    CHECK(!parser.match("", 0, &kind, &value));
+
+    std::string largest = render(ResponseParser::RK_POSITION, 4294967295u);
+    size_t at = largest.find("4294967295");
+    CHECK(at != std::string::npos);
+
+    // One past the largest value, an eleventh digit, a stray
+    // character and a missing number all go to HostComms
+    std::string line = largest;
+    line.replace(at, 10, "4294967296");
+    CHECK(!parser.match(line.data(), line.size(), &kind, &value));
+    line = largest;
+    line.replace(at, 10, "00000000001");
+    CHECK(!parser.match(line.data(), line.size(), &kind, &value));
+    line = largest;
+    line.replace(at, 10, "12x4");
+    CHECK(!parser.match(line.data(), line.size(), &kind, &value));
+    line = largest;
+    line.erase(at, 10);
+    CHECK(!parser.match(line.data(), line.size(), &kind, &value));
+
+    // Leading zeros within ten digits are still a number
+    line = largest;
+    line.replace(at, 10, "0000000042");
+    CHECK(parser.match(line.data(), line.size(), &kind, &value));
+    CHECK(kind == ResponseParser::RK_POSITION);
+    CHECK(value == 42);
+
+    // Only len bytes are looked at, whatever follows them
+    std::string position = render(ResponseParser::RK_POSITION, 1234);
+    std::string buffer = position + "999";
+    CHECK(parser.match(buffer.data(), position.size(), &kind, &value));
+    CHECK(value == 1234);
+
+    // Nothing matches before anything is learned
+    ResponseParser fresh;
+    CHECK(!fresh.learned(ResponseParser::RK_POSITION));
+    CHECK(!fresh.match(position.data(), position.size(), &kind, &value));
+}
+
+int main()
+{
+    testAgreesWithHostComms();
+    testRejects();
+
+    return TestCheck::result();
+}
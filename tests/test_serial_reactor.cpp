@@ -0,0 +1,350 @@
+// Behaviour tests for SerialReactor: registration, interest changes,
+// the handler limit and the reactor thread failing under its handlers
+
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <mutex>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "SerialReactor.hpp"
+#include "TestCheck.hpp"
+
+// Socket pair standing in for a serial port; the reactor watches
+// fds[0] and the test plays the controller on fds[1]
+class Port
+{
+public:
+    Port()
+    {
+        CHECK(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds) == 0);
+    }
+
+    ~Port()
+    {
+        close(fds[0]);
+        close(fds[1]);
+    }
+
+    int fds[2];
+};
+
+// Counts callbacks; reads whatever arrives so level-triggered input
+// doesn't repeat
+class Recorder : public SerialReactor::Handler
+{
+public:
+    Recorder()
+        : reactor(nullptr),
+          id(0),
+          keep(true),
+          dropOut(false),
+          reads(0),
+          writable(0),
+          failures(0),
+          error(0)
+    {
+    }
+
+    virtual bool ready(int fd, uint32_t events) override
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (events & EPOLLIN)
+        {
+            char buffer[256];
+            ssize_t len;
+            while ((len = read(fd, buffer, sizeof(buffer))) > 0)
+            {
+                data.append(buffer, len);
+            }
+            reads++;
+        }
+        if (events & EPOLLOUT)
+        {
+            writable++;
+
+            // Changing interest from inside the callback
+            if (dropOut)
+            {
+                reactor->modify(id, fd, EPOLLIN);
+            }
+        }
+        cond.notify_all();
+
+        return keep;
+    }
+
+    virtual void failed(int err) override
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        failures++;
+        error = err;
+        cond.notify_all();
+    }
+
+    // Waits for the callback counts to reach a total
+    bool waitFor(int *count, int target, int timeoutMs = 1000)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        return cond.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+                             [count, target]() { return *count >= target; });
+    }
+
+    int get(int *count)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return *count;
+    }
+
+    SerialReactor *reactor;
+    uint32_t id;
+    bool keep;
+    bool dropOut;
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::string data;
+    int reads;
+    int writable;
+    int failures;
+    int error;
+};
+
+static void settle()
+{
+    usleep(50000);
+}
+
+static void testAddRemove()
+{
+    SerialReactor reactor;
+    Port port;
+    Recorder handler;
+
+    CHECK(reactor.handlers() == 0);
+    uint32_t id = reactor.add(&handler, &port.fds[0], 1);
+    CHECK(id != 0);
+    CHECK(reactor.handlers() == 1);
+
+    CHECK(write(port.fds[1], "P 1\r\n", 5) == 5);
+    CHECK(handler.waitFor(&handler.reads, 1));
+    {
+        std::lock_guard<std::mutex> lock(handler.mutex);
+        CHECK(handler.data == "P 1\r\n");
+    }
+
+    // Nothing is delivered once remove() returns
+    reactor.remove(id);
+    CHECK(reactor.handlers() == 0);
+    CHECK(write(port.fds[1], "P 2\r\n", 5) == 5);
+    settle();
+    CHECK(handler.get(&handler.reads) == 1);
+
+    // Ids aren't reused, and removing an unknown one is harmless
+    uint32_t next = reactor.add(&handler, &port.fds[0], 1);
+    CHECK((next != 0) && (next != id));
+    CHECK(handler.waitFor(&handler.reads, 2));
+    reactor.remove(id);
+    reactor.remove(0);
+    CHECK(reactor.handlers() == 1);
+    reactor.remove(next);
+
+    // Too many fds, or one that can't be watched
+    int three[3] = {port.fds[0], port.fds[0], port.fds[0]};
+    CHECK(reactor.add(&handler, three, 3) == 0);
+    int bad = -1;
+    CHECK(reactor.add(&handler, &bad, 1) == 0);
+    CHECK(reactor.handlers() == 0);
+}
+
+static void testModify()
+{
+    SerialReactor reactor;
+    Port port;
+    Recorder handler;
+
+    handler.reactor = &reactor;
+    handler.id = reactor.add(&handler, &port.fds[0], 1);
+    CHECK(handler.id != 0);
+
+    // A socket with room is writable straight away; the callback
+    // drops EPOLLOUT again, so it is reported just once
+    {
+        std::lock_guard<std::mutex> lock(handler.mutex);
+        handler.dropOut = true;
+    }
+    CHECK(reactor.modify(handler.id, port.fds[0], EPOLLIN | EPOLLOUT));
+    CHECK(handler.waitFor(&handler.writable, 1));
+    settle();
+    CHECK(handler.get(&handler.writable) == 1);
+
+    // Input is still watched
+    CHECK(write(port.fds[1], "S 0\r\n", 5) == 5);
+    CHECK(handler.waitFor(&handler.reads, 1));
+
+    // Unregistered fds can't be changed
+    Port other;
+    CHECK(!reactor.modify(handler.id, other.fds[0], EPOLLIN));
+
+    reactor.remove(handler.id);
+}
+
+static void testStopWatching()
+{
+    SerialReactor reactor;
+    Port port;
+    Recorder handler;
+
+    // Returning false stops the callbacks but keeps the registration
+    handler.keep = false;
+    uint32_t id = reactor.add(&handler, &port.fds[0], 1);
+    CHECK(write(port.fds[1], "P 1\r\n", 5) == 5);
+    CHECK(handler.waitFor(&handler.reads, 1));
+    CHECK(write(port.fds[1], "P 2\r\n", 5) == 5);
+    settle();
+    CHECK(handler.get(&handler.reads) == 1);
+    CHECK(reactor.handlers() == 1);
+
+    reactor.remove(id);
+    CHECK(reactor.handlers() == 0);
+}
+
+static void testLimit()
+{
+    SerialReactor reactor;
+    Port ports[SerialReactor::g_maxHandlers + 1];
+    Recorder handlers[SerialReactor::g_maxHandlers + 1];
+    uint32_t ids[SerialReactor::g_maxHandlers + 1];
+
+    for (size_t i = 0; i < SerialReactor::g_maxHandlers; i++)
+    {
+        ids[i] = reactor.add(&handlers[i], &ports[i].fds[0], 1);
+        CHECK(ids[i] != 0);
+    }
+    CHECK(reactor.handlers() == SerialReactor::g_maxHandlers);
+
+    size_t last = SerialReactor::g_maxHandlers;
+    CHECK(reactor.add(&handlers[last], &ports[last].fds[0], 1) == 0);
+
+    // A freed slot can be taken again, and every handler still gets
+    // its own input
+    reactor.remove(ids[3]);
+    ids[3] = reactor.add(&handlers[last], &ports[last].fds[0], 1);
+    CHECK(ids[3] != 0);
+    for (size_t i = 0; i <= last; i++)
+    {
+        if (i != 3)
+        {
+            CHECK(write(ports[i].fds[1], "x", 1) == 1);
+        }
+    }
+    for (size_t i = 0; i <= last; i++)
+    {
+        if (i != 3)
+        {
+            CHECK(handlers[i].waitFor(&handlers[i].reads, 1));
+        }
+    }
+    CHECK(handlers[3].get(&handlers[3].reads) == 0);
+
+    for (size_t i = 0; i < SerialReactor::g_maxHandlers; i++)
+    {
+        reactor.remove(ids[i]);
+    }
+    CHECK(reactor.handlers() == 0);
+}
+
+// The reactor's epoll fd is the only one of its kind in the process
+static int findEpollFd()
+{
+    int found = -1;
+    DIR *dir = opendir("/proc/self/fd");
+    if (dir == nullptr)
+    {
+        return -1;
+    }
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != nullptr)
+    {
+        std::string path = std::string("/proc/self/fd/") + entry->d_name;
+        char target[64];
+        ssize_t len = readlink(path.c_str(), target, sizeof(target) - 1);
+        if (len > 0)
+        {
+            target[len] = 0;
+            if (strcmp(target, "anon_inode:[eventpoll]") == 0)
+            {
+                found = atoi(entry->d_name);
+            }
+        }
+    }
+    closedir(dir);
+
+    return found;
+}
+
+static void testFailure()
+{
+    SerialReactor reactor;
+    Port port;
+    Recorder handler;
+
+    uint32_t id = reactor.add(&handler, &port.fds[0], 1);
+    CHECK(id != 0);
+
+    // Swap something that isn't an epoll instance in under the
+    // thread; its next wait fails, whether or not this input was
+    // handled first
+    int epfd = findEpollFd();
+    CHECK(epfd >= 0);
+    int null = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    CHECK(null >= 0);
+    CHECK(dup2(null, epfd) == epfd);
+    close(null);
+
+    CHECK(write(port.fds[1], "P 1\r\n", 5) == 5);
+    CHECK(handler.waitFor(&handler.failures, 1));
+    CHECK(handler.get(&handler.error) == EINVAL);
+
+    // Still registered but no longer watched
+    int reads = handler.get(&handler.reads);
+    CHECK(reactor.handlers() == 1);
+    CHECK(write(port.fds[1], "P 2\r\n", 5) == 5);
+    settle();
+    CHECK(handler.get(&handler.reads) == reads);
+    reactor.remove(id);
+
+    // The next add() starts a fresh thread, which picks up whatever
+    // was left unread
+    Recorder again;
+    id = reactor.add(&again, &port.fds[0], 1);
+    CHECK(id != 0);
+    CHECK(again.waitFor(&again.reads, 1));
+    {
+        std::lock_guard<std::mutex> lock(handler.mutex);
+        std::lock_guard<std::mutex> lockAgain(again.mutex);
+        CHECK(handler.data + again.data == "P 1\r\nP 2\r\n");
+    }
+    CHECK(handler.get(&handler.failures) == 1);
+    reactor.remove(id);
+}
+
+int main()
+{
+    testAddRemove();
+    testModify();
+    testStopWatching();
+    testLimit();
+    testFailure();
+
+    return TestCheck::result();
+}
@@ -0,0 +1,109 @@
+// Behaviour tests for TempModel: per-filter centring, the spread
+// needed for a fit, and integrating piecewise coefficients
+
+#include <cmath>
+
+#include "TempModel.hpp"
+#include "TestCheck.hpp"
+
+static bool near(double a, double b, double tolerance)
+{
+    return fabs(a - b) <= tolerance;
+}
+
+static void testLinear()
+{
+    TempModel model;
+    CHECK(!model.valid());
+    CHECK(model.offset(0, 10) == 0);
+
+    // Two filters focusing 3000 steps apart, drifting by -12 steps/C;
+    // the filter offset mustn't show up in the slope
+    TempModel::Sample samples[] = {
+        {1, 0.0, 10000, 1},
+        {1, 4.0, 9952, 1},
+        {1, 8.0, 9904, 1},
+        {2, 2.0, 12976, 2},
+        {2, 6.0, 12928, 2},
+    };
+    CHECK(model.fit(samples, 5, TempModel::TM_LINEAR, 0));
+    CHECK(model.valid());
+    CHECK(near(model.coefficient(), -12.0, 1e-9));
+    CHECK(model.segments() == 0);
+    CHECK(near(model.offset(5.0, 7.5), -30.0, 1e-9));
+    CHECK(near(model.offset(7.5, 5.0), 30.0, 1e-9));
+    CHECK(model.offset(5.0, NAN) == 0);
+
+    // Samples with no weight don't count
+    samples[1].position = 0;
+    samples[1].weight = 0;
+    CHECK(model.fit(samples, 5, TempModel::TM_LINEAR, 0));
+    CHECK(near(model.coefficient(), -12.0, 1e-9));
+}
+
+static void testSpread()
+{
+    TempModel model;
+
+    // Each filter on its own has too narrow a range, however far
+    // apart the filters are from each other
+    TempModel::Sample samples[] = {
+        {1, 0.0, 10000, 1},
+        {1, 0.5, 9990, 1},
+        {2, 10.0, 9000, 1},
+        {2, 10.5, 8990, 1},
+    };
+    CHECK(!model.fit(samples, 4, TempModel::TM_LINEAR, 0));
+    CHECK(!model.valid());
+    CHECK(model.coefficient() == 0);
+
+    // A fixed coefficient needs no samples
+    model.setCoefficient(-5.0);
+    CHECK(model.valid());
+    CHECK(near(model.offset(0, 2), -10.0, 1e-9));
+}
+
+static void testPiecewise()
+{
+    TempModel model;
+
+    // -10 steps/C between 0 and 3 C, -30 between 10 and 13, nothing
+    // in between
+    TempModel::Sample samples[8];
+    for (int i = 0; i < 4; i++)
+    {
+        samples[i] = {1, (double)i, 5000.0 - 10 * i, 1};
+        samples[4 + i] = {1, 10.0 + i, 4000.0 - 30 * i, 1};
+    }
+    CHECK(model.fit(samples, 8, TempModel::TM_PIECEWISE, 5.0));
+    CHECK(model.segments() == 2);
+    double overall = model.coefficient();
+    CHECK(overall < 0);
+
+    CHECK(near(model.offset(1, 2), -10.0, 1e-9));
+    CHECK(near(model.offset(11, 12), -30.0, 1e-9));
+
+    // Across the gap the overall coefficient fills in
+    double across = -10.0 * 3 + overall * 5 - 30.0 * 2;
+    CHECK(near(model.offset(2, 12), across, 1e-6));
+    CHECK(near(model.offset(12, 2), -across, 1e-6));
+
+    // and beyond the fitted range on either side
+    CHECK(near(model.offset(20, 21), overall, 1e-9));
+    CHECK(near(model.offset(-3, -1), overall * 2, 1e-9));
+    CHECK(near(model.offset(-1, 1), overall - 10.0, 1e-9));
+
+    // Linear mode ignores the segments
+    CHECK(model.fit(samples, 8, TempModel::TM_LINEAR, 5.0));
+    CHECK(model.segments() == 0);
+    CHECK(near(model.offset(1, 2), overall, 1e-9));
+}
+
+int main()
+{
+    testLinear();
+    testSpread();
+    testPiecewise();
+
+    return TestCheck::result();
+}
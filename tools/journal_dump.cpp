@@ -0,0 +1,103 @@
+// Dumps a motion journal written by the driver as CSV.
+//
+// One row per record, oldest first:
+//
+//   index,time,unix_ns,event,position,target,steps,value
+//
+// time is UTC. position and target are controller steps; steps is
+// signed (negative inward) for relative moves; value holds the
+// setting for microsteps and backlash events, and the driver's
+// position offset for offset events (driver position = offset +
+// steps * 64 / microsteps). Columns that don't apply to an event are
+// left empty. Records overwritten while the journal was being read
+// are skipped and counted on stderr.
+//
+// usage: rks_c8_journal journal-file [> out.csv]
+
+#include <cinttypes>
+#include <cstdio>
+#include <ctime>
+
+#include "MotionJournal.hpp"
+
+static void printRow(uint64_t index, const MotionJournal::Record &rec)
+{
+    time_t secs = (time_t)(rec.timeNs / 1000000000ULL);
+    struct tm tm;
+    gmtime_r(&secs, &tm);
+
+    char when[32];
+    strftime(when, sizeof(when), "%Y-%m-%dT%H:%M:%S", &tm);
+
+    printf("%" PRIu64 ",%s.%06uZ,%" PRIu64 ",%s,",
+           index,
+           when,
+           (unsigned)((rec.timeNs % 1000000000ULL) / 1000),
+           rec.timeNs,
+           MotionJournal::eventName(rec.type));
+
+    switch (rec.type)
+    {
+    case MotionJournal::JE_MOVING_REL:
+        printf(",,%s%u,\n", (rec.a == 0) ? "-" : "", rec.b);
+        break;
+    case MotionJournal::JE_MOVING_ABS:
+        printf("%u,%u,,\n", rec.a, rec.b);
+        break;
+    case MotionJournal::JE_STOPPED:
+    case MotionJournal::JE_POSITION:
+    case MotionJournal::JE_ZEROED:
+        printf("%u,,,\n", rec.a);
+        break;
+    case MotionJournal::JE_MICROSTEPS:
+    case MotionJournal::JE_BACKLASH_ENABLED:
+    case MotionJournal::JE_BACKLASH_STEPS:
+        printf(",,,%u\n", rec.a);
+        break;
+    case MotionJournal::JE_OFFSET:
+        printf(",,,%" PRId64 "\n", (int64_t)(((uint64_t)rec.b << 32) | rec.a));
+        break;
+    default:
+        printf(",,,\n");
+        break;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 2)
+    {
+        fprintf(stderr, "usage: %s journal-file\n", argv[0]);
+        return 2;
+    }
+
+    MotionJournal journal;
+    if (!journal.openReadOnly(argv[1]))
+    {
+        fprintf(stderr, "%s is not a motion journal\n", argv[1]);
+        return 1;
+    }
+
+    printf("index,time,unix_ns,event,position,target,steps,value\n");
+
+    uint64_t skipped = 0;
+    uint64_t end = journal.end();
+    for (uint64_t i = journal.first(); i < end; i++)
+    {
+        MotionJournal::Record rec;
+        if (!journal.read(i, &rec))
+        {
+            skipped++;
+            continue;
+        }
+
+        printRow(i, rec);
+    }
+
+    if (skipped > 0)
+    {
+        fprintf(stderr, "%" PRIu64 " records were overwritten while reading\n", skipped);
+    }
+
+    return 0;
+}
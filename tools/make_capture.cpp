@@ -0,0 +1,451 @@
+// Builds a serial traffic capture from a readable script, for replay
+// tests that need traffic no controller has recorded.
+//
+// Each line of the script is one chunk:
+//
+//   +<seconds> tx|rx <message> [argument ...]
+//
+// tx messages are driver commands, rendered by HostComms, and rx
+// messages are controller reports, rendered by FocuserComms, so the
+// capture always holds the wire format of the comms library it was
+// built with. A message of "text" sends the rest of the line as it
+// is (the framing requests, say). Directions are in or out,
+// microsteps 8, 16, 32 or 64, speeds normal or x3 and flags 0 or 1.
+// Times may not go backwards. Blank lines and # comments are skipped.
+//
+// usage: rks_c8_make_capture script-file capture-file
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "FocuserComms.hpp"
+#include "FocuserCommsListener.hpp"
+#include "HostComms.hpp"
+#include "HostCommsListener.hpp"
+#include "TrafficCapture.hpp"
+
+// Keeps the last line rendered
+class LineWriter : public ELS::CommsWriter
+{
+public:
+    virtual bool writeLine(const char *text) override
+    {
+        line = text;
+        return true;
+    }
+
+    virtual void close() override {}
+
+    std::string line;
+};
+
+// Neither side ever sees any input here
+class NullHostListener : public ELS::HostCommsListener
+{
+public:
+    virtual void movingRel(ELS::FocusDirection, uint32_t) override {}
+    virtual void movingAbs(uint32_t, uint32_t) override {}
+    virtual void stopped(uint32_t) override {}
+    virtual void motorEnabled(bool) override {}
+    virtual void zeroed() override {}
+    virtual void position(uint32_t) override {}
+    virtual void microsteps(ELS::Microsteps) override {}
+    virtual void maxPos(uint32_t) override {}
+    virtual void speed(ELS::FocusSpeed) override {}
+    virtual void backlashEnabled(bool) override {}
+    virtual void backlashSteps(uint32_t) override {}
+};
+
+class NullFocuserListener : public ELS::FocuserCommsListener
+{
+public:
+    virtual void focusRel(ELS::FocusDirection, uint32_t) override {}
+    virtual void focusAbs(uint32_t) override {}
+    virtual void focusAbort() override {}
+    virtual void enableMotor(bool) override {}
+    virtual void zero() override {}
+    virtual void setMicrostep(ELS::Microsteps) override {}
+    virtual void setSpeed(ELS::FocusSpeed) override {}
+    virtual void enableBacklash(bool) override {}
+    virtual void setBacklashSteps(uint32_t) override {}
+    virtual void getMotorEnabled() override {}
+    virtual void getPos() override {}
+    virtual void getMaxPos() override {}
+    virtual void getMicrostep() override {}
+    virtual void getSpeed() override {}
+    virtual void getBacklashEnabled() override {}
+    virtual void getBacklashSteps() override {}
+};
+
+// The words of a script line after the time and direction
+class Args
+{
+public:
+    Args(const std::vector<std::string> &words)
+        : _words(words),
+          _ok(true)
+    {
+    }
+
+    bool ok() const { return _ok && (_words.size() >= 3); }
+    size_t count() const { return _words.size() - 3; }
+
+    uint32_t number(size_t i)
+    {
+        const char *word = arg(i);
+        char *end = nullptr;
+        unsigned long value = strtoul(word, &end, 10);
+        if ((*word < '0') || (*word > '9') || (*end != 0) || (value > 0xffffffffUL))
+        {
+            _ok = false;
+            return 0;
+        }
+
+        return (uint32_t)value;
+    }
+
+    bool flag(size_t i)
+    {
+        uint32_t value = number(i);
+        _ok = _ok && (value <= 1);
+
+        return value == 1;
+    }
+
+    ELS::FocusDirection direction(size_t i)
+    {
+        const char *word = arg(i);
+        _ok = _ok && ((strcmp(word, "in") == 0) || (strcmp(word, "out") == 0));
+
+        return (strcmp(word, "in") == 0) ? ELS::FD_FOCUS_INWARD : ELS::FD_FOCUS_OUTWARD;
+    }
+
+    ELS::Microsteps microsteps(size_t i)
+    {
+        switch (number(i))
+        {
+        case 8:
+            return ELS::MS_X8;
+        case 16:
+            return ELS::MS_X16;
+        case 32:
+            return ELS::MS_X32;
+        case 64:
+            return ELS::MS_X64;
+        }
+
+        _ok = false;
+        return ELS::MS_X64;
+    }
+
+    ELS::FocusSpeed speed(size_t i)
+    {
+        const char *word = arg(i);
+        _ok = _ok && ((strcmp(word, "normal") == 0) || (strcmp(word, "x3") == 0));
+
+        return (strcmp(word, "x3") == 0) ? ELS::FS_X3 : ELS::FS_NORMAL;
+    }
+
+private:
+    const char *arg(size_t i)
+    {
+        if (3 + i >= _words.size())
+        {
+            _ok = false;
+            return "";
+        }
+
+        return _words[3 + i].c_str();
+    }
+
+private:
+    const std::vector<std::string> &_words;
+    bool _ok;
+};
+
+static std::vector<std::string> splitWords(const char *line)
+{
+    std::vector<std::string> words;
+    const char *p = line;
+    while (*p != 0)
+    {
+        while ((*p == ' ') || (*p == '\t') || (*p == '\r') || (*p == '\n'))
+        {
+            p++;
+        }
+
+        const char *start = p;
+        while ((*p != 0) && (*p != ' ') && (*p != '\t') && (*p != '\r') && (*p != '\n'))
+        {
+            p++;
+        }
+        if (p != start)
+        {
+            words.push_back(std::string(start, p - start));
+        }
+    }
+
+    return words;
+}
+
+// The rest of the line once n words and the space after them are
+// skipped
+static const char *afterWords(const char *line, int n)
+{
+    const char *p = line + strspn(line, " \t");
+    for (int i = 0; i < n; i++)
+    {
+        p += strcspn(p, " \t\r\n");
+        p += strspn(p, " \t");
+    }
+
+    return p;
+}
+
+static bool renderCommand(ELS::HostComms *comms, const std::string &name, Args *args)
+{
+    size_t expected = 0;
+
+    if (name == "focusRel")
+    {
+        comms->focusRel(args->direction(0), args->number(1));
+        expected = 2;
+    }
+    else if (name == "focusAbs")
+    {
+        comms->focusAbs(args->number(0));
+        expected = 1;
+    }
+    else if (name == "focusAbort")
+    {
+        comms->focusAbort();
+    }
+    else if (name == "enableMotor")
+    {
+        comms->enableMotor(args->flag(0));
+        expected = 1;
+    }
+    else if (name == "zero")
+    {
+        comms->zero();
+    }
+    else if (name == "setMicrostep")
+    {
+        comms->setMicrostep(args->microsteps(0));
+        expected = 1;
+    }
+    else if (name == "setSpeed")
+    {
+        comms->setSpeed(args->speed(0));
+        expected = 1;
+    }
+    else if (name == "enableBacklash")
+    {
+        comms->enableBacklash(args->flag(0));
+        expected = 1;
+    }
+    else if (name == "setBacklashSteps")
+    {
+        comms->setBacklashSteps(args->number(0));
+        expected = 1;
+    }
+    else if (name == "getMotorEnabled")
+    {
+        comms->getMotorEnabled();
+    }
+    else if (name == "getPos")
+    {
+        comms->getPos();
+    }
+    else if (name == "getMaxPos")
+    {
+        comms->getMaxPos();
+    }
+    else if (name == "getMicrostep")
+    {
+        comms->getMicrostep();
+    }
+    else if (name == "getSpeed")
+    {
+        comms->getSpeed();
+    }
+    else if (name == "getBacklashEnabled")
+    {
+        comms->getBacklashEnabled();
+    }
+    else if (name == "getBacklashSteps")
+    {
+        comms->getBacklashSteps();
+    }
+    else
+    {
+        return false;
+    }
+
+    return args->ok() && (args->count() == expected);
+}
+
+static bool renderReport(ELS::FocuserComms *comms, const std::string &name, Args *args)
+{
+    size_t expected = 1;
+
+    if (name == "movingRel")
+    {
+        comms->movingRel(args->direction(0), args->number(1));
+        expected = 2;
+    }
+    else if (name == "movingAbs")
+    {
+        comms->movingAbs(args->number(0), args->number(1));
+        expected = 2;
+    }
+    else if (name == "stopped")
+    {
+        comms->stopped(args->number(0));
+    }
+    else if (name == "motorEnabled")
+    {
+        comms->motorEnabled(args->flag(0));
+    }
+    else if (name == "zeroed")
+    {
+        comms->zeroed();
+        expected = 0;
+    }
+    else if (name == "position")
+    {
+        comms->position(args->number(0));
+    }
+    else if (name == "microsteps")
+    {
+        comms->microsteps(args->microsteps(0));
+    }
+    else if (name == "maxPos")
+    {
+        comms->maxPos(args->number(0));
+    }
+    else if (name == "speed")
+    {
+        comms->speed(args->speed(0));
+    }
+    else if (name == "backlashEnabled")
+    {
+        comms->backlashEnabled(args->flag(0));
+    }
+    else if (name == "backlashSteps")
+    {
+        comms->backlashSteps(args->number(0));
+    }
+    else
+    {
+        return false;
+    }
+
+    return args->ok() && (args->count() == expected);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 3)
+    {
+        fprintf(stderr, "usage: %s script-file capture-file\n", argv[0]);
+        return 2;
+    }
+
+    FILE *fp = fopen(argv[1], "r");
+    if (fp == nullptr)
+    {
+        fprintf(stderr, "unable to read %s\n", argv[1]);
+        return 1;
+    }
+
+    TrafficCapture capture;
+    if (!capture.open(argv[2]))
+    {
+        fprintf(stderr, "unable to write %s\n", argv[2]);
+        fclose(fp);
+        return 1;
+    }
+
+    LineWriter writer;
+    NullHostListener hostListener;
+    NullFocuserListener focuserListener;
+    ELS::HostComms host(&writer, &hostListener);
+    ELS::FocuserComms focuser(&writer, &focuserListener);
+
+    int errors = 0;
+    uint64_t lastNs = 0;
+    char line[1024];
+    int lineNo = 0;
+    while (fgets(line, sizeof(line), fp) != nullptr)
+    {
+        lineNo++;
+
+        std::vector<std::string> words = splitWords(line);
+        if (words.empty() || (words[0][0] == '#'))
+        {
+            continue;
+        }
+
+        char *end = nullptr;
+        double secs = (words[0][0] == '+') ? strtod(words[0].c_str() + 1, &end) : -1;
+        bool tx = (words.size() > 1) && (words[1] == "tx");
+        bool rx = (words.size() > 1) && (words[1] == "rx");
+        if ((secs < 0) || (*end != 0) || (!tx && !rx) || (words.size() < 3))
+        {
+            fprintf(stderr, "%s:%d: expected +<seconds> tx|rx <message> [argument ...]\n",
+                    argv[1], lineNo);
+            errors++;
+            continue;
+        }
+
+        uint64_t timeNs = (uint64_t)(secs * 1e9 + 0.5);
+        if (timeNs < lastNs)
+        {
+            fprintf(stderr, "%s:%d: time goes backwards\n", argv[1], lineNo);
+            errors++;
+            continue;
+        }
+        lastNs = timeNs;
+
+        bool rendered = false;
+        if (words[2] == "text")
+        {
+            writer.line = afterWords(line, 3);
+            writer.line.erase(writer.line.find_last_not_of(" \t\r\n") + 1);
+            rendered = !writer.line.empty();
+        }
+        else
+        {
+            Args args(words);
+            writer.line.clear();
+            rendered = tx ? renderCommand(&host, words[2], &args)
+                          : renderReport(&focuser, words[2], &args);
+        }
+
+        if (!rendered)
+        {
+            fprintf(stderr, "%s:%d: can't render %s", argv[1], lineNo, line);
+            errors++;
+            continue;
+        }
+
+        // On the wire every line ends in CR LF, whichever side sent it
+        std::string chunk = writer.line + "\r\n";
+        capture.record(timeNs, tx ? TrafficCapture::TD_TX : TrafficCapture::TD_RX,
+                       chunk.data(), chunk.size());
+    }
+    fclose(fp);
+    capture.close();
+
+    if (errors != 0)
+    {
+        remove(argv[2]);
+        return 1;
+    }
+
+    return 0;
+}
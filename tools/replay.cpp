@@ -0,0 +1,888 @@
+// Replays a serial traffic capture through the real driver.
+//
+// Starts the driver as a child process speaking INDI on its stdin and
+// stdout, just as indiserver would, and points its serial port at a
+// pty. The RX chunks from the capture are written to the pty at their
+// original pace divided by the speed factor (0 = as fast as
+// possible). Before each RX chunk the harness waits until the driver
+// has sent every command line captured ahead of it, matched by text
+// and in order, so replies never overtake the commands that caused
+// them. Lines the capture doesn't have, such as a heartbeat query,
+// are counted and otherwise ignored. The driver's heartbeat is off
+// unless -b sets a period, since its queries depend on the wall clock
+// rather than on the traffic. If the driver goes -w seconds without
+// sending the command the replay is waiting for, the replay stops
+// there and fails.
+//
+// A capture only holds serial traffic, so what a client asked of the
+// driver comes from a separate file given with -c. Each line is
+//
+//   +<seconds> <INDI message>
+//
+// on the capture's clock; the message goes to the driver after every
+// chunk captured before that time, and waits at the gate like an RX
+// chunk does.
+//
+// Every setXXXVector the driver sends for the device becomes one line
+// of the property timeline:
+//
+//   +<seconds> PROPERTY State element=value ...
+//
+// With -e the timeline is checked against a file of expected lines in
+// the same form (the leading time is optional and ignored, a State of
+// * matches any state, and only the elements listed are compared,
+// numerically where both sides are numbers). The expected lines must
+// appear in order, though other updates may come in between. The exit
+// status is 0 when the driver sent every captured command and the
+// expected lines all appear, 1 when a command or a line is missing
+// and 2 when the replay couldn't run.
+//
+// The driver runs with HOME pointed at a scratch directory so the
+// user's saved configuration doesn't leak into the result.
+//
+// usage: rks_c8_replay [-d driver] [-n device] [-s speed] [-t settle-secs]
+//                      [-b heartbeat-secs] [-w stall-secs] [-c client-file]
+//                      [-e expected-file] [-o timeline-file] capture-file
+
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <ftw.h>
+#include <poll.h>
+#include <string>
+#include <sys/wait.h>
+#include <termios.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+#include "libindi/lilxml.h"
+#include "MonotonicClock.hpp"
+#include "TrafficCapture.hpp"
+
+struct Options
+{
+    const char *driver;
+    const char *device;
+    double speed;
+    double settleSecs;
+    double heartbeatSecs;
+    double stallSecs;
+    const char *client;
+    const char *expected;
+    const char *timeline;
+    const char *capture;
+};
+
+// One step of the replay, in capture time order
+struct Step
+{
+    enum Kind
+    {
+        SK_COMMAND,
+        SK_REPLY,
+        SK_CLIENT
+    };
+
+    uint64_t timeNs;
+    Kind kind;
+    std::string data;
+};
+
+// One property update from the driver
+struct Update
+{
+    uint64_t timeNs;
+    std::string property;
+    std::string state;
+    std::vector<std::pair<std::string, std::string>> values;
+};
+
+//
+// Driver process
+//
+
+class Driver
+{
+public:
+    Driver()
+        : _pid(-1),
+          _in(-1),
+          _out(-1),
+          _xml(newLilXML())
+    {
+    }
+
+    ~Driver()
+    {
+        stop();
+        delLilXML(_xml);
+    }
+
+    bool start(const char *path, const char *home)
+    {
+        int in[2];
+        int out[2];
+        if (pipe2(in, O_CLOEXEC) != 0)
+        {
+            return false;
+        }
+        if (pipe2(out, O_CLOEXEC) != 0)
+        {
+            ::close(in[0]);
+            ::close(in[1]);
+            return false;
+        }
+
+        _pid = fork();
+        if (_pid == 0)
+        {
+            dup2(in[0], STDIN_FILENO);
+            dup2(out[1], STDOUT_FILENO);
+            setenv("HOME", home, 1);
+            execlp(path, path, (char *)0);
+            fprintf(stderr, "unable to run %s: %s\n", path, strerror(errno));
+            _exit(127);
+        }
+
+        ::close(in[0]);
+        ::close(out[1]);
+        _in = in[1];
+        _out = out[0];
+
+        if (_pid == -1)
+        {
+            stop();
+            return false;
+        }
+
+        return true;
+    }
+
+    void send(const std::string &xml)
+    {
+        size_t off = 0;
+        while (off < xml.size())
+        {
+            ssize_t n = write(_in, xml.data() + off, xml.size() - off);
+            if (n <= 0)
+            {
+                return;
+            }
+            off += n;
+        }
+    }
+
+    // Parses whatever the driver has written; false once it has
+    // exited
+    bool readOutput(const char *device, uint64_t startNs, std::vector<Update> *timeline)
+    {
+        char buf[4096];
+        ssize_t n = read(_out, buf, sizeof(buf));
+        if (n <= 0)
+        {
+            return (n == -1) && (errno == EINTR);
+        }
+
+        for (ssize_t i = 0; i < n; i++)
+        {
+            char errmsg[2048];
+            XMLEle *root = readXMLEle(_xml, buf[i], errmsg);
+            if (root == nullptr)
+            {
+                continue;
+            }
+
+            const char *tag = tagXMLEle(root);
+            const char *dev = findXMLAttValu(root, "device");
+            if ((strncmp(tag, "set", 3) == 0) && (strcmp(dev, device) == 0))
+            {
+                Update update;
+                update.timeNs = monotonicNs() - startNs;
+                update.property = findXMLAttValu(root, "name");
+                update.state = findXMLAttValu(root, "state");
+
+                for (XMLEle *ep = nextXMLEle(root, 1); ep != nullptr; ep = nextXMLEle(root, 0))
+                {
+                    update.values.push_back(std::make_pair(std::string(findXMLAttValu(ep, "name")),
+                                                           trim(pcdataXMLEle(ep))));
+                }
+
+                timeline->push_back(update);
+            }
+
+            delXMLEle(root);
+        }
+
+        return true;
+    }
+
+    void stop()
+    {
+        if (_in != -1)
+        {
+            ::close(_in);
+            _in = -1;
+        }
+
+        if (_pid > 0)
+        {
+            kill(_pid, SIGTERM);
+            waitpid(_pid, nullptr, 0);
+            _pid = -1;
+        }
+
+        if (_out != -1)
+        {
+            ::close(_out);
+            _out = -1;
+        }
+    }
+
+    int outFd() const { return _out; }
+
+private:
+    static std::string trim(const char *text)
+    {
+        const char *end = text + strlen(text);
+        while ((text < end) && isspace((unsigned char)*text))
+        {
+            text++;
+        }
+        while ((end > text) && isspace((unsigned char)end[-1]))
+        {
+            end--;
+        }
+
+        return std::string(text, end - text);
+    }
+
+private:
+    pid_t _pid;
+    int _in;
+    int _out;
+    LilXML *_xml;
+};
+
+//
+// Timeline
+//
+
+static std::string formatUpdate(const Update &update)
+{
+    std::string out = update.property + " " + update.state;
+    for (size_t i = 0; i < update.values.size(); i++)
+    {
+        const std::string &value = update.values[i].second;
+        bool quote = value.empty() || (value.find_first_of(" \t\"") != std::string::npos);
+
+        out += " " + update.values[i].first + "=";
+        out += quote ? "\"" + value + "\"" : value;
+    }
+
+    return out;
+}
+
+// Splits an expected line into words, honouring double quotes
+static std::vector<std::string> splitWords(const char *line)
+{
+    std::vector<std::string> words;
+    std::string word;
+    bool inWord = false;
+    bool quoted = false;
+
+    for (const char *p = line; *p != 0; p++)
+    {
+        if (*p == '"')
+        {
+            quoted = !quoted;
+            inWord = true;
+        }
+        else if (!quoted && isspace((unsigned char)*p))
+        {
+            if (inWord)
+            {
+                words.push_back(word);
+                word.clear();
+                inWord = false;
+            }
+        }
+        else
+        {
+            word += *p;
+            inWord = true;
+        }
+    }
+    if (inWord)
+    {
+        words.push_back(word);
+    }
+
+    return words;
+}
+
+static bool sameValue(const std::string &expected, const std::string &actual)
+{
+    if (expected == actual)
+    {
+        return true;
+    }
+
+    char *endE = nullptr;
+    char *endA = nullptr;
+    double e = strtod(expected.c_str(), &endE);
+    double a = strtod(actual.c_str(), &endA);
+    if (expected.empty() || actual.empty() || (*endE != 0) || (*endA != 0))
+    {
+        return false;
+    }
+
+    return fabs(e - a) <= 1e-6 * ((fabs(e) > 1.0) ? fabs(e) : 1.0);
+}
+
+static bool matches(const std::vector<std::string> &words, const Update &update)
+{
+    if ((words[0] != update.property) || ((words[1] != "*") && (words[1] != update.state)))
+    {
+        return false;
+    }
+
+    for (size_t i = 2; i < words.size(); i++)
+    {
+        size_t eq = words[i].find('=');
+        std::string name = words[i].substr(0, eq);
+        std::string value = (eq == std::string::npos) ? "" : words[i].substr(eq + 1);
+
+        bool found = false;
+        for (size_t j = 0; (j < update.values.size()) && !found; j++)
+        {
+            found = (update.values[j].first == name) && sameValue(value, update.values[j].second);
+        }
+        if (!found)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Returns the number of expected lines that weren't seen in order,
+// reporting the first of them
+static int checkTimeline(const char *path, const std::vector<Update> &timeline)
+{
+    FILE *fp = fopen(path, "r");
+    if (fp == nullptr)
+    {
+        fprintf(stderr, "unable to read %s\n", path);
+        return -1;
+    }
+
+    int missing = 0;
+    size_t next = 0;
+    char line[4096];
+    int lineNo = 0;
+    while (fgets(line, sizeof(line), fp) != nullptr)
+    {
+        lineNo++;
+
+        std::vector<std::string> words = splitWords(line);
+        if (!words.empty() && (words[0][0] == '+'))
+        {
+            words.erase(words.begin());
+        }
+        if (words.empty() || (words[0][0] == '#'))
+        {
+            continue;
+        }
+        if (words.size() < 2)
+        {
+            fprintf(stderr, "%s:%d: expected PROPERTY State [element=value ...]\n", path, lineNo);
+            missing++;
+            continue;
+        }
+
+        size_t i = next;
+        while ((i < timeline.size()) && !matches(words, timeline[i]))
+        {
+            i++;
+        }
+
+        if (i == timeline.size())
+        {
+            if (missing == 0)
+            {
+                fprintf(stderr, "%s:%d: not seen after update %zu: %s", path, lineNo, next, line);
+            }
+            missing++;
+            continue;
+        }
+
+        next = i + 1;
+    }
+    fclose(fp);
+
+    return missing;
+}
+
+//
+// Replay
+//
+
+static int openPty(std::string *slavePath, int *slaveFd)
+{
+    int master = posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (master == -1)
+    {
+        return -1;
+    }
+
+    if ((grantpt(master) != 0) || (unlockpt(master) != 0) || (ptsname(master) == nullptr))
+    {
+        close(master);
+        return -1;
+    }
+    *slavePath = ptsname(master);
+
+    // Holding the slave open keeps the master readable while the
+    // driver closes and reopens the port
+    *slaveFd = open(slavePath->c_str(), O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (*slaveFd == -1)
+    {
+        close(master);
+        return -1;
+    }
+
+    struct termios tio;
+    if (tcgetattr(*slaveFd, &tio) == 0)
+    {
+        cfmakeraw(&tio);
+        tcsetattr(*slaveFd, TCSANOW, &tio);
+    }
+
+    return master;
+}
+
+static int removeEntry(const char *path, const struct stat *, int, struct FTW *)
+{
+    return remove(path);
+}
+
+// Moves the complete lines in data to lines, without their endings
+// and skipping empty ones, and leaves any partial line in data
+static void takeLines(std::string *data, std::vector<std::string> *lines)
+{
+    size_t start = 0;
+    size_t end;
+    while ((end = data->find('\n', start)) != std::string::npos)
+    {
+        size_t len = end - start;
+        while ((len > 0) && ((*data)[start + len - 1] == '\r'))
+        {
+            len--;
+        }
+        if (len > 0)
+        {
+            lines->push_back(data->substr(start, len));
+        }
+        start = end + 1;
+    }
+
+    data->erase(0, start);
+}
+
+// Reads the client messages, one per line after their time
+static bool loadClient(const char *path, std::vector<Step> *messages)
+{
+    FILE *fp = fopen(path, "r");
+    if (fp == nullptr)
+    {
+        fprintf(stderr, "unable to read %s\n", path);
+        return false;
+    }
+
+    bool ok = true;
+    char line[4096];
+    int lineNo = 0;
+    while (fgets(line, sizeof(line), fp) != nullptr)
+    {
+        lineNo++;
+
+        const char *p = line + strspn(line, " \t\r\n");
+        if ((*p == 0) || (*p == '#'))
+        {
+            continue;
+        }
+
+        char *end = nullptr;
+        double secs = (*p == '+') ? strtod(p + 1, &end) : -1;
+        if ((secs < 0) || (end == nullptr) || !isspace((unsigned char)*end))
+        {
+            fprintf(stderr, "%s:%d: expected +<seconds> <INDI message>\n", path, lineNo);
+            ok = false;
+            continue;
+        }
+
+        Step step;
+        step.timeNs = (uint64_t)(secs * 1e9 + 0.5);
+        step.kind = Step::SK_CLIENT;
+        step.data = end + strspn(end, " \t");
+        step.data.erase(step.data.find_last_not_of(" \t\r\n") + 1);
+        if (!messages->empty() && (step.timeNs < messages->back().timeNs))
+        {
+            fprintf(stderr, "%s:%d: time goes backwards\n", path, lineNo);
+            ok = false;
+            continue;
+        }
+        messages->push_back(step);
+    }
+    fclose(fp);
+
+    return ok;
+}
+
+static bool parseArgs(int argc, char *argv[], Options *opts)
+{
+    opts->driver = "indi_rks_c8_focuser";
+    opts->device = "RKS C8 Focuser";
+    opts->speed = 1.0;
+    opts->settleSecs = 2.0;
+    opts->heartbeatSecs = 0;
+    opts->stallSecs = 5.0;
+    opts->client = nullptr;
+    opts->expected = nullptr;
+    opts->timeline = nullptr;
+    opts->capture = nullptr;
+
+    int c;
+    while ((c = getopt(argc, argv, "d:n:s:t:b:w:c:e:o:")) != -1)
+    {
+        switch (c)
+        {
+        case 'd':
+            opts->driver = optarg;
+            break;
+        case 'n':
+            opts->device = optarg;
+            break;
+        case 's':
+            opts->speed = atof(optarg);
+            break;
+        case 't':
+            opts->settleSecs = atof(optarg);
+            break;
+        case 'b':
+            opts->heartbeatSecs = atof(optarg);
+            break;
+        case 'w':
+            opts->stallSecs = atof(optarg);
+            break;
+        case 'c':
+            opts->client = optarg;
+            break;
+        case 'e':
+            opts->expected = optarg;
+            break;
+        case 'o':
+            opts->timeline = optarg;
+            break;
+        default:
+            return false;
+        }
+    }
+
+    if ((optind != argc - 1) || (opts->speed < 0) || (opts->settleSecs < 0) ||
+        (opts->heartbeatSecs < 0) || (opts->stallSecs <= 0))
+    {
+        return false;
+    }
+    opts->capture = argv[optind];
+
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    Options opts;
+    if (!parseArgs(argc, argv, &opts))
+    {
+        fprintf(stderr,
+                "usage: %s [-d driver] [-n device] [-s speed] [-t settle-secs]\n"
+                "       %*s [-b heartbeat-secs] [-w stall-secs] [-c client-file]\n"
+                "       %*s [-e expected-file] [-o timeline-file] capture-file\n",
+                argv[0], (int)strlen(argv[0]), "", (int)strlen(argv[0]), "");
+        return 2;
+    }
+
+    std::vector<TrafficCapture::Chunk> chunks;
+    if (!TrafficCapture::load(opts.capture, &chunks) || chunks.empty())
+    {
+        fprintf(stderr, "%s is not a traffic capture\n", opts.capture);
+        return 2;
+    }
+
+    std::vector<Step> messages;
+    if ((opts.client != nullptr) && !loadClient(opts.client, &messages))
+    {
+        return 2;
+    }
+
+    // Client messages go ahead of the first chunk captured after them
+    std::vector<Step> steps;
+    size_t message = 0;
+    for (size_t i = 0; i < chunks.size(); i++)
+    {
+        while ((message < messages.size()) && (messages[message].timeNs < chunks[i].timeNs))
+        {
+            steps.push_back(messages[message++]);
+        }
+
+        Step step;
+        step.timeNs = chunks[i].timeNs;
+        step.kind = (chunks[i].direction == TrafficCapture::TD_TX) ? Step::SK_COMMAND : Step::SK_REPLY;
+        step.data = chunks[i].data;
+        steps.push_back(step);
+    }
+    steps.insert(steps.end(), messages.begin() + message, messages.end());
+
+    signal(SIGPIPE, SIG_IGN);
+
+    std::string slavePath;
+    int slaveFd = -1;
+    int master = openPty(&slavePath, &slaveFd);
+    if (master == -1)
+    {
+        fprintf(stderr, "unable to open a pty: %s\n", strerror(errno));
+        return 2;
+    }
+
+    char home[] = "/tmp/rks_c8_replay.XXXXXX";
+    if (mkdtemp(home) == nullptr)
+    {
+        fprintf(stderr, "unable to create a scratch directory: %s\n", strerror(errno));
+        return 2;
+    }
+
+    Driver driver;
+    if (!driver.start(opts.driver, home))
+    {
+        fprintf(stderr, "unable to start %s\n", opts.driver);
+        nftw(home, removeEntry, 8, FTW_DEPTH | FTW_PHYS);
+        return 2;
+    }
+
+    // Every captured command in order for the gate, and how many of
+    // them are complete by the end of each step; a partial write
+    // splits a line across chunks
+    std::vector<std::string> commands;
+    std::vector<size_t> commandsThrough(steps.size());
+    std::string captured;
+    for (size_t i = 0; i < steps.size(); i++)
+    {
+        if (steps[i].kind == Step::SK_COMMAND)
+        {
+            captured += steps[i].data;
+            takeLines(&captured, &commands);
+        }
+        commandsThrough[i] = commands.size();
+    }
+
+    char heartbeat[32];
+    snprintf(heartbeat, sizeof(heartbeat), "%g", opts.heartbeatSecs);
+
+    std::string dev(opts.device);
+    driver.send("<getProperties version=\"1.7\"/>\n");
+    driver.send("<newNumberVector device=\"" + dev + "\" name=\"Link Supervisor\">"
+                "<oneNumber name=\"HEARTBEAT\">" + heartbeat + "</oneNumber></newNumberVector>\n");
+    driver.send("<newTextVector device=\"" + dev + "\" name=\"DEVICE_PORT\">"
+                "<oneText name=\"PORT\">" + slavePath + "</oneText></newTextVector>\n");
+    driver.send("<newSwitchVector device=\"" + dev + "\" name=\"CONNECTION\">"
+                "<oneSwitch name=\"CONNECT\">On</oneSwitch>"
+                "<oneSwitch name=\"DISCONNECT\">Off</oneSwitch></newSwitchVector>\n");
+
+    std::vector<Update> timeline;
+    uint64_t startNs = monotonicNs();
+    uint64_t firstNs = steps[0].timeNs;
+    uint64_t settleNs = (uint64_t)(opts.settleSecs * 1e9);
+
+    uint64_t stallNs = (uint64_t)(opts.stallSecs * 1e9);
+
+    size_t next = 0;
+    size_t commandsQueued = 0;
+    size_t commandsSeen = 0;
+    size_t extraLines = 0;
+    std::string sent;
+    uint64_t progressNs = startNs;
+    uint64_t doneNs = 0;
+    uint64_t bytesReplayed = 0;
+    bool stalled = false;
+    bool driverAlive = true;
+
+    while (driverAlive)
+    {
+        // Commands in the capture only move the gate
+        while ((next < steps.size()) && (steps[next].kind == Step::SK_COMMAND))
+        {
+            commandsQueued = commandsThrough[next];
+            next++;
+        }
+
+        uint64_t nowNs = monotonicNs();
+        int timeoutMs = -1;
+
+        if (next < steps.size())
+        {
+            const Step &step = steps[next];
+            uint64_t dueNs = (opts.speed > 0) ? startNs + (uint64_t)((step.timeNs - firstNs) / opts.speed)
+                                              : nowNs;
+
+            bool gated = (commandsSeen < commandsQueued);
+            if (gated && (nowNs - progressNs >= stallNs))
+            {
+                stalled = true;
+                break;
+            }
+
+            if (!gated && (nowNs >= dueNs))
+            {
+                if (step.kind == Step::SK_CLIENT)
+                {
+                    driver.send(step.data + "\n");
+                }
+                else if (write(master, step.data.data(), step.data.size()) != (ssize_t)step.data.size())
+                {
+                    fprintf(stderr, "pty write failed: %s\n", strerror(errno));
+                    break;
+                }
+                else
+                {
+                    bytesReplayed += step.data.size();
+                }
+                progressNs = nowNs;
+                next++;
+                continue;
+            }
+
+            uint64_t waitNs = gated ? progressNs + stallNs - nowNs : dueNs - nowNs;
+            timeoutMs = (int)((waitNs + 999999) / 1000000);
+        }
+        else
+        {
+            if (doneNs == 0)
+            {
+                doneNs = nowNs;
+            }
+            if (nowNs - doneNs >= settleNs)
+            {
+                break;
+            }
+            timeoutMs = (int)((doneNs + settleNs - nowNs + 999999) / 1000000);
+        }
+
+        struct pollfd pfd[2];
+        pfd[0].fd = driver.outFd();
+        pfd[0].events = POLLIN;
+        pfd[1].fd = master;
+        pfd[1].events = POLLIN;
+        if (poll(pfd, 2, timeoutMs) <= 0)
+        {
+            continue;
+        }
+
+        if (pfd[0].revents & (POLLIN | POLLHUP))
+        {
+            driverAlive = driver.readOutput(opts.device, startNs, &timeline);
+        }
+
+        if (pfd[1].revents & POLLIN)
+        {
+            char buf[4096];
+            ssize_t n = read(master, buf, sizeof(buf));
+            if (n > 0)
+            {
+                std::vector<std::string> lines;
+                sent.append(buf, n);
+                takeLines(&sent, &lines);
+                for (size_t i = 0; i < lines.size(); i++)
+                {
+                    if ((commandsSeen < commands.size()) && (lines[i] == commands[commandsSeen]))
+                    {
+                        commandsSeen++;
+                        progressNs = monotonicNs();
+                    }
+                    else
+                    {
+                        extraLines++;
+                    }
+                }
+            }
+        }
+    }
+
+    double elapsed = (monotonicNs() - startNs) / 1e9;
+    driver.stop();
+    close(master);
+    close(slaveFd);
+    nftw(home, removeEntry, 8, FTW_DEPTH | FTW_PHYS);
+
+    FILE *out = stdout;
+    if (opts.timeline != nullptr)
+    {
+        out = fopen(opts.timeline, "w");
+        if (out == nullptr)
+        {
+            fprintf(stderr, "unable to write %s\n", opts.timeline);
+            return 2;
+        }
+    }
+    for (size_t i = 0; i < timeline.size(); i++)
+    {
+        fprintf(out, "+%.3f %s\n", timeline[i].timeNs / 1e9, formatUpdate(timeline[i]).c_str());
+    }
+    if (out != stdout)
+    {
+        fclose(out);
+    }
+
+    fprintf(stderr, "replayed %zu of %zu steps (%llu bytes) in %.2f s, "
+                    "%zu of %zu commands seen, %zu other line%s, %zu property updates\n",
+            next, steps.size(), (unsigned long long)bytesReplayed, elapsed,
+            commandsSeen, commands.size(), extraLines, (extraLines == 1) ? "" : "s",
+            timeline.size());
+
+    if (!driverAlive)
+    {
+        fprintf(stderr, "%s exited during the replay\n", opts.driver);
+        return 2;
+    }
+
+    int status = 0;
+    if (commandsSeen < commands.size())
+    {
+        fprintf(stderr, "%s %s command %zu: %s\n", opts.driver,
+                stalled ? "stalled before" : "never sent", commandsSeen + 1,
+                commands[commandsSeen].c_str());
+        status = 1;
+    }
+
+    if (opts.expected != nullptr)
+    {
+        int missing = checkTimeline(opts.expected, timeline);
+        if (missing != 0)
+        {
+            if (missing < 0)
+            {
+                return 2;
+            }
+            fprintf(stderr, "%d expected update%s not seen\n", missing, (missing == 1) ? "" : "s");
+            status = 1;
+        }
+    }
+
+    return status;
+}